@@ -4,47 +4,18 @@
 #
 #-------------------------------------------------
 
-QT       += core gui
-
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets testlib
+include(worldeditor.pri)
 
 TARGET = WorldEditor
 TEMPLATE = app
 
 
 SOURCES += main.cpp\
-        mainwindow.cpp \
-        tests/alltests.cpp \
-    brush.cpp \
-    tests/brushtests.cpp \
-    viewportscene.cpp \
-    viewportview.cpp \
-    map.cpp \
-    tests/maptests.cpp \
-    polygoniser.cpp \
-    tests/polygontests.cpp \
-    tests/viewporttests.cpp \
-    solids.cpp
+        mainwindow.cpp
 
-HEADERS  += mainwindow.h \
-    tests/alltests.h \
-    brush.h \
-    tests/brushtests.h \
-    viewportscene.h \
-    viewportview.h \
-    map.h \
-    tests/maptests.h \
-    polygoniser.h \
-    tests/polygontests.h \
-    tests/viewporttests.h \
-    solids.h
+HEADERS  += mainwindow.h
 
 FORMS    += mainwindow.ui
 
-CONFIG += testcase
-
 RESOURCES += \
-    icons.qrc \
-    tests/vmfs.qrc
-
-
+    icons.qrc
@@ -0,0 +1,79 @@
+#include <QDateTime>
+#include <QFile>
+#include <QJsonDocument>
+#include <QRegularExpression>
+#include <QThread>
+#include <QXmlStreamReader>
+#include "benchmarkreport.h"
+
+//!
+//! \brief BenchmarkReport::addXml adds every benchmark result of a suite
+//! Rows tagged with a number of solids also get their throughput.
+//! \param suite - Name of the test class
+//! \param xml - What QTest logged with "-o file,xml"
+//! \return 1 for error
+//!
+int BenchmarkReport::addXml(const QString &suite, QIODevice *xml) {
+    static const QRegularExpression solidsTag("(\\d+) solids");
+    QXmlStreamReader reader(xml);
+    QString function;
+    while(!reader.atEnd()) {
+        if(reader.readNext() != QXmlStreamReader::StartElement)
+            continue;
+        QXmlStreamAttributes attributes = reader.attributes();
+        if(reader.name() == QLatin1String("TestFunction")) {
+            function = attributes.value("name").toString();
+        }
+        else if(reader.name() == QLatin1String("BenchmarkResult")) {
+            QJsonObject result;
+            result["suite"] = suite;
+            result["benchmark"] = function;
+            result["tag"] = attributes.value("tag").toString();
+            result["metric"] = attributes.value("metric").toString();
+            const double value = attributes.value("value").toDouble();
+            result["value"] = value;
+            result["iterations"] = attributes.value("iterations").toInt();
+
+            QRegularExpressionMatch match = solidsTag.match(attributes.value("tag").toString());
+            if(match.hasMatch() && value > 0
+                    && attributes.value("metric") == QLatin1String("WalltimeMilliseconds"))
+                result["solidsPerSecond"] = match.captured(1).toDouble() * 1000 / value;
+            m_results.append(result);
+        }
+    }
+    if(reader.hasError())
+        return 1;
+    return 0;
+}
+//!
+//! \brief BenchmarkReport::count
+//! \return
+//!
+int BenchmarkReport::count() const {
+    return m_results.count();
+}
+//!
+//! \brief BenchmarkReport::toJson
+//! \return {"date", "qtVersion", "cores", "results": [{"suite", "benchmark", "tag", "metric", "value", ...}]}
+//!
+QJsonObject BenchmarkReport::toJson() const {
+    QJsonObject json;
+    json["date"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    json["qtVersion"] = QString(qVersion());
+    json["cores"] = QThread::idealThreadCount();
+    json["results"] = m_results;
+    return json;
+}
+//!
+//! \brief BenchmarkReport::writeFile
+//! \param fileName
+//! \return 1 for error
+//!
+int BenchmarkReport::writeFile(const QString &fileName) const {
+    QFile file(fileName);
+    if(!file.open(QFile::WriteOnly | QFile::Truncate))
+        return 1;
+    if(file.write(QJsonDocument(toJson()).toJson()) < 0)
+        return 1;
+    return 0;
+}
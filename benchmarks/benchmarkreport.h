@@ -0,0 +1,24 @@
+#ifndef BENCHMARKREPORT_H
+#define BENCHMARKREPORT_H
+
+#include <QIODevice>
+#include <QJsonArray>
+#include <QJsonObject>
+
+//!
+//! \brief The BenchmarkReport class gathers the results of QBENCHMARK runs into JSON
+//! QTest only writes its own formats, so the suites log XML and the
+//! BenchmarkResult elements are read back from it.
+//!
+class BenchmarkReport
+{
+    QJsonArray m_results;
+
+public:
+    int addXml(const QString &suite, QIODevice *xml);
+    int count() const;
+    QJsonObject toJson() const;
+    int writeFile(const QString &fileName) const;
+};
+
+#endif // BENCHMARKREPORT_H
@@ -0,0 +1,32 @@
+#-------------------------------------------------
+#
+# Benchmarks of the hot paths, results written
+# as JSON for tracking over time
+#
+#-------------------------------------------------
+
+include(../worldeditor.pri)
+
+QT       += testlib
+
+TARGET = WorldEditorBenchmarks
+TEMPLATE = app
+
+SOURCES += main.cpp \
+    vmfgenerator.cpp \
+    benchmarkreport.cpp \
+    brushbenchmarks.cpp \
+    mapbenchmarks.cpp \
+    scenebenchmarks.cpp \
+    jobsystembenchmarks.cpp \
+    rendererbenchmarks.cpp \
+    tracebenchmarks.cpp
+
+HEADERS += vmfgenerator.h \
+    benchmarkreport.h \
+    brushbenchmarks.h \
+    mapbenchmarks.h \
+    scenebenchmarks.h \
+    jobsystembenchmarks.h \
+    rendererbenchmarks.h \
+    tracebenchmarks.h
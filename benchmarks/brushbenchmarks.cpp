@@ -0,0 +1,143 @@
+#include "brushbenchmarks.h"
+#include "polygoniser.h"
+#include "vmfgenerator.h"
+
+//!
+//! \brief sidesRows adds a row for each brush complexity, tagged like "8 sides"
+//!
+static void sidesRows() {
+    QTest::addColumn<int>("sides");
+    foreach(int sides, QList<int>() << 4 << 6 << 8 << 16 << 32 << 64)
+        QTest::newRow(qPrintable(QString("%1 sides").arg(sides))) << sides;
+}
+
+//!
+//! \brief BrushBenchmarks::testGeneratedBrushes every generated brush is closed, with a face per plane
+//!
+void BrushBenchmarks::testGeneratedBrushes() {
+    for(int sides = 4; sides <= 64; sides++) {
+        Brush brush = VmfGenerator::brush(sides);
+        QCOMPARE(brush.getNumOfSides(), sides);
+        QCOMPARE(brush.getWindings().count(), sides);
+    }
+}
+//!
+//! \brief BrushBenchmarks::benchmarkBoundingBox_data
+//!
+void BrushBenchmarks::benchmarkBoundingBox_data() {
+    sidesRows();
+}
+//!
+//! \brief BrushBenchmarks::benchmarkBoundingBox every bounding box getter in the three 2D views
+//!
+void BrushBenchmarks::benchmarkBoundingBox() {
+    QFETCH(int, sides);
+    Brush brush = VmfGenerator::brush(sides);
+    const axis views[3][2] = {{Y_AXIS, Z_AXIS}, {X_AXIS, Z_AXIS}, {X_AXIS, Y_AXIS}};
+    QVector2D sum;
+    QBENCHMARK {
+        for(int v = 0; v < 3; v++) {
+            axis primary = views[v][0];
+            axis secondary = views[v][1];
+            sum += brush.getTopLeft(primary, secondary) + brush.getTopRight(primary, secondary)
+                    + brush.getBottomLeft(primary, secondary) + brush.getBottomRight(primary, secondary)
+                    + brush.getTop(primary, secondary) + brush.getBottom(primary, secondary)
+                    + brush.getLeft(primary, secondary) + brush.getRight(primary, secondary)
+                    + brush.getCenter(primary, secondary);
+        }
+    }
+    QVERIFY(!qIsNaN(sum.x()));
+}
+//!
+//! \brief BrushBenchmarks::benchmarkTranslate_data
+//!
+void BrushBenchmarks::benchmarkTranslate_data() {
+    sidesRows();
+}
+//!
+//! \brief BrushBenchmarks::benchmarkTranslate moves the brush back and forth
+//!
+void BrushBenchmarks::benchmarkTranslate() {
+    QFETCH(int, sides);
+    Brush brush = VmfGenerator::brush(sides);
+    float step = 16;
+    QBENCHMARK {
+        brush.translate(X_AXIS, Y_AXIS, QVector2D(step, step));
+        step = -step;
+    }
+}
+//!
+//! \brief BrushBenchmarks::benchmarkRotate_data
+//!
+void BrushBenchmarks::benchmarkRotate_data() {
+    sidesRows();
+}
+//!
+//! \brief BrushBenchmarks::benchmarkRotate turns the brush a quarter at a time
+//!
+void BrushBenchmarks::benchmarkRotate() {
+    QFETCH(int, sides);
+    Brush brush = VmfGenerator::brush(sides);
+    QBENCHMARK {
+        brush.rotate(X_AXIS, Y_AXIS, 90);
+    }
+}
+//!
+//! \brief BrushBenchmarks::benchmarkScale_data
+//!
+void BrushBenchmarks::benchmarkScale_data() {
+    sidesRows();
+}
+//!
+//! \brief BrushBenchmarks::benchmarkScale doubles and halves the brush in turn
+//!
+void BrushBenchmarks::benchmarkScale() {
+    QFETCH(int, sides);
+    Brush brush = VmfGenerator::brush(sides);
+    float factor = 2;
+    QBENCHMARK {
+        brush.scale(X_AXIS, Y_AXIS, QVector2D(factor, factor));
+        factor = 1 / factor;
+    }
+}
+//!
+//! \brief BrushBenchmarks::benchmarkPoligonise_data
+//!
+void BrushBenchmarks::benchmarkPoligonise_data() {
+    sidesRows();
+}
+//!
+//! \brief BrushBenchmarks::benchmarkPoligonise projects a brush into a 2D view
+//! The brush is invalidated each time, so its windings are worked out again as well.
+//!
+void BrushBenchmarks::benchmarkPoligonise() {
+    QFETCH(int, sides);
+    Brush brush = VmfGenerator::brush(sides);
+    int polygons = 0;
+    QBENCHMARK {
+        brush.invalidate();
+        polygons += Polygoniser::poligonise(&brush, X_AXIS, Y_AXIS).count();
+    }
+    QVERIFY(polygons > 0);
+}
+//!
+//! \brief BrushBenchmarks::benchmarkScratchPoligonise_data
+//!
+void BrushBenchmarks::benchmarkScratchPoligonise_data() {
+    sidesRows();
+}
+//!
+//! \brief BrushBenchmarks::benchmarkScratchPoligonise projects a brush with reused buffers
+//! Compare with benchmarkPoligonise, once warmed up nothing is allocated.
+//!
+void BrushBenchmarks::benchmarkScratchPoligonise() {
+    QFETCH(int, sides);
+    Brush brush = VmfGenerator::brush(sides);
+    PolygoniserScratch scratch;
+    PolygonArena arena;
+    QBENCHMARK {
+        arena.clear();
+        Polygoniser::poligonise(&brush, X_AXIS, Y_AXIS, &scratch, &arena);
+    }
+    QCOMPARE(arena.polygonCount(), sides);
+}
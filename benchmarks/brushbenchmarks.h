@@ -0,0 +1,31 @@
+#ifndef BRUSHBENCHMARKS_H
+#define BRUSHBENCHMARKS_H
+
+#include <QObject>
+#include <QTest>
+
+#include "brush.h"
+
+class BrushBenchmarks : public QObject
+{
+    Q_OBJECT
+private slots:
+    void testGeneratedBrushes();
+
+    // Benchmarks
+    void benchmarkBoundingBox_data();
+    void benchmarkBoundingBox();
+    void benchmarkTranslate_data();
+    void benchmarkTranslate();
+    void benchmarkRotate_data();
+    void benchmarkRotate();
+    void benchmarkScale_data();
+    void benchmarkScale();
+    void benchmarkPoligonise_data();
+    void benchmarkPoligonise();
+    void benchmarkScratchPoligonise_data();
+    void benchmarkScratchPoligonise();
+
+};
+
+#endif // BRUSHBENCHMARKS_H
@@ -0,0 +1,64 @@
+#include "jobsystembenchmarks.h"
+#include <QtConcurrent>
+
+//! Jobs submitted by the empty jobs benchmark
+#define BENCHMARK_JOBS 10000
+//! Indexes visited by the parallel for benchmarks
+#define BENCHMARK_INDEXES 1000000
+
+//!
+//! \brief work a few hundred cycles of arithmetic the compiler can't drop
+//! \param i
+//! \return
+//!
+static float work(int i) {
+    float x = float(i);
+    for(int k = 0; k < 64; k++)
+        x = x * 0.999f + 1.0f;
+    return x;
+}
+
+//!
+//! \brief JobSystemBenchmarks::benchmarkEmptyJobs what submitting and running a job costs
+//!
+void JobSystemBenchmarks::benchmarkEmptyJobs() {
+    JobSystem *jobs = JobSystem::global();
+    QVector<JobHandle> handles;
+    handles.reserve(BENCHMARK_JOBS);
+    QBENCHMARK {
+        handles.clear();
+        for(int i = 0; i < BENCHMARK_JOBS; i++)
+            handles.append(jobs->run([]() {}));
+        jobs->wait(handles);
+    }
+}
+//!
+//! \brief JobSystemBenchmarks::benchmarkParallelFor
+//! Compare with benchmarkParallelForConcurrent, it does the same on QtConcurrent.
+//!
+void JobSystemBenchmarks::benchmarkParallelFor() {
+    QVector<float> results(BENCHMARK_INDEXES);
+    float *data = results.data();
+    QBENCHMARK {
+        JobSystem::global()->parallelFor(0, BENCHMARK_INDEXES, [data](int i) {
+            data[i] = work(i);
+        });
+    }
+    QCOMPARE(results.at(10), work(10));
+}
+//!
+//! \brief JobSystemBenchmarks::benchmarkParallelForConcurrent the baseline for benchmarkParallelFor
+//!
+void JobSystemBenchmarks::benchmarkParallelForConcurrent() {
+    QVector<float> results(BENCHMARK_INDEXES);
+    float *data = results.data();
+    QVector<int> indexes(BENCHMARK_INDEXES);
+    for(int i = 0; i < indexes.size(); i++)
+        indexes[i] = i;
+    QBENCHMARK {
+        QtConcurrent::blockingMap(indexes, [data](int &i) {
+            data[i] = work(i);
+        });
+    }
+    QCOMPARE(results.at(10), work(10));
+}
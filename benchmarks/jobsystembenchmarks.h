@@ -0,0 +1,20 @@
+#ifndef JOBSYSTEMBENCHMARKS_H
+#define JOBSYSTEMBENCHMARKS_H
+
+#include <QObject>
+#include <QTest>
+
+#include "jobsystem.h"
+
+class JobSystemBenchmarks : public QObject
+{
+    Q_OBJECT
+private slots:
+    // Benchmarks
+    void benchmarkEmptyJobs();
+    void benchmarkParallelFor();
+    void benchmarkParallelForConcurrent();
+
+};
+
+#endif // JOBSYSTEMBENCHMARKS_H
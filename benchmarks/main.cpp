@@ -0,0 +1,57 @@
+#include <QApplication>
+#include <QFile>
+#include <QTemporaryDir>
+#include "benchmarkreport.h"
+#include "brushbenchmarks.h"
+#include "mapbenchmarks.h"
+#include "scenebenchmarks.h"
+#include "jobsystembenchmarks.h"
+#include "rendererbenchmarks.h"
+#include "tracebenchmarks.h"
+
+//!
+//! \brief main runs every benchmark suite and writes the results as JSON
+//! Usage: WorldEditorBenchmarks [results.json], benchmarks.json by default.
+//! WORLDEDITOR_BENCHMARK_SOLIDS sets the largest map, up to 1000000.
+//! \return 0 when every suite passed
+//!
+int main(int argc, char *argv[])
+{
+    QApplication a(argc, argv);
+    const QStringList arguments = a.arguments();
+    const QString output = arguments.size() > 1 ? arguments.at(1) : QString("benchmarks.json");
+
+    QTemporaryDir dir;
+    if(!dir.isValid())
+        return 1;
+
+    BrushBenchmarks brushes;
+    MapBenchmarks maps;
+    SceneBenchmarks scenes;
+    JobSystemBenchmarks jobs;
+    RendererBenchmarks renderer;
+    TraceBenchmarks trace;
+    QList<QObject *> suites;
+    suites << &brushes << &maps << &scenes << &jobs << &renderer << &trace;
+
+    int failures = 0;
+    BenchmarkReport report;
+    foreach(QObject *suite, suites) {
+        const QString name = suite->metaObject()->className();
+        const QString xml = dir.path() + "/" + name + ".xml";
+        failures += QTest::qExec(suite, QStringList() << arguments.first()
+                                 << "-o" << xml + ",xml" << "-o" << "-,txt");
+        QFile file(xml);
+        if(!file.open(QFile::ReadOnly) || report.addXml(name, &file)) {
+            qWarning("Could not read the results of %s", qPrintable(name));
+            failures++;
+        }
+    }
+
+    if(report.writeFile(output)) {
+        qWarning("Could not write %s", qPrintable(output));
+        return 1;
+    }
+    qDebug("%d results written to %s", report.count(), qPrintable(output));
+    return failures != 0;
+}
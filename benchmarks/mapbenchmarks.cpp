@@ -0,0 +1,85 @@
+#include "mapbenchmarks.h"
+#include <QBuffer>
+#include <QFile>
+#include <QTemporaryDir>
+#include "vmfgenerator.h"
+
+//!
+//! \brief sizeRows adds a row for each map size, tagged like "1000 solids"
+//!
+static void sizeRows() {
+    QTest::addColumn<int>("solids");
+    foreach(int size, VmfGenerator::mapSizes())
+        QTest::newRow(qPrintable(QString("%1 solids").arg(size))) << size;
+}
+
+//!
+//! \brief MapBenchmarks::testGeneratedMap the generator writes what it lays out, and the same every time
+//!
+void MapBenchmarks::testGeneratedMap() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString fileName = dir.path() + "/generated.vmf";
+    QVERIFY(!VmfGenerator(7).writeFile(fileName, 200));
+
+    Map map;
+    QVERIFY(!map.readVMF(fileName));
+    QCOMPARE(map.m_solids.rowCount(), 200);
+    QList<Brush> brushes = VmfGenerator(7).brushes(200);
+    for(int i = 0; i < 200; i += 37) {
+        QCOMPARE(map.m_solids.brush(i).getNumOfSides(), brushes.at(i).getNumOfSides());
+        QVERIFY(!map.m_solids.polygons(i, X_AXIS, Y_AXIS).isEmpty());
+    }
+
+    QFile first(fileName);
+    QVERIFY(first.open(QFile::ReadOnly));
+    QByteArray again;
+    QBuffer buffer(&again);
+    buffer.open(QBuffer::WriteOnly);
+    QVERIFY(!VmfGenerator(7).write(&buffer, 200));
+    QCOMPARE(first.readAll(), again);
+}
+//!
+//! \brief MapBenchmarks::benchmarkReadVMF_data
+//!
+void MapBenchmarks::benchmarkReadVMF_data() {
+    sizeRows();
+}
+//!
+//! \brief MapBenchmarks::benchmarkReadVMF reading a whole file, polygonising included
+//!
+void MapBenchmarks::benchmarkReadVMF() {
+    QFETCH(int, solids);
+    QTemporaryDir dir;
+    QString fileName = dir.path() + "/generated.vmf";
+    QVERIFY(!VmfGenerator().writeFile(fileName, solids));
+
+    QBENCHMARK {
+        Map map;
+        map.readVMF(fileName);
+    }
+}
+//!
+//! \brief MapBenchmarks::benchmarkAddSolids_data
+//!
+void MapBenchmarks::benchmarkAddSolids_data() {
+    sizeRows();
+}
+//!
+//! \brief MapBenchmarks::benchmarkAddSolids inserting a batch of new brushes into Solids
+//! Brushes cache their windings, so each run inserts clones nobody has polygonised.
+//!
+void MapBenchmarks::benchmarkAddSolids() {
+    QFETCH(int, solids);
+    QList<Brush> brushes = VmfGenerator().brushes(solids);
+    QList<Brush> clones;
+    clones.reserve(brushes.count());
+    foreach(const Brush &brush, brushes)
+        clones.append(brush.clone());
+
+    Solids model;
+    QBENCHMARK_ONCE {
+        model.addSolids(clones);
+    }
+    QCOMPARE(model.rowCount(), solids);
+}
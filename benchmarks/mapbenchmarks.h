@@ -0,0 +1,23 @@
+#ifndef MAPBENCHMARKS_H
+#define MAPBENCHMARKS_H
+
+#include <QObject>
+#include <QTest>
+
+#include "map.h"
+
+class MapBenchmarks : public QObject
+{
+    Q_OBJECT
+private slots:
+    void testGeneratedMap();
+
+    // Benchmarks
+    void benchmarkReadVMF_data();
+    void benchmarkReadVMF();
+    void benchmarkAddSolids_data();
+    void benchmarkAddSolids();
+
+};
+
+#endif // MAPBENCHMARKS_H
@@ -0,0 +1,38 @@
+#include "rendererbenchmarks.h"
+#include "vmfgenerator.h"
+
+//! Size of the frame the 3D view is drawn into
+#define RENDER_WIDTH 1920
+#define RENDER_HEIGHT 1080
+
+//!
+//! \brief RendererBenchmarks::benchmarkRender_data
+//!
+void RendererBenchmarks::benchmarkRender_data() {
+    QTest::addColumn<int>("solids");
+    foreach(int size, VmfGenerator::mapSizes())
+        QTest::newRow(qPrintable(QString("%1 solids").arg(size))) << size;
+}
+//!
+//! \brief RendererBenchmarks::benchmarkRender draws the whole map at 1080p
+//! The camera stands back from the front of the map, looking at its middle.
+//!
+void RendererBenchmarks::benchmarkRender() {
+    QFETCH(int, solids);
+    VmfGenerator generator;
+    float extent = 0;
+    foreach(const GeneratedSolid &solid, generator.solids(solids))
+        extent = qMax(extent, solid.centre.length());
+
+    SoftwareRenderer renderer;
+    renderer.setMesh(SoftwareRenderer::buildMesh(generator.brushes(solids)));
+    QVERIFY(renderer.mesh().triangleCount() > 0);
+
+    QImage frame(RENDER_WIDTH, RENDER_HEIGHT, QImage::Format_RGB32);
+    QMatrix4x4 camera = SoftwareRenderer::cameraMatrix(QVector3D(0, -2 * extent, extent),
+                                                       QVector3D(0, 0, 0),
+                                                       float(RENDER_WIDTH) / RENDER_HEIGHT);
+    QBENCHMARK {
+        renderer.render(&frame, camera, qRgb(0, 0, 0));
+    }
+}
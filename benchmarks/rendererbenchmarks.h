@@ -0,0 +1,19 @@
+#ifndef RENDERERBENCHMARKS_H
+#define RENDERERBENCHMARKS_H
+
+#include <QObject>
+#include <QTest>
+
+#include "softwarerenderer.h"
+
+class RendererBenchmarks : public QObject
+{
+    Q_OBJECT
+private slots:
+    // Benchmarks
+    void benchmarkRender_data();
+    void benchmarkRender();
+
+};
+
+#endif // RENDERERBENCHMARKS_H
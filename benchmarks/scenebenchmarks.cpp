@@ -0,0 +1,84 @@
+#include "scenebenchmarks.h"
+#include <QPainter>
+#include "vmfgenerator.h"
+
+//! Size of the image the paint benchmark draws into
+#define PAINT_WIDTH 1280
+#define PAINT_HEIGHT 720
+
+//!
+//! \brief SceneBenchmarks::benchmarkAddBrushes_data
+//!
+void SceneBenchmarks::benchmarkAddBrushes_data() {
+    QTest::addColumn<int>("solids");
+    foreach(int size, VmfGenerator::mapSizes())
+        QTest::newRow(qPrintable(QString("%1 solids").arg(size))) << size;
+}
+//!
+//! \brief SceneBenchmarks::benchmarkAddBrushes a new scene taking in every brush of a map
+//! The rows go through addRows, like they do from ViewPortScene::addBrush.
+//!
+void SceneBenchmarks::benchmarkAddBrushes() {
+    QFETCH(int, solids);
+    Map map;
+    map.m_solids.addSolids(VmfGenerator().brushes(solids));
+
+    QBENCHMARK {
+        ViewPortScene scene(&map, X_AXIS, Y_AXIS);
+        QCOMPARE(scene.brushLayer()->brushCount(), solids);
+    }
+}
+//!
+//! \brief SceneBenchmarks::benchmarkPaint_data
+//!
+void SceneBenchmarks::benchmarkPaint_data() {
+    QTest::addColumn<int>("solids");
+    QTest::addColumn<int>("mode");
+    foreach(int size, VmfGenerator::mapSizes()) {
+        QTest::newRow(qPrintable(QString("%1 solids direct").arg(size))) << size << int(DIRECT_RENDER);
+        QTest::newRow(qPrintable(QString("%1 solids tiled").arg(size))) << size << int(TILED_RENDER);
+    }
+}
+//!
+//! \brief SceneBenchmarks::benchmarkPaint a frame of the whole map, grid and brushes
+//!
+void SceneBenchmarks::benchmarkPaint() {
+    QFETCH(int, solids);
+    QFETCH(int, mode);
+    Map map;
+    map.m_solids.addSolids(VmfGenerator().brushes(solids));
+    ViewPortScene scene(&map, X_AXIS, Y_AXIS);
+    scene.setRenderMode(RENDER_MODE(mode));
+
+    QImage image(PAINT_WIDTH, PAINT_HEIGHT, QImage::Format_ARGB32_Premultiplied);
+    QRectF source = scene.brushLayer()->boundingRect();
+    QBENCHMARK {
+        QPainter painter(&image);
+        scene.render(&painter, QRectF(image.rect()), source);
+    }
+}
+//!
+//! \brief SceneBenchmarks::benchmarkZoom_data
+//!
+void SceneBenchmarks::benchmarkZoom_data() {
+    QTest::addColumn<int>("solids");
+    foreach(int size, VmfGenerator::mapSizes())
+        QTest::newRow(qPrintable(QString("%1 solids").arg(size))) << size;
+}
+//!
+//! \brief SceneBenchmarks::benchmarkZoom zooms a scene in and out
+//! The cost of a zoom step must not depend on the number of brushes.
+//!
+void SceneBenchmarks::benchmarkZoom() {
+    QFETCH(int, solids);
+    Map map;
+    map.m_solids.addSolids(VmfGenerator().brushes(solids));
+    ViewPortScene scene(&map, X_AXIS, Y_AXIS);
+    QCOMPARE(scene.brushLayer()->brushCount(), solids);
+
+    qreal scale = 8;
+    QBENCHMARK {
+        scale = (scale > 1000) ? 8 : scale * 1.2;
+        scene.setScale(scale);
+    }
+}
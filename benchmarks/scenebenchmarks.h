@@ -0,0 +1,24 @@
+#ifndef SCENEBENCHMARKS_H
+#define SCENEBENCHMARKS_H
+
+#include <QObject>
+#include <QTest>
+
+#include "map.h"
+#include "viewportscene.h"
+
+class SceneBenchmarks : public QObject
+{
+    Q_OBJECT
+private slots:
+    // Benchmarks
+    void benchmarkAddBrushes_data();
+    void benchmarkAddBrushes();
+    void benchmarkPaint_data();
+    void benchmarkPaint();
+    void benchmarkZoom_data();
+    void benchmarkZoom();
+
+};
+
+#endif // SCENEBENCHMARKS_H
@@ -0,0 +1,32 @@
+#include "tracebenchmarks.h"
+
+//! Scopes entered by the scope benchmark
+#define BENCHMARK_SCOPES 100000
+
+//!
+//! \brief TraceBenchmarks::cleanup leaves nothing recording for the other suites
+//!
+void TraceBenchmarks::cleanup() {
+    Trace::setEnabled(false);
+    Trace::clear();
+}
+//!
+//! \brief TraceBenchmarks::benchmarkScope_data
+//!
+void TraceBenchmarks::benchmarkScope_data() {
+    QTest::addColumn<bool>("enabled");
+    QTest::newRow("disabled") << false;
+    QTest::newRow("enabled") << true;
+}
+//!
+//! \brief TraceBenchmarks::benchmarkScope what a scope costs, recording or not
+//!
+void TraceBenchmarks::benchmarkScope() {
+    QFETCH(bool, enabled);
+    Trace::setEnabled(enabled);
+    QBENCHMARK {
+        for(int i = 0; i < BENCHMARK_SCOPES; i++) {
+            TRACE_SCOPE(JOBS, "scope");
+        }
+    }
+}
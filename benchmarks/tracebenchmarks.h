@@ -0,0 +1,21 @@
+#ifndef TRACEBENCHMARKS_H
+#define TRACEBENCHMARKS_H
+
+#include <QObject>
+#include <QTest>
+
+#include "trace.h"
+
+class TraceBenchmarks : public QObject
+{
+    Q_OBJECT
+private slots:
+    void cleanup();
+
+    // Benchmarks
+    void benchmarkScope_data();
+    void benchmarkScope();
+
+};
+
+#endif // TRACEBENCHMARKS_H
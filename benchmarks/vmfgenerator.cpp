@@ -0,0 +1,213 @@
+#include <QFile>
+#include <QTextStream>
+#include <QtMath>
+#include "vmfgenerator.h"
+
+//! Size of the cell each solid gets
+#define CELL_UNITS 256
+//! Share of the solids that are boxes, in percent
+#define BOX_PERCENT 70
+//! Largest map the benchmarks run at unless WORLDEDITOR_BENCHMARK_SOLIDS says otherwise
+#define DEFAULT_MAX_SOLIDS 10000
+
+//!
+//! \brief nextRandom a linear congruential generator, the same on every platform
+//! \param state
+//! \return 31 random bits
+//!
+static quint32 nextRandom(quint32 *state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 1;
+}
+//!
+//! \brief point writes a point the way a vmf does, to a hundredth of a unit
+//! \param v
+//! \return like "(-64 32.5 128)"
+//!
+static QString point(const QVector3D &v) {
+    return QString("(%1 %2 %3)")
+            .arg(qRound(v.x() * 100) / 100.0)
+            .arg(qRound(v.y() * 100) / 100.0)
+            .arg(qRound(v.z() * 100) / 100.0);
+}
+
+//!
+//! \brief VmfGenerator::VmfGenerator
+//! \param seed
+//!
+VmfGenerator::VmfGenerator(quint32 seed)
+    : m_seed(seed)
+{
+}
+//!
+//! \brief VmfGenerator::solids lays out the solids of a map
+//! \param count
+//! \return
+//!
+QVector<GeneratedSolid> VmfGenerator::solids(int count) const {
+    QVector<GeneratedSolid> result;
+    result.reserve(count);
+    quint32 state = m_seed;
+    const int side = qMax(1, qCeil(qPow(count, 1.0 / 3.0)));
+    const float half = side * CELL_UNITS / 2.0f;
+    for(int i = 0; i < count; i++) {
+        GeneratedSolid solid;
+        solid.centre = QVector3D((i % side) * CELL_UNITS - half + CELL_UNITS / 2,
+                                 (i / side % side) * CELL_UNITS - half + CELL_UNITS / 2,
+                                 (i / side / side) * CELL_UNITS - half);
+        solid.radius = 32 + nextRandom(&state) % 80;
+        solid.height = 32 + nextRandom(&state) % 192;
+        if(int(nextRandom(&state) % 100) < BOX_PERCENT)
+            solid.sides = 6;
+        else
+            solid.sides = 4 + nextRandom(&state) % 61;
+        result.append(solid);
+    }
+    return result;
+}
+//!
+//! \brief VmfGenerator::planePoints the three points of every plane, like the sides of a vmf solid
+//! The corners go anticlockwise from above. Sides run from one corner back
+//! to the previous, the top clockwise and the bottom anticlockwise.
+//! \param solid
+//! \return three points per plane
+//!
+QVector<QVector3D> VmfGenerator::planePoints(const GeneratedSolid &solid) {
+    const bool pyramid = solid.sides == 4;
+    const int corners = pyramid ? 3 : solid.sides - 2;
+    const float bottom = solid.centre.z();
+    const float top = bottom + solid.height;
+    QVector<QVector3D> base;
+    // Half a step round, so a box is lined up with the axes
+    for(int i = 0; i < corners; i++) {
+        float angle = 2 * M_PI * (i + 0.5f) / corners;
+        base.append(QVector3D(solid.centre.x() + solid.radius * qCos(angle),
+                              solid.centre.y() + solid.radius * qSin(angle), bottom));
+    }
+    const QVector3D up(0, 0, solid.height);
+    const QVector3D apex(solid.centre.x(), solid.centre.y(), top);
+
+    QVector<QVector3D> points;
+    points << base.at(0) << base.at(1) << base.at(2);
+    if(!pyramid)
+        points << base.at(2) + up << base.at(1) + up << base.at(0) + up;
+    for(int i = 0; i < corners; i++) {
+        const QVector3D &from = base.at((i + 1) % corners);
+        const QVector3D &to = base.at(i);
+        points << from << to << (pyramid ? apex : to + up);
+    }
+    return points;
+}
+//!
+//! \brief VmfGenerator::brush
+//! \param solid
+//! \return the solid as a brush, as if it was read from a file
+//!
+Brush VmfGenerator::brush(const GeneratedSolid &solid) {
+    QVector<QVector3D> points = planePoints(solid);
+    QList<Plane*> planes;
+    for(int i = 0; i + 2 < points.size(); i += 3)
+        planes.append(new Plane(points.at(i), points.at(i + 1), points.at(i + 2)));
+    return Brush(planes);
+}
+//!
+//! \brief VmfGenerator::brush
+//! \param sides - 4 to 64
+//! \return a brush at the origin with that many planes
+//!
+Brush VmfGenerator::brush(int sides) {
+    GeneratedSolid solid;
+    solid.centre = QVector3D(0, 0, 0);
+    solid.radius = 256;
+    solid.height = 128;
+    solid.sides = sides;
+    return brush(solid);
+}
+//!
+//! \brief VmfGenerator::brushes
+//! \param count
+//! \return the brushes of a map of count solids
+//!
+QList<Brush> VmfGenerator::brushes(int count) const {
+    QList<Brush> result;
+    result.reserve(count);
+    foreach(const GeneratedSolid &solid, solids(count))
+        result.append(brush(solid));
+    return result;
+}
+//!
+//! \brief VmfGenerator::write writes a map of count solids in the world
+//! \param device - Open for writing
+//! \param count
+//! \return 1 for error
+//!
+int VmfGenerator::write(QIODevice *device, int count) const {
+    QTextStream out(device);
+    out << "versioninfo\n{\n"
+           "\t\"editorversion\" \"400\"\n"
+           "\t\"editorbuild\" \"7152\"\n"
+           "\t\"mapversion\" \"1\"\n"
+           "\t\"formatversion\" \"100\"\n"
+           "\t\"prefab\" \"0\"\n"
+           "}\n"
+           "world\n{\n"
+           "\t\"id\" \"1\"\n"
+           "\t\"mapversion\" \"1\"\n"
+           "\t\"classname\" \"worldspawn\"\n";
+
+    int id = 2;
+    foreach(const GeneratedSolid &solid, solids(count)) {
+        out << "\tsolid\n\t{\n\t\t\"id\" \"" << id++ << "\"\n";
+        QVector<QVector3D> points = planePoints(solid);
+        for(int i = 0; i + 2 < points.size(); i += 3) {
+            out << "\t\tside\n\t\t{\n"
+                << "\t\t\t\"id\" \"" << id++ << "\"\n"
+                << "\t\t\t\"plane\" \"" << point(points.at(i)) << " " << point(points.at(i + 1))
+                << " " << point(points.at(i + 2)) << "\"\n"
+                << "\t\t\t\"material\" \"DEV/DEV_MEASUREGENERIC01\"\n"
+                   "\t\t\t\"uaxis\" \"[1 0 0 0] 0.25\"\n"
+                   "\t\t\t\"vaxis\" \"[0 -1 0 0] 0.25\"\n"
+                   "\t\t\t\"rotation\" \"0\"\n"
+                   "\t\t\t\"lightmapscale\" \"16\"\n"
+                   "\t\t\t\"smoothing_groups\" \"0\"\n"
+                   "\t\t}\n";
+        }
+        out << "\t\teditor\n\t\t{\n"
+               "\t\t\t\"color\" \"0 180 225\"\n"
+               "\t\t\t\"visgroupshown\" \"1\"\n"
+               "\t\t\t\"visgroupautoshown\" \"1\"\n"
+               "\t\t}\n"
+               "\t}\n";
+    }
+    out << "}\n";
+    out.flush();
+    if(out.status() != QTextStream::Ok)
+        return 1;
+    return 0;
+}
+//!
+//! \brief VmfGenerator::writeFile
+//! \param fileName
+//! \param count
+//! \return 1 for error
+//!
+int VmfGenerator::writeFile(const QString &fileName, int count) const {
+    QFile file(fileName);
+    if(!file.open(QFile::WriteOnly | QFile::Truncate))
+        return 1;
+    return write(&file, count);
+}
+//!
+//! \brief VmfGenerator::mapSizes
+//! \return 1k, 10k, 100k and 1M solids, up to WORLDEDITOR_BENCHMARK_SOLIDS (10k by default)
+//!
+QList<int> VmfGenerator::mapSizes() {
+    bool ok;
+    int max = qgetenv("WORLDEDITOR_BENCHMARK_SOLIDS").toInt(&ok);
+    if(!ok)
+        max = DEFAULT_MAX_SOLIDS;
+    QList<int> sizes;
+    for(int size = 1000; size <= qMin(max, 1000000); size *= 10)
+        sizes.append(size);
+    return sizes;
+}
@@ -0,0 +1,45 @@
+#ifndef VMFGENERATOR_H
+#define VMFGENERATOR_H
+
+#include <QIODevice>
+#include <QList>
+#include <QVector>
+#include <QVector3D>
+#include "brush.h"
+
+//!
+//! \brief The GeneratedSolid struct is the shape of one generated brush
+//! Prisms standing on the XY plane, or a pyramid for 4 sides.
+//!
+struct GeneratedSolid
+{
+    QVector3D centre;   //! Middle of the bottom face
+    float radius;       //! Of the circle the corners of the bottom face are on
+    float height;
+    int sides;          //! Planes, 4 to 64
+};
+
+//!
+//! \brief The VmfGenerator class makes synthetic maps for the benchmarks
+//! The same seed always gives the same map. Solids sit in their own cells of
+//! a cube, so none of them overlap, and most are boxes like in a real map.
+//!
+class VmfGenerator
+{
+    quint32 m_seed;
+
+    static QVector<QVector3D> planePoints(const GeneratedSolid &solid);
+
+public:
+    explicit VmfGenerator(quint32 seed = 1);
+    QVector<GeneratedSolid> solids(int count) const;
+    QList<Brush> brushes(int count) const;
+    int write(QIODevice *device, int count) const;
+    int writeFile(const QString &fileName, int count) const;
+
+    static Brush brush(const GeneratedSolid &solid);
+    static Brush brush(int sides);
+    static QList<int> mapSizes();
+};
+
+#endif // VMFGENERATOR_H
@@ -17,7 +17,11 @@ along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "brush.h"
 #include "polygoniser.h"
+#include "polygoncache.h"
 #define PI 3.14159265
+
+QAtomicInt Plane::s_live(0);
+
 //!
 //! \brief Plane::Plane Contruct a plane with 3 vertex
 //! \param top_left - Defines the bottom left vertex - Defines the bottom left vertex
@@ -30,6 +34,29 @@ Plane::Plane(QVector3D bot_left, QVector3D top_left, QVector3D top_right) {
     m_top_left = top_left;
     m_top_right = top_right;
   }
+  s_live.ref();
+}
+//!
+//! \brief Plane::Plane copies a plane
+//! \param other
+//!
+Plane::Plane(const Plane &other)
+    : m_bot_left(other.m_bot_left), m_top_left(other.m_top_left),
+      m_top_right(other.m_top_right) {
+  s_live.ref();
+}
+//!
+//! \brief Plane::~Plane
+//!
+Plane::~Plane() {
+  s_live.deref();
+}
+//!
+//! \brief Plane::liveCount
+//! \return how many planes exist right now, to find planes nobody frees
+//!
+int Plane::liveCount() {
+  return s_live.loadAcquire();
 }
 //!
 //! \brief getVertexes returns pointers to vertexes for editing
@@ -68,21 +95,21 @@ void Plane::setTopLeft(QVector3D top_left) {
 //! \brief Plane::getBotLeft
 //! \return
 //!
-QVector3D Plane::getBotLeft() {
+QVector3D Plane::getBotLeft() const {
   return m_bot_left;
 }
 //!
 //! \brief Plane::getTopRight
 //! \return
 //!
-QVector3D Plane::getTopRight() {
+QVector3D Plane::getTopRight() const {
   return m_top_right;
 }
 //!
 //! \brief Plane::getTopLeft
 //! \return
 //!
-QVector3D Plane::getTopLeft() {
+QVector3D Plane::getTopLeft() const {
   return m_top_left;
 }
 
@@ -104,18 +131,47 @@ bool Plane::checkValid(QVector3D bot_left, QVector3D top_left, QVector3D top_rig
     return 0;
 }
 //!
+//! \brief BrushShared::BrushShared gives the brush a new unique id
+//!
+BrushShared::BrushShared()
+    : revision(0), windingsRevision(-1) {
+  static QAtomicInteger<quint64> nextId(1);
+  id = nextId.fetchAndAddRelaxed(1);
+}
+//!
+//! \brief BrushShared::~BrushShared deletes the planes with the last copy of the brush
+//!
+BrushShared::~BrushShared() {
+  qDeleteAll(planes);
+}
+//!
 //! \brief Brush::Brush default (invalid) constructor
 //!
-Brush::Brush() {
+Brush::Brush()
+    : m_shared(new BrushShared) {
 
 }
 //!
 //! \brief Brush::Brush
-//! \param planes
+//! \param planes - The brush takes them over, don't make two brushes from one list
 //!
-Brush::Brush(QList<Plane *> planes) {
+Brush::Brush(QList<Plane *> planes)
+    : m_shared(new BrushShared) {
   //if(!checkValid(planes))
-    m_planes = planes;
+    m_shared->planes = planes;
+}
+//!
+//! \brief Brush::clone copies the brush and its planes
+//! Plain copies alias the planes of the original, a clone can be edited
+//! without changing the brush it was made from.
+//! \return
+//!
+Brush Brush::clone() const {
+  QList<Plane*> planes;
+  planes.reserve(m_shared->planes.size());
+  foreach(const Plane *plane, m_shared->planes)
+    planes.append(new Plane(*plane));
+  return Brush(planes);
 }
 //!
 //! \brief checkValid
@@ -151,8 +207,8 @@ bool Brush::checkValid(QList<Plane*> planes) {
 //! \brief Brush::getNumOfSides
 //! \return Number of planes in the brush
 //!
-int Brush::getNumOfSides() {
-  return m_planes.size();
+int Brush::getNumOfSides() const {
+  return m_shared->planes.size();
 }
 //!
 //! \brief Brush::setXMinMax
@@ -161,7 +217,7 @@ void Brush::setXMinMax() {
   QPointF result;
   qreal f=DBL_MIN;
   Plane *plane;
-  foreach (plane, m_planes) {
+  foreach (plane, m_shared->planes) {
     if(plane->getBotLeft().x() > f)
       f = plane->getBotLeft().x();
     if(plane->getTopLeft().x() > f)
@@ -171,7 +227,7 @@ void Brush::setXMinMax() {
   }
   result.setX(f);
   f=DBL_MAX;
-  foreach (plane, m_planes) {
+  foreach (plane, m_shared->planes) {
     if(plane->getBotLeft().x() < f)
       f = plane->getBotLeft().x();
     if(plane->getTopLeft().x() < f)
@@ -190,7 +246,7 @@ void Brush::setYMinMax() {
   qreal f=DBL_MIN;
   Plane *plane;
   //! Maximum
-  foreach (plane, m_planes) {
+  foreach (plane, m_shared->planes) {
     if(plane->getBotLeft().y() > f)
       f = plane->getBotLeft().y();
     if(plane->getTopLeft().y() > f)
@@ -201,7 +257,7 @@ void Brush::setYMinMax() {
   result.setX(f);
   f=DBL_MAX;
   //! Minimum
-  foreach (plane, m_planes) {
+  foreach (plane, m_shared->planes) {
     if(plane->getBotLeft().y() < f)
       f = plane->getBotLeft().y();
     if(plane->getTopLeft().y() < f)
@@ -219,7 +275,7 @@ void Brush::setZMinMax() {
   QPointF result;
   qreal f=DBL_MIN;
   Plane *plane;
-  foreach (plane, m_planes) {
+  foreach (plane, m_shared->planes) {
     if(plane->getBotLeft().z() > f)
       f = plane->getBotLeft().z();
     if(plane->getTopLeft().z() > f)
@@ -229,7 +285,7 @@ void Brush::setZMinMax() {
   }
   result.setX(f);
   f=DBL_MAX;
-  foreach (plane, m_planes) {
+  foreach (plane, m_shared->planes) {
     if(plane->getBotLeft().z() < f)
       f = plane->getBotLeft().z();
     if(plane->getTopLeft().z() < f)
@@ -506,11 +562,12 @@ void Brush::translate(axis primary, axis secondary, QVector2D transform) {
     break;
   }
   Plane *pla;
-  foreach(pla, m_planes) {
+  foreach(pla, m_shared->planes) {
     pla->setBotLeft(matrix.map(pla->getBotLeft()));
     pla->setTopLeft(matrix.map(pla->getTopLeft()));
     pla->setTopRight(matrix.map(pla->getTopRight()));
   }
+  invalidate();
 }
 //!
 //! \brief Brush::rotate
@@ -560,14 +617,14 @@ void Brush::rotate(axis primary, axis secondary, float angle) {
     matrix.setRow(2, QVector4D(0,sin(angle),cos(angle),0));
     matrix.setRow(3, QVector4D(0,0,0,1));
   }
-  foreach(pla, m_planes) {
+  foreach(pla, m_shared->planes) {
     pla->setBotLeft(matrix.map(pla->getBotLeft()));
     pla->setTopLeft(matrix.map(pla->getTopLeft()));
     pla->setTopRight(matrix.map(pla->getTopRight()));
   }
   // Move the object back to where it came from!
   translate(primary,secondary,center);
-
+  invalidate();
 }
 //!
 //! \brief Brush::scale
@@ -604,11 +661,12 @@ void Brush::scale(axis primary, axis secondary, QVector2D scaleFactor) {
     break;
   }
   Plane *pla;
-  foreach(pla, m_planes) {
+  foreach(pla, m_shared->planes) {
     pla->setBotLeft(matrix.map(pla->getBotLeft()));
     pla->setTopLeft(matrix.map(pla->getTopLeft()));
     pla->setTopRight(matrix.map(pla->getTopRight()));
   }
+  invalidate();
 }
 //!
 void Brush::transform(boundingBox box, axis primary, axis secondary, QVector2D transform) {
@@ -675,6 +733,7 @@ void Brush::transform(boundingBox box, axis primary, axis secondary, QVector2D t
   QVector2D newSize = size + transform;
   scale(primary,secondary,newSize/size);
   translate(primary,secondary,coords);
+  invalidate();
 }
 
 //!
@@ -705,7 +764,7 @@ void  Brush::matchingVertexes(axis primary, axis secondary, QVector2D checkpos)
       else {
         check = checkpos.x();
       }
-      foreach(pla,m_planes) {
+      foreach(pla,m_shared->planes) {
         QList<QVector3D*> list = pla->getVertexes();
         if(pla->getTopLeft().x()==check)
           m_xMatch.append(list.at(0));
@@ -722,7 +781,7 @@ void  Brush::matchingVertexes(axis primary, axis secondary, QVector2D checkpos)
       else {
         check = checkpos.x();
       }
-      foreach(pla,m_planes) {
+      foreach(pla,m_shared->planes) {
         QList<QVector3D*> list = pla->getVertexes();
         if(pla->getTopLeft().y()==check)
           m_yMatch.append(list.at(0));
@@ -739,7 +798,7 @@ void  Brush::matchingVertexes(axis primary, axis secondary, QVector2D checkpos)
       else {
         check = checkpos.x();
       }
-      foreach(pla,m_planes) {
+      foreach(pla,m_shared->planes) {
         QList<QVector3D*> list = pla->getVertexes();
         if(pla->getTopLeft().z()==check)
           m_zMatch.append(list.at(0));
@@ -798,15 +857,79 @@ void  Brush::translateMyVertexes(axis primary, axis secondary, QVector2D transfo
   foreach(vec, m_zMatch) {
     vec->setZ(matrix.map(QVector3D(0,0,vec->z())).z());
   }
+  invalidate();
 }
 //!
 //! \brief Brush::getPlanes
 //! \return
 //!
-QList<Plane*> Brush::getPlanes() {
-  return m_planes;
+const QList<Plane*> &Brush::getPlanes() const {
+  return m_shared->planes;
 }
 
+//!
+//! \brief Brush::polygonise
+//! \param primary - The arbitrary horizontal axis in a 2D view
+//! \param secondary - The arbitrary vertical axis in a 2D view
+//! \return the faces projected in the 2D view, from PolygonCache when possible
+//!
 QList<QPolygonF> Brush::polygonise(axis primary, axis secondary) {
-    return Polygoniser::poligonise(this, primary, secondary);
+    return PolygonCache::global()->polygons(*this, primary, secondary);
+}
+//!
+//! \brief Brush::getWindings returns the 3D outline of every face
+//! The windings are shared by every copy of the brush and only worked out
+//! again after the planes have changed.
+//! \return
+//!
+QList<Winding> Brush::getWindings() const {
+  QMutexLocker locker(&m_shared->mutex);
+  int revision = m_shared->revision.loadAcquire();
+  if(m_shared->windingsRevision != revision) {
+    m_shared->windings = Polygoniser::windings(this);
+    m_shared->windingsRevision = revision;
+  }
+  return m_shared->windings;
+}
+//!
+//! \brief Brush::getId
+//! \return an id shared by every copy of this brush
+//!
+quint64 Brush::getId() const {
+  return m_shared->id;
+}
+//!
+//! \brief Brush::getRevision
+//! \return a counter that changes every time the planes change
+//!
+int Brush::getRevision() const {
+  return m_shared->revision.loadAcquire();
+}
+//!
+//! \brief Brush::invalidate marks everything derived from the planes as stale
+//! Call this after editing vertexes returned by Plane::getVertexes
+//!
+void Brush::invalidate() {
+  m_shared->revision.ref();
+  PolygonCache::global()->invalidate(m_shared->id);
+}
+//!
+//! \brief Brush::accountMemory adds this brush, its planes and its cached windings to a report
+//! Copies alias the same planes, so account for one copy of each brush only.
+//! \param report
+//!
+void Brush::accountMemory(MemoryReport *report) const {
+  qint64 bytes = sizeof(Brush) + sizeof(BrushShared)
+      + MemoryReport::containerBytes(m_shared->planes)
+      + MemoryReport::containerBytes(m_xMatch)
+      + MemoryReport::containerBytes(m_yMatch)
+      + MemoryReport::containerBytes(m_zMatch);
+  {
+    QMutexLocker locker(&m_shared->mutex);
+    bytes += MemoryReport::containerBytes(m_shared->windings);
+    foreach(const Winding &winding, m_shared->windings)
+      bytes += MemoryReport::containerBytes(winding);
+  }
+  report->add(MemoryReport::BRUSHES, bytes, 1);
+  report->add(MemoryReport::PLANES, qint64(m_shared->planes.count()) * sizeof(Plane), m_shared->planes.count());
 }
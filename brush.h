@@ -24,6 +24,7 @@ along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
 #include <QVector2D>
 #include <QMatrix4x4>
 #include <limits.h>
+#include "memoryreport.h"
 
 //!
 //! \brief The Plane class represents a 2D plane
@@ -33,14 +34,18 @@ class Plane
     QVector3D m_bot_left;
     QVector3D m_top_left;
     QVector3D m_top_right;
+    static QAtomicInt s_live;
 public:
     Plane(QVector3D bot_left, QVector3D top_left, QVector3D top_right);
+    Plane(const Plane &other);
+    ~Plane();
+    static int liveCount();
     void setBotLeft(QVector3D bot_left);
     void setTopRight(QVector3D top_right);
     void setTopLeft(QVector3D top_left);
-    QVector3D getBotLeft();
-    QVector3D getTopRight();
-    QVector3D getTopLeft();
+    QVector3D getBotLeft() const;
+    QVector3D getTopRight() const;
+    QVector3D getTopLeft() const;
     bool checkValid(QVector3D bot_left, QVector3D top_left, QVector3D top_right);
     QList<QVector3D*> getVertexes();
 
@@ -52,12 +57,33 @@ enum axis {
     Z_AXIS,
 };
 
+//! The 3D points of one brush face, in no particular order
+typedef QVector<QVector3D> Winding;
+
+//!
+//! \brief The BrushShared struct is the state shared by every copy of a brush
+//! Copies of a Brush alias the same planes, so the planes and anything
+//! derived from them are shared between them as well. The planes are
+//! deleted with the last copy, snapshots keep old planes alive that way.
+//!
+struct BrushShared
+{
+    BrushShared();
+    ~BrushShared();
+    QList<Plane*> planes;   //! Owned
+    quint64 id;             //! Unique for the lifetime of the program
+    QAtomicInt revision;    //! Bumped every time the planes change
+    QMutex mutex;           //! Guards the cached windings
+    int windingsRevision;   //! The revision the windings were made at
+    QList<Winding> windings;
+};
+
 //!
 //! \brief The Brush class represents a 3D solid
 //!
 class Brush
 {
-    QList<Plane*> m_planes;
+    QSharedPointer<BrushShared> m_shared;
     bool checkValid(QList<Plane*> planes);
     bool getBoundingBox();
     void setXMinMax();
@@ -69,7 +95,8 @@ class Brush
 public:
     Brush();
     Brush(QList<Plane*> planes);
-    int getNumOfSides();
+    Brush clone() const;
+    int getNumOfSides() const;
     enum boundingBox {
         BOUND_BOX__TOP_LEFT,
         BOUND_BOX__TOP_RIGHT,
@@ -101,8 +128,13 @@ public:
     void scale(axis primary, axis secondary, QVector2D travector);
     void matchingVertexes(axis primary, axis secondary, QVector2D checkpos);
     void translateMyVertexes(axis primary, axis secondary, QVector2D transform);
-    QList<Plane*> getPlanes();
+    const QList<Plane*> &getPlanes() const;
     QList<QPolygonF> polygonise(axis primary, axis secondary);
+    QList<Winding> getWindings() const;
+    quint64 getId() const;
+    int getRevision() const;
+    void invalidate();
+    void accountMemory(MemoryReport *report) const;
 
 };
 
@@ -0,0 +1,556 @@
+/*
+This file is part of World Editor.
+
+World Editor is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+World Editor is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <QtMath>
+#include <QElapsedTimer>
+#include <QSet>
+#include "brushlayeritem.h"
+#include "trace.h"
+
+//! Brushes smaller than this on screen are drawn as a point
+#define LOD_POINT_PIXELS 2
+//! Brushes smaller than this on screen are drawn as their bounding rect
+#define LOD_RECT_PIXELS 8
+//! The arrays are compacted once this share of their points is dead
+#define DEAD_POINTS_RATIO 0.5
+
+//!
+//! \brief overlaps like QRectF::intersects but also true for rects with no width or height
+//!
+static inline bool overlaps(const QRectF &a, const QRectF &b) {
+    return !(a.right() < b.left() || a.left() > b.right() ||
+             a.bottom() < b.top() || a.top() > b.bottom());
+}
+
+//!
+//! \brief distanceToSegment
+//! \return distance between point p and the segment from a to b
+//!
+static inline qreal distanceToSegment(const QPointF &p, const QPointF &a, const QPointF &b) {
+    QPointF ab = b - a;
+    qreal length = QPointF::dotProduct(ab, ab);
+    qreal t = 0;
+    if(length > 0)
+        t = qBound(qreal(0), QPointF::dotProduct(p - a, ab) / length, qreal(1));
+    QPointF d = p - (a + ab * t);
+    return qSqrt(QPointF::dotProduct(d, d));
+}
+
+//!
+//! \brief BrushPaintStats::BrushPaintStats
+//!
+BrushPaintStats::BrushPaintStats()
+    : painted(0), rects(0), dots(0), culled(0), nsecs(0)
+{
+}
+//!
+//! \brief BrushPaintStats::operator +=
+//! \param other
+//! \return
+//!
+BrushPaintStats &BrushPaintStats::operator+=(const BrushPaintStats &other) {
+    painted += other.painted;
+    rects += other.rects;
+    dots += other.dots;
+    culled += other.culled;
+    nsecs += other.nsecs;
+    return *this;
+}
+
+//!
+//! \brief BrushLayerItem::BrushLayerItem
+//! \param parent
+//!
+BrushLayerItem::BrushLayerItem(QGraphicsItem *parent)
+    : QGraphicsItem(parent), m_detail(FULL_DETAIL), m_renderedByScene(false),
+      m_deadFaces(0), m_deadPoints(0)
+{
+    // paint needs the exposed rect to cull brushes
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption, true);
+}
+//!
+//! \brief BrushLayerItem::boundingRect
+//! \return
+//!
+QRectF BrushLayerItem::boundingRect() const {
+    qreal margin = m_pen.widthF() / 2;
+    return m_bounds.adjusted(-margin, -margin, margin, margin);
+}
+//!
+//! \brief BrushLayerItem::paint draws the outline of every brush crossing the exposed rect
+//! \param painter
+//! \param option
+//! \param widget
+//!
+void BrushLayerItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) {
+    Q_UNUSED(widget);
+    if(m_renderedByScene)
+        return;
+    TRACE_SCOPE(PAINT, "brushes");
+    QElapsedTimer timer;
+    timer.start();
+    BrushPaintStats stats = draw(painter, m_geometry, m_pen, m_detail, option->exposedRect, &m_buffers);
+    stats.nsecs = timer.nsecsElapsed();
+    m_stats += stats;
+}
+//!
+//! \brief BrushLayerItem::takePaintStats
+//! \return what paint cost since the last call
+//!
+BrushPaintStats BrushLayerItem::takePaintStats() {
+    BrushPaintStats stats = m_stats;
+    m_stats = BrushPaintStats();
+    return stats;
+}
+//!
+//! \brief BrushLayerItem::draw draws the outline of every brush crossing the exposed rect
+//! With ADAPTIVE_DETAIL, brushes whose bounding rect is only a few pixels on
+//! screen are drawn as that rect, or as a single point when smaller still.
+//! Only touches its arguments, so it can draw a snapshot from another thread.
+//! \param painter
+//! \param geometry
+//! \param pen
+//! \param detail
+//! \param exposed the area to draw in item coordinates
+//! \param buffers working memory
+//! \return the brushes painted and culled
+//!
+BrushPaintStats BrushLayerItem::draw(QPainter *painter, const BrushGeometry &geometry, const QPen &pen,
+                                     LevelOfDetail detail, const QRectF &exposed, BrushPaintBuffers *buffers) {
+    BrushPaintStats stats;
+    qreal margin = pen.widthF() / 2;
+    QRectF area = exposed.adjusted(-margin, -margin, margin, margin);
+    const qreal pixels = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+
+    buffers->lines.resize(0);
+    buffers->rects.resize(0);
+    buffers->dots.resize(0);
+    for(int b = 0; b < geometry.brushBounds.size(); b++) {
+        const QRectF &bounds = geometry.brushBounds.at(b);
+        if(!overlaps(bounds, area)) {
+            stats.culled++;
+            continue;
+        }
+        stats.painted++;
+        if(detail == ADAPTIVE_DETAIL) {
+            qreal size = qMax(bounds.width(), bounds.height()) * pixels;
+            if(size < LOD_POINT_PIXELS) {
+                buffers->dots.append(bounds.center());
+                stats.dots++;
+                continue;
+            }
+            if(size < LOD_RECT_PIXELS) {
+                buffers->rects.append(bounds);
+                stats.rects++;
+                continue;
+            }
+        }
+        const PolygonArena &faces = geometry.faces;
+        int last = faces.brushOffsets.at(b) + faces.brushCounts.at(b);
+        for(int face = faces.brushOffsets.at(b); face < last; face++) {
+            const QPointF *points = faces.points.constData() + faces.offsets.at(face);
+            int count = faces.counts.at(face);
+            if(count < 2)
+                continue;
+            if(count == 2) {
+                buffers->lines.append(QLineF(points[0], points[1]));
+                continue;
+            }
+            for(int i = 0; i < count; i++)
+                buffers->lines.append(QLineF(points[i], points[(i + 1) % count]));
+        }
+    }
+    painter->setPen(pen);
+    painter->setBrush(Qt::NoBrush);
+    painter->drawLines(buffers->lines);
+
+    if(buffers->rects.isEmpty() && buffers->dots.isEmpty())
+        return stats;
+    // Dashes are lost on something this small
+    QPen solid = pen;
+    solid.setStyle(Qt::SolidLine);
+    painter->setPen(solid);
+    painter->drawRects(buffers->rects);
+    painter->drawPoints(buffers->dots.constData(), buffers->dots.size());
+    return stats;
+}
+//!
+//! \brief BrushLayerItem::cull counts the brushes draw would paint and cull, without drawing
+//! Tiles each cull against their own area, this counts them once for the area of all of them.
+//! \param geometry
+//! \param pen
+//! \param exposed the area to draw in item coordinates
+//! \return the brushes painted and culled
+//!
+BrushPaintStats BrushLayerItem::cull(const BrushGeometry &geometry, const QPen &pen, const QRectF &exposed) {
+    BrushPaintStats stats;
+    qreal margin = pen.widthF() / 2;
+    QRectF area = exposed.adjusted(-margin, -margin, margin, margin);
+    foreach(const QRectF &bounds, geometry.brushBounds) {
+        if(overlaps(bounds, area))
+            stats.painted++;
+        else
+            stats.culled++;
+    }
+    return stats;
+}
+//!
+//! \brief BrushLayerItem::geometry
+//! \return the flat arrays, copy them to take a snapshot
+//!
+const BrushGeometry &BrushLayerItem::geometry() const {
+    return m_geometry;
+}
+//!
+//! \brief BrushLayerItem::pen
+//! \return
+//!
+QPen BrushLayerItem::pen() const {
+    return m_pen;
+}
+//!
+//! \brief BrushLayerItem::setRenderedByScene stops the item painting itself
+//! The item still tells the scene which areas changed, so the scene can
+//! draw the brushes itself, see ViewPortScene::drawTiled
+//! \param on
+//!
+void BrushLayerItem::setRenderedByScene(bool on) {
+    m_renderedByScene = on;
+    update();
+}
+//!
+//! \brief BrushLayerItem::setPen
+//! \param pen
+//!
+void BrushLayerItem::setPen(const QPen &pen) {
+    prepareGeometryChange();
+    m_pen = pen;
+    update();
+}
+//!
+//! \brief BrushLayerItem::setLevelOfDetail
+//! \param detail
+//!
+void BrushLayerItem::setLevelOfDetail(LevelOfDetail detail) {
+    if(m_detail == detail)
+        return;
+    m_detail = detail;
+    update();
+}
+//!
+//! \brief BrushLayerItem::levelOfDetail
+//! \return
+//!
+BrushLayerItem::LevelOfDetail BrushLayerItem::levelOfDetail() const {
+    return m_detail;
+}
+//!
+//! \brief bounds of the points of some faces of an arena
+//! \param faces
+//! \param first first face
+//! \param count number of faces
+//! \return
+//!
+static QRectF faceBounds(const PolygonArena &faces, int first, int count) {
+    QRectF bounds;
+    bool empty = true;
+    for(int face = first; face < first + count; face++) {
+        const QPointF *points = faces.points.constData() + faces.offsets.at(face);
+        for(int i = 0; i < faces.counts.at(face); i++) {
+            const QPointF &point = points[i];
+            if(empty) {
+                bounds = QRectF(point, point);
+                empty = false;
+            }
+            else {
+                bounds.setLeft(qMin(bounds.left(), point.x()));
+                bounds.setRight(qMax(bounds.right(), point.x()));
+                bounds.setTop(qMin(bounds.top(), point.y()));
+                bounds.setBottom(qMax(bounds.bottom(), point.y()));
+            }
+        }
+    }
+    return bounds;
+}
+//!
+//! \brief BrushLayerItem::addBrushes appends many brushes with a single geometry change
+//! An empty layer takes the arena over without copying it, so filling a
+//! scene writes each point only once, in addRows.
+//! \param ids returned by brushAt for each brush
+//! \param faces one brush per id, already in scene coordinates
+//!
+void BrushLayerItem::addBrushes(const QVector<int> &ids, const PolygonArena &faces) {
+    Q_ASSERT(ids.size() == faces.brushCount());
+    if(ids.isEmpty())
+        return;
+    prepareGeometryChange();
+    const int first = m_geometry.brushIds.size();
+    if(m_geometry.faces.brushCount() == 0)
+        m_geometry.faces = faces;
+    else
+        m_geometry.faces.append(faces);
+    m_geometry.brushIds += ids;
+    m_geometry.brushBounds.reserve(first + ids.size());
+    for(int b = 0; b < ids.size(); b++) {
+        QRectF bounds = faceBounds(faces, faces.brushOffsets.at(b), faces.brushCounts.at(b));
+        m_geometry.brushBounds.append(bounds);
+        m_bounds = (first + b) ? m_bounds.united(bounds) : bounds;
+    }
+    update();
+}
+//!
+//! \brief BrushLayerItem::replaceBrushes swaps the faces of many brushes
+//! Only the replaced brushes are visited. The layer bounds only ever grow
+//! here, they are tightened again when the arrays are compacted.
+//! \param indexes - Position of each brush in the layer
+//! \param faces one brush per index, already in scene coordinates
+//!
+void BrushLayerItem::replaceBrushes(const QVector<int> &indexes, const PolygonArena &faces) {
+    Q_ASSERT(indexes.size() == faces.brushCount());
+    QRectF dirty;
+    for(int i = 0; i < indexes.size(); i++) {
+        int index = indexes.at(i);
+        if(index < 0 || index >= m_geometry.brushBounds.size())
+            continue;
+        dirty = dirty.united(m_geometry.brushBounds.at(index));
+        dirty = dirty.united(writeBrush(index, faces, i));
+    }
+    if(dirty.isNull())
+        return;
+
+    if(!m_bounds.contains(dirty)) {
+        prepareGeometryChange();
+        m_bounds = m_bounds.united(dirty);
+    }
+    if(m_deadPoints > m_geometry.faces.points.size() * DEAD_POINTS_RATIO) {
+        prepareGeometryChange();
+        compact();
+    }
+    // Grow by the pen so the old outline is wiped as well
+    qreal margin = m_pen.widthF() / 2 + 1;
+    update(dirty.adjusted(-margin, -margin, margin, margin));
+}
+//!
+//! \brief BrushLayerItem::removeBrushes takes many brushes out in one pass
+//! Their faces are left dead like those of replaced brushes. Only the arrays
+//! with an entry per brush close up, so the others keep their order.
+//! \param ids - As the brushes were added, unknown ones are ignored
+//!
+void BrushLayerItem::removeBrushes(const QVector<int> &ids) {
+    if(ids.isEmpty())
+        return;
+    QSet<int> removed;
+    removed.reserve(ids.size());
+    foreach(int id, ids)
+        removed.insert(id);
+
+    PolygonArena &faces = m_geometry.faces;
+    const int count = m_geometry.brushIds.size();
+    QRectF dirty;
+    int kept = 0;
+    for(int b = 0; b < count; b++) {
+        if(removed.contains(m_geometry.brushIds.at(b))) {
+            dirty = dirty.united(m_geometry.brushBounds.at(b));
+            int last = faces.brushOffsets.at(b) + faces.brushCounts.at(b);
+            for(int face = faces.brushOffsets.at(b); face < last; face++)
+                m_deadPoints += faces.counts.at(face);
+            m_deadFaces += faces.brushCounts.at(b);
+            continue;
+        }
+        if(kept != b) {
+            m_geometry.brushIds[kept] = m_geometry.brushIds.at(b);
+            m_geometry.brushBounds[kept] = m_geometry.brushBounds.at(b);
+            faces.brushOffsets[kept] = faces.brushOffsets.at(b);
+            faces.brushCounts[kept] = faces.brushCounts.at(b);
+        }
+        kept++;
+    }
+    if(kept == count)
+        return;
+    if(kept == 0) {
+        clear();
+        return;
+    }
+    m_geometry.brushIds.resize(kept);
+    m_geometry.brushBounds.resize(kept);
+    faces.brushOffsets.resize(kept);
+    faces.brushCounts.resize(kept);
+
+    if(m_deadPoints > faces.points.size() * DEAD_POINTS_RATIO) {
+        prepareGeometryChange();
+        compact();
+    }
+    qreal margin = m_pen.widthF() / 2 + 1;
+    update(dirty.adjusted(-margin, -margin, margin, margin));
+}
+//!
+//! \brief BrushLayerItem::writeBrush stores new faces for a brush
+//! Faces with the same number of points are overwritten where they are,
+//! otherwise the new faces go at the end and the old ones are left dead.
+//! \param index
+//! \param faces
+//! \param brush - The brush of faces to write
+//! \return the new bounds of the brush in the scene
+//!
+QRectF BrushLayerItem::writeBrush(int index, const PolygonArena &faces, int brush) {
+    PolygonArena &layer = m_geometry.faces;
+    const int firstFace = layer.brushOffsets.at(index);
+    const int count = layer.brushCounts.at(index);
+    const int newFirst = faces.brushOffsets.at(brush);
+    const int newCount = faces.brushCounts.at(brush);
+    bool sameShape = newCount == count;
+    for(int f = 0; sameShape && f < count; f++)
+        sameShape = faces.counts.at(newFirst + f) == layer.counts.at(firstFace + f);
+
+    if(sameShape) {
+        for(int f = 0; f < count; f++) {
+            const QPointF *from = faces.points.constData() + faces.offsets.at(newFirst + f);
+            QPointF *to = layer.points.data() + layer.offsets.at(firstFace + f);
+            std::copy(from, from + faces.counts.at(newFirst + f), to);
+        }
+    }
+    else {
+        m_deadFaces += count;
+        for(int f = firstFace; f < firstFace + count; f++)
+            m_deadPoints += layer.counts.at(f);
+        layer.brushOffsets[index] = layer.counts.size();
+        layer.brushCounts[index] = newCount;
+        for(int f = newFirst; f < newFirst + newCount; f++) {
+            const QPointF *from = faces.points.constData() + faces.offsets.at(f);
+            layer.offsets.append(layer.points.size());
+            layer.counts.append(faces.counts.at(f));
+            for(int i = 0; i < faces.counts.at(f); i++)
+                layer.points.append(from[i]);
+        }
+    }
+    QRectF bounds = faceBounds(faces, newFirst, newCount);
+    m_geometry.brushBounds[index] = bounds;
+    return bounds;
+}
+//!
+//! \brief BrushLayerItem::compact drops dead faces and tightens the bounds
+//!
+void BrushLayerItem::compact() {
+    const PolygonArena &old = m_geometry.faces;
+    PolygonArena faces;
+    faces.points.reserve(old.points.size() - m_deadPoints);
+    faces.offsets.reserve(old.counts.size() - m_deadFaces);
+    faces.counts.reserve(old.counts.size() - m_deadFaces);
+    faces.brushOffsets.reserve(old.brushOffsets.size());
+    faces.brushCounts = old.brushCounts;
+    m_bounds = QRectF();
+    for(int b = 0; b < old.brushOffsets.size(); b++) {
+        faces.brushOffsets.append(faces.counts.size());
+        int last = old.brushOffsets.at(b) + old.brushCounts.at(b);
+        for(int face = old.brushOffsets.at(b); face < last; face++) {
+            int offset = old.offsets.at(face);
+            int count = old.counts.at(face);
+            faces.offsets.append(faces.points.size());
+            faces.counts.append(count);
+            for(int i = 0; i < count; i++)
+                faces.points.append(old.points.at(offset + i));
+        }
+        m_bounds = b ? m_bounds.united(m_geometry.brushBounds.at(b)) : m_geometry.brushBounds.at(b);
+    }
+    m_geometry.faces = faces;
+    m_deadFaces = 0;
+    m_deadPoints = 0;
+}
+//!
+//! \brief BrushLayerItem::clear removes every brush
+//!
+void BrushLayerItem::clear() {
+    prepareGeometryChange();
+    m_geometry = BrushGeometry();
+    m_bounds = QRectF();
+    m_deadFaces = 0;
+    m_deadPoints = 0;
+}
+//!
+//! \brief BrushLayerItem::faceContains
+//! \param face
+//! \param pos
+//! \param tolerance how close to an edge counts as a hit
+//! \return true if pos is inside the face or close to one of its edges
+//!
+bool BrushLayerItem::faceContains(int face, const QPointF &pos, qreal tolerance) const {
+    const QPointF *points = m_geometry.faces.points.constData() + m_geometry.faces.offsets.at(face);
+    int count = m_geometry.faces.counts.at(face);
+    bool inside = false;
+    for(int i = 0, j = count - 1; i < count; j = i++) {
+        if(distanceToSegment(pos, points[j], points[i]) <= tolerance)
+            return true;
+        if(count > 2 && ((points[i].y() > pos.y()) != (points[j].y() > pos.y())) &&
+                (pos.x() < (points[j].x() - points[i].x()) * (pos.y() - points[i].y()) /
+                 (points[j].y() - points[i].y()) + points[i].x()))
+            inside = !inside;
+    }
+    return inside;
+}
+//!
+//! \brief BrushLayerItem::brushAt picks the brush under a point
+//! \param pos in scene coordinates
+//! \param tolerance how close to an outline counts as a hit
+//! \return the id the brush was added with, -1 if there is none
+//!
+int BrushLayerItem::brushAt(const QPointF &pos, qreal tolerance) const {
+    // The last brush added is drawn on top
+    for(int b = m_geometry.brushBounds.size() - 1; b >= 0; b--) {
+        if(!overlaps(m_geometry.brushBounds.at(b).adjusted(-tolerance, -tolerance, tolerance, tolerance),
+                     QRectF(pos, pos)))
+            continue;
+        int last = m_geometry.faces.brushOffsets.at(b) + m_geometry.faces.brushCounts.at(b);
+        for(int face = m_geometry.faces.brushOffsets.at(b); face < last; face++) {
+            if(faceContains(face, pos, tolerance))
+                return m_geometry.brushIds.at(b);
+        }
+    }
+    return -1;
+}
+//!
+//! \brief BrushLayerItem::brushCount
+//! \return
+//!
+int BrushLayerItem::brushCount() const {
+    return m_geometry.brushIds.size();
+}
+//!
+//! \brief BrushLayerItem::faceCount
+//! \return
+//!
+int BrushLayerItem::faceCount() const {
+    return m_geometry.faces.polygonCount() - m_deadFaces;
+}
+//!
+//! \brief BrushLayerItem::accountMemory adds the flat arrays and the paint buffers to a report
+//! Faces left behind by replaced brushes are included, they hold memory until compact.
+//! \param report
+//!
+void BrushLayerItem::accountMemory(MemoryReport *report) const {
+    qint64 bytes = MemoryReport::containerBytes(m_geometry.faces.points)
+            + MemoryReport::containerBytes(m_geometry.faces.offsets)
+            + MemoryReport::containerBytes(m_geometry.faces.counts)
+            + MemoryReport::containerBytes(m_geometry.faces.brushOffsets)
+            + MemoryReport::containerBytes(m_geometry.faces.brushCounts)
+            + MemoryReport::containerBytes(m_geometry.brushIds)
+            + MemoryReport::containerBytes(m_geometry.brushBounds)
+            + MemoryReport::containerBytes(m_buffers.lines)
+            + MemoryReport::containerBytes(m_buffers.rects)
+            + MemoryReport::containerBytes(m_buffers.dots);
+    report->add(MemoryReport::SCENE_GEOMETRY, bytes, m_geometry.faces.polygonCount());
+}
@@ -0,0 +1,118 @@
+/*
+This file is part of World Editor.
+
+World Editor is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+World Editor is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef BRUSHLAYERITEM_H
+#define BRUSHLAYERITEM_H
+
+#include <QGraphicsItem>
+#include <QPainter>
+#include <QPen>
+#include <QStyleOptionGraphicsItem>
+#include "memoryreport.h"
+#include "polygoniser.h"
+
+//!
+//! \brief The BrushGeometry struct holds projected brushes in flat arrays
+//! The faces are kept in the arena the polygoniser writes. Copies are
+//! implicitly shared, so taking one is a cheap snapshot that other
+//! threads can draw from while the original carries on changing.
+//!
+struct BrushGeometry
+{
+    PolygonArena faces;             //! Faces of every brush in the scene, those of a brush are contiguous
+    QVector<int> brushIds;          //! Id the brush was added with
+    QVector<QRectF> brushBounds;    //! Bounding rect of each brush
+};
+
+//!
+//! \brief The BrushPaintBuffers struct is working memory for drawing brushes
+//!
+struct BrushPaintBuffers
+{
+    QVector<QLineF> lines;
+    QVector<QRectF> rects;
+    QVector<QPointF> dots;
+};
+
+//!
+//! \brief The BrushPaintStats struct counts what drawing the brushes cost
+//!
+struct BrushPaintStats
+{
+    int painted;    //! Brushes drawn, with their faces or simplified
+    int rects;      //! Of those painted, the ones drawn as their bounding rect
+    int dots;       //! Of those painted, the ones drawn as a point
+    int culled;     //! Brushes outside the exposed rect
+    qint64 nsecs;   //! Time spent drawing, only kept by BrushLayerItem::paint
+
+    BrushPaintStats();
+    BrushPaintStats &operator+=(const BrushPaintStats &other);
+};
+
+//!
+//! \brief The BrushLayerItem class draws every brush of a 2D view as one item
+//! The projected faces are kept in flat arrays rather than one
+//! QGraphicsPolygonItem each. Painting only visits brushes whose bounds
+//! cross the exposed rect and sends their outlines in one drawLines call.
+//!
+class BrushLayerItem : public QGraphicsItem
+{
+public:
+    enum LevelOfDetail {
+        FULL_DETAIL,        //! Every brush is drawn with its faces
+        ADAPTIVE_DETAIL,    //! Brushes small on screen are drawn as a rect or a point
+    };
+
+private:
+    BrushGeometry m_geometry;
+    QRectF m_bounds;
+    QPen m_pen;
+    LevelOfDetail m_detail;
+    bool m_renderedByScene;
+    BrushPaintBuffers m_buffers;    //! Reused by paint so repaints don't allocate
+    BrushPaintStats m_stats;        //! Added up by paint until takePaintStats
+    int m_deadFaces;                //! Faces left behind by replaced brushes
+    int m_deadPoints;               //! Points of those faces
+
+    bool faceContains(int face, const QPointF &pos, qreal tolerance) const;
+    QRectF writeBrush(int index, const PolygonArena &faces, int brush);
+    void compact();
+
+public:
+    BrushLayerItem(QGraphicsItem *parent = 0);
+    QRectF boundingRect() const;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget = 0);
+    static BrushPaintStats draw(QPainter *painter, const BrushGeometry &geometry, const QPen &pen,
+                                LevelOfDetail detail, const QRectF &exposed, BrushPaintBuffers *buffers);
+    static BrushPaintStats cull(const BrushGeometry &geometry, const QPen &pen, const QRectF &exposed);
+    BrushPaintStats takePaintStats();
+    const BrushGeometry &geometry() const;
+    QPen pen() const;
+    void setRenderedByScene(bool on);
+    void setPen(const QPen &pen);
+    void setLevelOfDetail(LevelOfDetail detail);
+    LevelOfDetail levelOfDetail() const;
+    void addBrushes(const QVector<int> &ids, const PolygonArena &faces);
+    void replaceBrushes(const QVector<int> &indexes, const PolygonArena &faces);
+    void removeBrushes(const QVector<int> &ids);
+    void clear();
+    int brushAt(const QPointF &pos, qreal tolerance = 0) const;
+    int brushCount() const;
+    int faceCount() const;
+    void accountMemory(MemoryReport *report) const;
+};
+
+#endif // BRUSHLAYERITEM_H
@@ -0,0 +1,223 @@
+/*
+This file is part of World Editor.
+
+World Editor is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+World Editor is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <QPainter>
+#include <QtMath>
+#include "cameraview.h"
+#include "trace.h"
+
+//! Units moved by a key press or a wheel step
+#define CAMERA_STEP 64
+//! Degrees turned per pixel dragged
+#define CAMERA_TURN 0.25f
+
+//!
+//! \brief CameraView::CameraView
+//! \param parent
+//!
+CameraView::CameraView(QWidget *parent)
+    : QWidget(parent)
+{
+    m_map = 0;
+    m_meshDirty = false;
+    m_position = QVector3D(0, 0, 0);
+    m_look = QVector3D(0, 1, 0);
+    setFocusPolicy(Qt::StrongFocus);
+    // The whole widget is covered by the frame every paint
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+//!
+//! \brief CameraView::setMap
+//! \param map
+//!
+void CameraView::setMap(Map *map) {
+    m_map = map;
+    setCamera(map->activeCamera());
+    invalidateMesh();
+}
+//!
+//! \brief CameraView::setCamera
+//! \param camera
+//!
+void CameraView::setCamera(const Map::s_cameras &camera) {
+    m_position = camera.position;
+    m_look = camera.look;
+    if(m_look == m_position)
+        m_look = m_position + QVector3D(0, 1, 0);
+    update();
+}
+//!
+//! \brief CameraView::camera
+//! \return
+//!
+Map::s_cameras CameraView::camera() const {
+    Map::s_cameras camera;
+    camera.position = m_position;
+    camera.look = m_look;
+    return camera;
+}
+//!
+//! \brief CameraView::invalidateMesh rebuilds the triangles before the next frame
+//!
+void CameraView::invalidateMesh() {
+    m_meshDirty = true;
+    update();
+}
+//!
+//! \brief CameraView::applyUpdate brings the mesh up to date like the 2D scenes
+//! Without a reset the renderer holds the brushes in row order, removed
+//! brushes are taken out by handle and changed rows are triangulated again
+//! where they are, so an edit only touches the brushes it changed.
+//! \param changes - From the SceneUpdateQueue of the model
+//!
+void CameraView::applyUpdate(const SceneUpdate &changes) {
+    if(!m_map)
+        return;
+    if(changes.reset || m_meshDirty) {
+        invalidateMesh();
+        return;
+    }
+    TRACE_SCOPE(PAINT, "cameraUpdate");
+    const Solids &solids = m_map->m_solids;
+    if(!changes.removed.isEmpty())
+        m_renderer.removeBrushes(changes.removed);
+    if(!changes.changed.isEmpty()) {
+        QList<Brush> brushes;
+        brushes.reserve(changes.changed.size());
+        foreach(int row, changes.changed)
+            brushes.append(solids.brush(row));
+        m_renderer.replaceBrushes(changes.changed, brushes);
+    }
+    if(changes.firstInserted >= 0)
+        addRows(changes.firstInserted, solids.rowCount() - 1);
+    update();
+}
+//!
+//! \brief CameraView::addRows triangulates rows of the model onto the mesh
+//! The brushes are known by their handle so later removals can find them.
+//! \param first
+//! \param last
+//!
+void CameraView::addRows(int first, int last) {
+    const Solids &solids = m_map->m_solids;
+    last = qMin(last, solids.rowCount() - 1);
+    if(last < first)
+        return;
+    QVector<int> ids;
+    ids.reserve(last - first + 1);
+    for(int row = first; row <= last; row++)
+        ids.append(solids.handle(row));
+    m_renderer.addBrushes(ids, solids.brushes().mid(first, last - first + 1));
+}
+//!
+//! \brief CameraView::paintEvent renders a frame at the device resolution
+//! \param event
+//!
+void CameraView::paintEvent(QPaintEvent *event) {
+    Q_UNUSED(event);
+    TRACE_SCOPE(PAINT, "cameraPaint");
+    if(m_meshDirty && m_map) {
+        m_renderer.clear();
+        addRows(0, m_map->m_solids.rowCount() - 1);
+        m_meshDirty = false;
+    }
+
+    const qreal dpr = devicePixelRatioF();
+    const QSize size = this->size() * dpr;
+    if(m_frame.size() != size) {
+        m_frame = QImage(size, QImage::Format_RGB32);
+        m_frame.setDevicePixelRatio(dpr);
+    }
+    if(!m_frame.isNull()) {
+        QMatrix4x4 camera = SoftwareRenderer::cameraMatrix(
+                    m_position, m_look, float(size.width()) / qMax(1, size.height()));
+        m_renderer.render(&m_frame, camera, qRgb(0, 0, 0));
+    }
+
+    QPainter painter(this);
+    painter.drawImage(0, 0, m_frame);
+}
+//!
+//! \brief CameraView::move moves the eye and the target together
+//! \param forward - Units along the view direction
+//! \param right - Units to the right of it, level with the ground
+//!
+void CameraView::move(float forward, float right) {
+    QVector3D direction = (m_look - m_position).normalized();
+    QVector3D side = QVector3D::crossProduct(direction, QVector3D(0, 0, 1)).normalized();
+    QVector3D offset = direction * forward + side * right;
+    m_position += offset;
+    m_look += offset;
+    update();
+}
+//!
+//! \brief CameraView::mousePressEvent
+//! \param event
+//!
+void CameraView::mousePressEvent(QMouseEvent *event) {
+    m_lastMouse = event->pos();
+}
+//!
+//! \brief CameraView::mouseMoveEvent turns the camera around its eye
+//! \param event
+//!
+void CameraView::mouseMoveEvent(QMouseEvent *event) {
+    if(!(event->buttons() & Qt::LeftButton))
+        return;
+    QPoint delta = event->pos() - m_lastMouse;
+    m_lastMouse = event->pos();
+
+    QVector3D direction = m_look - m_position;
+    float distance = direction.length();
+    float yaw = qAtan2(direction.y(), direction.x()) - qDegreesToRadians(delta.x() * CAMERA_TURN);
+    float pitch = qAsin(qBound(-1.0f, direction.z() / distance, 1.0f))
+            - qDegreesToRadians(delta.y() * CAMERA_TURN);
+    pitch = qBound(float(-M_PI_2 + 0.01), pitch, float(M_PI_2 - 0.01));
+
+    m_look = m_position + distance * QVector3D(qCos(pitch) * qCos(yaw),
+                                               qCos(pitch) * qSin(yaw),
+                                               qSin(pitch));
+    update();
+}
+//!
+//! \brief CameraView::wheelEvent
+//! \param event
+//!
+void CameraView::wheelEvent(QWheelEvent *event) {
+    move(event->delta() > 0 ? CAMERA_STEP : -CAMERA_STEP, 0);
+}
+//!
+//! \brief CameraView::keyPressEvent
+//! \param event
+//!
+void CameraView::keyPressEvent(QKeyEvent *event) {
+    switch(event->key()) {
+    case Qt::Key_W:
+        move(CAMERA_STEP, 0);
+        break;
+    case Qt::Key_S:
+        move(-CAMERA_STEP, 0);
+        break;
+    case Qt::Key_A:
+        move(0, -CAMERA_STEP);
+        break;
+    case Qt::Key_D:
+        move(0, CAMERA_STEP);
+        break;
+    default:
+        QWidget::keyPressEvent(event);
+    }
+}
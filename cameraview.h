@@ -0,0 +1,67 @@
+/*
+This file is part of World Editor.
+
+World Editor is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+World Editor is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef CAMERAVIEW_H
+#define CAMERAVIEW_H
+
+#include <QWidget>
+#include <QImage>
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include "map.h"
+#include "sceneupdatequeue.h"
+#include "softwarerenderer.h"
+
+//!
+//! \brief The CameraView class is the 3D view of the map
+//! It draws the brushes through the SoftwareRenderer, so it needs no GPU.
+//! Dragging with the left button turns the camera, the wheel and the
+//! W, A, S and D keys move it.
+//!
+class CameraView : public QWidget
+{
+    Q_OBJECT
+    Map *m_map;
+    SoftwareRenderer m_renderer;
+    QImage m_frame;
+    QVector3D m_position;
+    QVector3D m_look;
+    bool m_meshDirty;
+    QPoint m_lastMouse;
+
+    void move(float forward, float right);
+    void addRows(int first, int last);
+
+public:
+    CameraView(QWidget *parent = 0);
+    void setMap(Map *map);
+    void setCamera(const Map::s_cameras &camera);
+    Map::s_cameras camera() const;
+
+public slots:
+    void invalidateMesh();
+    void applyUpdate(const SceneUpdate &changes);
+
+protected:
+    virtual void paintEvent(QPaintEvent *event);
+    virtual void mousePressEvent(QMouseEvent *event);
+    virtual void mouseMoveEvent(QMouseEvent *event);
+    virtual void wheelEvent(QWheelEvent *event);
+    virtual void keyPressEvent(QKeyEvent *event);
+};
+
+#endif // CAMERAVIEW_H
@@ -0,0 +1,160 @@
+/*
+This file is part of World Editor.
+
+World Editor is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+World Editor is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QtMath>
+#include <algorithm>
+#include "framestatistics.h"
+
+//!
+//! \brief FrameStatistics::FrameStatistics
+//! \param window - Number of frames the percentiles are taken over
+//!
+FrameStatistics::FrameStatistics(int window)
+{
+    m_window = qMax(1, window);
+    for(int i = 0; i < METRIC_COUNT; i++)
+        m_samples[i].resize(m_window);
+    reset();
+}
+//!
+//! \brief FrameStatistics::beginFrame starts counting a new frame from zero
+//!
+void FrameStatistics::beginFrame() {
+    for(int i = 0; i < METRIC_COUNT; i++)
+        m_current[i] = 0;
+}
+//!
+//! \brief FrameStatistics::add
+//! \param metric
+//! \param value - Added to what the current frame has so far
+//!
+void FrameStatistics::add(Metric metric, qint64 value) {
+    m_current[metric] += value;
+}
+//!
+//! \brief FrameStatistics::endFrame stores the current frame, dropping the oldest when full
+//!
+void FrameStatistics::endFrame() {
+    for(int i = 0; i < METRIC_COUNT; i++)
+        m_samples[i][m_next] = m_current[i];
+    m_next = (m_next + 1) % m_window;
+    m_frames = qMin(m_frames + 1, m_window);
+}
+//!
+//! \brief FrameStatistics::reset forgets every frame
+//!
+void FrameStatistics::reset() {
+    m_frames = 0;
+    m_next = 0;
+    beginFrame();
+}
+//!
+//! \brief FrameStatistics::frames
+//! \return the number of frames in the window
+//!
+int FrameStatistics::frames() const {
+    return m_frames;
+}
+//!
+//! \brief FrameStatistics::last
+//! \param metric
+//! \return the value of the last frame stored
+//!
+qint64 FrameStatistics::last(Metric metric) const {
+    if(m_frames == 0)
+        return 0;
+    return m_samples[metric].at((m_next + m_window - 1) % m_window);
+}
+//!
+//! \brief FrameStatistics::percentile uses the nearest rank over the window
+//! \param metric
+//! \param p - Between 0 and 100
+//! \return
+//!
+qint64 FrameStatistics::percentile(Metric metric, qreal p) const {
+    if(m_frames == 0)
+        return 0;
+    QVector<qint64> sorted = m_samples[metric].mid(0, m_frames);
+    int rank = qBound(0, qCeil(p / 100 * m_frames) - 1, m_frames - 1);
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    return sorted.at(rank);
+}
+//!
+//! \brief FrameStatistics::name
+//! \param metric
+//! \return the key of the metric in toJson
+//!
+QString FrameStatistics::name(Metric metric) {
+    switch(metric) {
+    case BACKGROUND_TIME:
+        return "backgroundNs";
+    case GRID_LINES:
+        return "gridLines";
+    case BRUSH_TIME:
+        return "brushNs";
+    case BRUSHES_PAINTED:
+        return "brushesPainted";
+    case BRUSHES_CULLED:
+        return "brushesCulled";
+    case PAINT_TIME:
+        return "paintNs";
+    default:
+        return QString();
+    }
+}
+//!
+//! \brief FrameStatistics::toJson
+//! \return the last value and the percentiles of every metric, for benchmarks
+//!
+QJsonObject FrameStatistics::toJson() const {
+    QJsonObject metrics;
+    for(int i = 0; i < METRIC_COUNT; i++) {
+        Metric metric = Metric(i);
+        QJsonObject values;
+        values["last"] = double(last(metric));
+        values["p50"] = double(percentile(metric, 50));
+        values["p90"] = double(percentile(metric, 90));
+        values["p99"] = double(percentile(metric, 99));
+        values["max"] = double(percentile(metric, 100));
+        metrics[name(metric)] = values;
+    }
+    QJsonObject json;
+    json["frames"] = m_frames;
+    json["metrics"] = metrics;
+    return json;
+}
+//!
+//! \brief FrameStatistics::summary
+//! \return one line of text per metric, times in ms
+//!
+QStringList FrameStatistics::summary() const {
+    QStringList lines;
+    lines << QString("frames %1").arg(m_frames);
+    for(int i = 0; i < METRIC_COUNT; i++) {
+        Metric metric = Metric(i);
+        bool time = metric == BACKGROUND_TIME || metric == BRUSH_TIME || metric == PAINT_TIME;
+        qreal scale = time ? 1e-6 : 1;
+        int decimals = time ? 2 : 0;
+        QString label = time ? name(metric).replace("Ns", " ms") : name(metric);
+        lines << QString("%1  p50 %2  p90 %3  p99 %4")
+                 .arg(label, -14)
+                 .arg(percentile(metric, 50) * scale, 0, 'f', decimals)
+                 .arg(percentile(metric, 90) * scale, 0, 'f', decimals)
+                 .arg(percentile(metric, 99) * scale, 0, 'f', decimals);
+    }
+    return lines;
+}
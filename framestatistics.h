@@ -0,0 +1,65 @@
+/*
+This file is part of World Editor.
+
+World Editor is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+World Editor is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FRAMESTATISTICS_H
+#define FRAMESTATISTICS_H
+
+#include <QJsonObject>
+#include <QStringList>
+#include <QVector>
+
+//!
+//! \brief The FrameStatistics class keeps what the last frames of a view cost
+//! Values are added to the current frame while it paints, then endFrame
+//! stores them in a rolling window that the percentiles are taken over.
+//!
+class FrameStatistics
+{
+public:
+    enum Metric {
+        BACKGROUND_TIME,    //! ns in drawBackground
+        GRID_LINES,         //! Grid lines drawn, none when every tile was cached
+        BRUSH_TIME,         //! ns drawing brushes in BrushLayerItem::paint
+        BRUSHES_PAINTED,    //! Brushes drawn, with their faces or simplified
+        BRUSHES_CULLED,     //! Brushes skipped for being outside the exposed rect
+        PAINT_TIME,         //! ns in the whole paint event of the view
+        METRIC_COUNT
+    };
+
+private:
+    int m_window;
+    int m_frames;   //! Frames stored, up to m_window
+    int m_next;     //! Where the next frame goes in the window
+    qint64 m_current[METRIC_COUNT];
+    QVector<qint64> m_samples[METRIC_COUNT];
+
+public:
+    FrameStatistics(int window = 240);
+    void beginFrame();
+    void add(Metric metric, qint64 value);
+    void endFrame();
+    void reset();
+
+    int frames() const;
+    qint64 last(Metric metric) const;
+    qint64 percentile(Metric metric, qreal p) const;
+    static QString name(Metric metric);
+    QJsonObject toJson() const;
+    QStringList summary() const;
+};
+
+#endif // FRAMESTATISTICS_H
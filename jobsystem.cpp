@@ -0,0 +1,325 @@
+/*
+This file is part of World Editor.
+
+World Editor is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+World Editor is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QCoreApplication>
+#include <QMetaObject>
+#include "jobsystem.h"
+#include "trace.h"
+
+//! How long a waiting thread sleeps before looking for work again, in milliseconds
+#define JOB_WAIT_MSECS 1
+
+//! The system and deque of the worker running on this thread
+static thread_local const JobSystem *t_system = 0;
+static thread_local int t_worker = -1;
+
+//!
+//! \brief The JobWorker class is the thread behind one deque of a JobSystem
+//!
+class JobWorker : public QThread
+{
+    JobSystem *m_system;
+    int m_index;
+
+public:
+    JobWorker(JobSystem *system, int index)
+        : m_system(system), m_index(index) {
+        setObjectName(QString("JobWorker %1").arg(index));
+    }
+
+protected:
+    void run() {
+        m_system->workerLoop(m_index);
+    }
+};
+
+//!
+//! \brief CancellationToken::CancellationToken a token nobody has cancelled
+//!
+CancellationToken::CancellationToken()
+    : m_cancelled(std::make_shared<QAtomicInt>(0))
+{
+}
+//!
+//! \brief CancellationToken::cancel
+//!
+void CancellationToken::cancel() {
+    m_cancelled->storeRelease(1);
+}
+//!
+//! \brief CancellationToken::isCancelled
+//! \return
+//!
+bool CancellationToken::isCancelled() const {
+    return m_cancelled->loadAcquire() != 0;
+}
+//!
+//! \brief JobState::JobState a job not submitted yet
+//!
+JobState::JobState()
+    : waiting(1), finished(0)
+{
+}
+//!
+//! \brief JobHandle::JobHandle a null handle
+//!
+JobHandle::JobHandle()
+{
+}
+//!
+//! \brief JobHandle::isNull
+//! \return
+//!
+bool JobHandle::isNull() const {
+    return !m_state;
+}
+//!
+//! \brief JobHandle::isFinished
+//! \return true once the job ran or was skipped
+//!
+bool JobHandle::isFinished() const {
+    return !m_state || m_state->finished.loadAcquire();
+}
+//!
+//! \brief JobSystem::JobSystem starts the workers
+//! \param threads - At least one
+//!
+JobSystem::JobSystem(int threads)
+    : m_queued(0), m_nextQueue(0), m_stopping(0), m_waiters(0)
+{
+    threads = qMax(1, threads);
+    for(int i = 0; i < threads; i++)
+        m_queues.append(new WorkerQueue);
+    for(int i = 0; i < threads; i++) {
+        m_workers.append(new JobWorker(this, i));
+        m_workers.last()->start();
+    }
+}
+//!
+//! \brief JobSystem::~JobSystem stops the workers, jobs still queued never run
+//!
+JobSystem::~JobSystem()
+{
+    m_stopping.storeRelease(1);
+    {
+        QMutexLocker locker(&m_sleepMutex);
+        m_wake.wakeAll();
+    }
+    foreach(JobWorker *worker, m_workers) {
+        worker->wait();
+        delete worker;
+    }
+    qDeleteAll(m_queues);
+}
+//!
+//! \brief JobSystem::global
+//! \return the job system shared by the whole editor, one worker per core
+//!
+JobSystem *JobSystem::global() {
+    static JobSystem system;
+    return &system;
+}
+//!
+//! \brief JobSystem::workerCount
+//! \return
+//!
+int JobSystem::workerCount() const {
+    return m_workers.size();
+}
+//!
+//! \brief JobSystem::currentWorker
+//! \return the deque of the calling thread, -1 if it isn't one of our workers
+//!
+int JobSystem::currentWorker() const {
+    return t_system == this ? t_worker : -1;
+}
+//!
+//! \brief JobSystem::run queues a job
+//! \param work
+//! \param token - The job is skipped if this is cancelled before it starts
+//! \return
+//!
+JobHandle JobSystem::run(const std::function<void()> &work, const CancellationToken &token) {
+    return then(QVector<JobHandle>(), work, token);
+}
+//!
+//! \brief JobSystem::then queues a job to run once others have finished
+//! Cancelled dependencies still count as finished.
+//! \param dependencies
+//! \param work
+//! \param token
+//! \return
+//!
+JobHandle JobSystem::then(const QVector<JobHandle> &dependencies, const std::function<void()> &work,
+                          const CancellationToken &token) {
+    std::shared_ptr<JobState> job = std::make_shared<JobState>();
+    job->work = work;
+    job->token = token;
+    foreach(const JobHandle &dependency, dependencies) {
+        if(!dependency.m_state)
+            continue;
+        QMutexLocker locker(&dependency.m_state->mutex);
+        if(!dependency.m_state->finished.loadAcquire()) {
+            job->waiting.ref();
+            dependency.m_state->continuations.append(job);
+        }
+    }
+    if(!job->waiting.deref())
+        enqueue(job);
+
+    JobHandle handle;
+    handle.m_state = job;
+    return handle;
+}
+//!
+//! \brief JobSystem::enqueue puts a job that is ready on a deque and wakes a worker
+//! Workers push onto their own deque, other threads spread jobs over all of them.
+//! \param job
+//!
+void JobSystem::enqueue(const std::shared_ptr<JobState> &job) {
+    int worker = currentWorker();
+    if(worker < 0)
+        worker = int(uint(m_nextQueue.fetchAndAddRelaxed(1)) % uint(m_queues.size()));
+    {
+        QMutexLocker locker(&m_queues.at(worker)->mutex);
+        m_queues.at(worker)->jobs.append(job);
+    }
+    m_queued.ref();
+    QMutexLocker locker(&m_sleepMutex);
+    m_wake.wakeOne();
+}
+//!
+//! \brief JobSystem::take finds the next job for a thread
+//! The newest job of its own deque, else the oldest job of another.
+//! \param worker - -1 for threads that aren't workers, they only steal
+//! \return 0 if every deque is empty
+//!
+std::shared_ptr<JobState> JobSystem::take(int worker) {
+    if(m_queued.loadAcquire() <= 0)
+        return std::shared_ptr<JobState>();
+
+    const int queues = m_queues.size();
+    if(worker >= 0) {
+        WorkerQueue *own = m_queues.at(worker);
+        QMutexLocker locker(&own->mutex);
+        if(!own->jobs.isEmpty()) {
+            m_queued.deref();
+            return own->jobs.takeLast();
+        }
+    }
+    for(int i = 1; i <= queues; i++) {
+        const int victim = (qMax(worker, 0) + i) % queues;
+        if(victim == worker)
+            continue;
+        WorkerQueue *queue = m_queues.at(victim);
+        QMutexLocker locker(&queue->mutex);
+        if(!queue->jobs.isEmpty()) {
+            m_queued.deref();
+            return queue->jobs.takeFirst();
+        }
+    }
+    return std::shared_ptr<JobState>();
+}
+//!
+//! \brief JobSystem::execute runs a job, then queues whatever was only waiting on it
+//! \param job
+//!
+void JobSystem::execute(const std::shared_ptr<JobState> &job) {
+    if(!job->token.isCancelled()) {
+        TRACE_SCOPE(JOBS, "job");
+        job->work();
+    }
+    // Let go of whatever the work captured as soon as it is done
+    job->work = std::function<void()>();
+
+    QVector<std::shared_ptr<JobState> > continuations;
+    {
+        QMutexLocker locker(&job->mutex);
+        job->finished.storeRelease(1);
+        continuations.swap(job->continuations);
+    }
+    foreach(const std::shared_ptr<JobState> &continuation, continuations) {
+        if(!continuation->waiting.deref())
+            enqueue(continuation);
+    }
+    if(m_waiters.loadAcquire() > 0) {
+        QMutexLocker locker(&m_sleepMutex);
+        m_finished.wakeAll();
+    }
+}
+//!
+//! \brief JobSystem::runPending runs one queued job on the calling thread
+//! \return false if there was none
+//!
+bool JobSystem::runPending() {
+    std::shared_ptr<JobState> job = take(currentWorker());
+    if(!job)
+        return false;
+    execute(job);
+    return true;
+}
+//!
+//! \brief JobSystem::wait returns once a job has finished, running other jobs meanwhile
+//! \param job
+//!
+void JobSystem::wait(const JobHandle &job) {
+    while(!job.isFinished()) {
+        if(runPending())
+            continue;
+        QMutexLocker locker(&m_sleepMutex);
+        if(job.isFinished() || m_queued.loadAcquire() > 0)
+            continue;
+        m_waiters.ref();
+        m_finished.wait(&m_sleepMutex, JOB_WAIT_MSECS);
+        m_waiters.deref();
+    }
+}
+//!
+//! \brief JobSystem::wait returns once every job has finished
+//! \param jobs
+//!
+void JobSystem::wait(const QVector<JobHandle> &jobs) {
+    foreach(const JobHandle &job, jobs)
+        wait(job);
+}
+//!
+//! \brief JobSystem::workerLoop runs jobs until the system is destroyed
+//! \param worker
+//!
+void JobSystem::workerLoop(int worker) {
+    t_system = this;
+    t_worker = worker;
+    while(!m_stopping.loadAcquire()) {
+        if(runPending())
+            continue;
+        QMutexLocker locker(&m_sleepMutex);
+        if(m_stopping.loadAcquire() || m_queued.loadAcquire() > 0)
+            continue;
+        m_wake.wait(&m_sleepMutex);
+    }
+}
+//!
+//! \brief JobSystem::postToMain calls a function on the thread of a QObject, usually the GUI
+//! It is queued on the event loop, so it runs after the caller has moved on.
+//! \param context - Nothing is called if it is destroyed first, 0 for the application
+//! \param function
+//!
+void JobSystem::postToMain(QObject *context, const std::function<void()> &function) {
+    if(!context)
+        context = QCoreApplication::instance();
+    QMetaObject::invokeMethod(context, function, Qt::QueuedConnection);
+}
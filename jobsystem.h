@@ -0,0 +1,164 @@
+/*
+This file is part of World Editor.
+
+World Editor is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+World Editor is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <functional>
+#include <memory>
+#include <QAtomicInt>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+
+//!
+//! \brief The CancellationToken class lets the owner of some jobs call them off
+//! Copies share the same flag. Jobs that have not started when it is
+//! cancelled are skipped, jobs already running can poll isCancelled.
+//!
+class CancellationToken
+{
+    std::shared_ptr<QAtomicInt> m_cancelled;
+
+public:
+    CancellationToken();
+    void cancel();
+    bool isCancelled() const;
+};
+
+//!
+//! \brief The JobState struct is a job and what waits on it
+//!
+struct JobState
+{
+    JobState();
+    std::function<void()> work;
+    CancellationToken token;
+    QAtomicInt waiting;     //! Dependencies not finished yet, plus one until submitted
+    QAtomicInt finished;
+    QMutex mutex;           //! Guards continuations against finishing
+    QVector<std::shared_ptr<JobState> > continuations;
+};
+
+//!
+//! \brief The JobHandle class refers to a job submitted to a JobSystem
+//! A null handle counts as finished.
+//!
+class JobHandle
+{
+    friend class JobSystem;
+    std::shared_ptr<JobState> m_state;
+
+public:
+    JobHandle();
+    bool isNull() const;
+    bool isFinished() const;
+};
+
+class JobWorker;
+
+//!
+//! \brief The JobSystem class runs small jobs on one worker thread per core
+//! Every worker has a deque of its own. Jobs submitted by a worker go on the
+//! back of its deque and it takes its own work from the back, so related jobs
+//! stay on one core while idle workers steal from the front of the others.
+//! Threads waiting for a job help run the queued ones instead of blocking, so
+//! jobs can wait for jobs they submitted.
+//!
+class JobSystem
+{
+    friend class JobWorker;
+
+    struct WorkerQueue {
+        QMutex mutex;
+        QList<std::shared_ptr<JobState> > jobs;
+    };
+
+    QVector<JobWorker *> m_workers;
+    QVector<WorkerQueue *> m_queues;
+    QAtomicInt m_queued;        //! Jobs in every deque
+    QAtomicInt m_nextQueue;     //! Where jobs from outside the workers go next
+    QAtomicInt m_stopping;
+    QAtomicInt m_waiters;       //! Threads sleeping in wait
+    QMutex m_sleepMutex;
+    QWaitCondition m_wake;      //! Idle workers sleep on it
+    QWaitCondition m_finished;  //! Threads waiting for a job sleep on it
+
+    void enqueue(const std::shared_ptr<JobState> &job);
+    std::shared_ptr<JobState> take(int worker);
+    void execute(const std::shared_ptr<JobState> &job);
+    void workerLoop(int worker);
+    int currentWorker() const;
+
+public:
+    explicit JobSystem(int threads = QThread::idealThreadCount());
+    ~JobSystem();
+    static JobSystem *global();
+    int workerCount() const;
+
+    JobHandle run(const std::function<void()> &work,
+                  const CancellationToken &token = CancellationToken());
+    JobHandle then(const QVector<JobHandle> &dependencies, const std::function<void()> &work,
+                   const CancellationToken &token = CancellationToken());
+    void wait(const JobHandle &job);
+    void wait(const QVector<JobHandle> &jobs);
+    bool runPending();
+    template<typename Body>
+    void parallelFor(int first, int last, Body body, int grain = 0,
+                     const CancellationToken &token = CancellationToken());
+    static void postToMain(QObject *context, const std::function<void()> &function);
+};
+
+//!
+//! \brief JobSystem::parallelFor calls body(i) for every i in [first, last) on the workers
+//! The range is cut into runs of grain indexes, one job each, and the
+//! calling thread helps until they are all done.
+//! \param first
+//! \param last - One past the last index
+//! \param body - Called from several threads at once
+//! \param grain - Indexes per job, 0 for about four jobs per worker
+//! \param token - Runs not started yet are skipped once it is cancelled
+//!
+template<typename Body>
+void JobSystem::parallelFor(int first, int last, Body body, int grain, const CancellationToken &token) {
+    const int count = last - first;
+    if(count <= 0)
+        return;
+    if(grain <= 0)
+        grain = qMax(1, count / (workerCount() * 4));
+    if(count <= grain || workerCount() < 2) {
+        for(int i = first; i < last && !token.isCancelled(); i++)
+            body(i);
+        return;
+    }
+
+    QVector<JobHandle> jobs;
+    jobs.reserve((count + grain - 1) / grain);
+    for(int begin = first; begin < last; begin += grain) {
+        const int end = qMin(begin + grain, last);
+        jobs.append(run([&body, &token, begin, end]() {
+            for(int i = begin; i < end && !token.isCancelled(); i++)
+                body(i);
+        }, token));
+    }
+    wait(jobs);
+}
+
+#endif // JOBSYSTEM_H
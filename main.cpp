@@ -17,17 +17,22 @@ along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "mainwindow.h"
 #include <QApplication>
-#include <tests/alltests.h>
+#include "startuptrace.h"
+#include "trace.h"
 
 
 int main(int argc, char *argv[])
 {
+    StartupTrace::begin();
+    // Trace from the start, to see where the time of a slow launch goes
+    if(qEnvironmentVariableIsSet("WORLDEDITOR_TRACE"))
+        Trace::setEnabled(true);
     QApplication a(argc, argv);
+    StartupTrace::mark("application");
     MainWindow w;
+    StartupTrace::mark("window");
     w.show();
-
-    allTests tests;
-    tests.runTests();
+    StartupTrace::mark("shown");
 
     return a.exec();
 }
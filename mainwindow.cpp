@@ -18,81 +18,65 @@ along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
 #include "ui_mainwindow.h"
 #include <qlabel.h>
 #include <QFileDialog>
+#include <QDockWidget>
+#include <QTreeView>
+#include <QJsonDocument>
+#include "polygoncache.h"
+#include "startuptrace.h"
+#include "trace.h"
 
 #define GRID_INCREMENT 0
 #define GRID_DECREMENT 1
 #define MAX_UNITS 2097152
+//! Shortest time between two refreshes of the memory use in the status bar
+#define MEMORY_STATUS_INTERVAL_MS 2000
 //!
 //! \brief MainWindow::MainWindow
 //! \param parent
 //!
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
+    m_updates(&model.m_solids),
+    m_tree(&model),
     ui(new Ui::MainWindow)
 {
     ui->setupUi(this);
 
     this->setWindowTitle("World Editor");
-    QLabel *label = new QLabel("Status Bar: ");
-    ui->statusBar->addWidget(label);
+    ui->actionRecordTrace->setChecked(Trace::isEnabled());
+    m_status = new QLabel("Status Bar: ");
+    ui->statusBar->addWidget(m_status);
 
-    for(int i = 0; i < 3; i++) {
-        ViewPortView *view;
-        ViewPortScene *scene;
-        switch(i) {
-        case 0:
-            // Bottom Left
-            view = ui->graphicsView_1;
-            scene = m_scene_1;
-            scene  = new ViewPortScene(&model, Y_AXIS, Z_AXIS);
-            break;
-        case 1:
-            // Bottom Right
-            view = ui->graphicsView_2;
-            scene = m_scene_2;
-            scene  = new ViewPortScene(&model, X_AXIS, Z_AXIS);
-            break;
-        case 2:
-            // Top Right
-            view = ui->graphicsView_3;
-            scene = m_scene_2;
-            scene  = new ViewPortScene(&model, X_AXIS, Y_AXIS);
-            break;
-        }
-        //scene
-        scene->setSceneRect(0,0,MAX_UNITS,MAX_UNITS);
-
-        //view
-        view->setScene(scene);
+    // The 2D views get their scenes the first time they are shown
+    QList<ViewPortView *> views;
+    views << ui->graphicsView_1 << ui->graphicsView_2 << ui->graphicsView_3;
+    foreach(ViewPortView *view, views) {
         view->setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
         view->setViewportUpdateMode(QGraphicsView::SmartViewportUpdate);
         view->setOptimizationFlag(QGraphicsView::DontAdjustForAntialiasing, true);
-
-        // model signals
-        connect(&model.m_solids, SIGNAL(rowsInserted(QModelIndex,int,int)),
-                scene, SLOT(addBrush(QModelIndex,int,int)));
-        connect(view, SIGNAL(scaleChanged(qreal)),scene,SLOT(setScale(qreal)));
-        connect(this, SIGNAL(changeGrid(bool)),scene,SLOT(setGrid(bool)));
-        connect(this, SIGNAL(instantiateBlock()),scene, SLOT(makeNewBlock()));
-        connect(this, SIGNAL(newBlockMode()), scene, SLOT(setNewBlockMode()));
-        connect(this, SIGNAL(changeViewPortMode(MOUSE_INTERACT_MODE)),
-                scene, SLOT(setMouseMode(MOUSE_INTERACT_MODE)));
+        connect(ui->actionFrameStatistics, SIGNAL(toggled(bool)),
+                view, SLOT(setStatisticsVisible(bool)));
+        view->installEventFilter(this);
     }
-    // Test shape
-    QList<Plane*> planes;
-    Plane *plane;
-    planes.prepend(plane = new Plane(QVector3D(-64,-32,64),QVector3D(-64,32,64),QVector3D(-32,64,64)));
-    planes.prepend(plane = new Plane(QVector3D(-64,32,0),QVector3D(-64,-32,0),QVector3D(-32,-64,0)));
-    planes.prepend(plane = new Plane(QVector3D(-64,-32,0),QVector3D(-64,32,0),QVector3D(-64,32,64)));
-    planes.prepend(plane = new Plane(QVector3D(64,32,0),QVector3D(64,-32,0),QVector3D(64,-32,64)));
-    planes.prepend(plane = new Plane(QVector3D(-32,64,0),QVector3D(32,64,0),QVector3D(32,64,64)));
-    planes.prepend(plane = new Plane(QVector3D(32,-64,0),QVector3D(-32,-64,0),QVector3D(-32,-64,64)));
-    planes.prepend(plane = new Plane(QVector3D(32,64,0),QVector3D(64,32,0),QVector3D(64,32,64)));
-    planes.prepend(plane = new Plane(QVector3D(64,-32,0),QVector3D(32,-64,0),QVector3D(32,-64,64)));
-    planes.prepend(plane = new Plane(QVector3D(-32,-64,0),QVector3D(-64,-32,0),QVector3D(-64,-32,64)));
-    planes.prepend(plane = new Plane(QVector3D(-64,32,0),QVector3D(-32,64,0),QVector3D(-32,64,64)));
-    Brush brush(planes);
-    model.m_solids.addSolid(brush);
+    // 3D view
+    ui->graphicsView->setMap(&model);
+    connect(&m_updates, SIGNAL(updated(SceneUpdate)),
+            ui->graphicsView, SLOT(applyUpdate(SceneUpdate)));
+
+    // World tree, branches are only filled in as they are expanded
+    QDockWidget *dock = new QDockWidget(tr("World"), this);
+    QTreeView *tree = new QTreeView(dock);
+    tree->setHeaderHidden(true);
+    tree->setUniformRowHeights(true);
+    tree->setModel(&m_tree);
+    dock->setWidget(tree);
+    addDockWidget(Qt::LeftDockWidgetArea, dock);
+
+    // Memory use walks the whole map, so edits only schedule it
+    m_memoryTimer.setSingleShot(true);
+    m_memoryTimer.setInterval(MEMORY_STATUS_INTERVAL_MS);
+    connect(&m_memoryTimer, SIGNAL(timeout()), this, SLOT(updateMemoryStatus()));
+    connect(&m_updates, SIGNAL(updated(SceneUpdate)), this, SLOT(scheduleMemoryStatus()));
 }
 //!
 //! \brief MainWindow::~MainWindow
@@ -102,6 +86,108 @@ MainWindow::~MainWindow()
     delete ui;
 }
 //!
+//! \brief MainWindow::createScene makes the scene of a 2D view and connects it up
+//! \param view
+//! \return
+//!
+ViewPortScene *MainWindow::createScene(ViewPortView *view)
+{
+    axis primary = X_AXIS;
+    axis secondary = Y_AXIS;
+    if(view == ui->graphicsView_1) {
+        // Bottom Left
+        primary = Y_AXIS;
+        secondary = Z_AXIS;
+    }
+    else if(view == ui->graphicsView_2) {
+        // Bottom Right
+        primary = X_AXIS;
+        secondary = Z_AXIS;
+    }
+    // Top Right is X/Y
+
+    // The scene reads the rows as they are now, rows still queued would reach it twice
+    m_updates.flush();
+    ViewPortScene *scene = new ViewPortScene(&model, primary, secondary);
+    scene->setParent(this);
+    scene->setSceneRect(0,0,MAX_UNITS,MAX_UNITS);
+    if(ui->actionThreadedRendering->isChecked())
+        scene->setRenderMode(TILED_RENDER);
+    view->setScene(scene);
+
+    // model changes, one batch per event loop tick
+    connect(&m_updates, SIGNAL(updated(SceneUpdate)),
+            scene, SLOT(applyUpdate(SceneUpdate)));
+    connect(view, SIGNAL(scaleChanged(qreal)),scene,SLOT(setScale(qreal)));
+    connect(this, SIGNAL(changeGrid(bool)),scene,SLOT(setGrid(bool)));
+    connect(this, SIGNAL(changeViewPortMode(MOUSE_INTERACT_MODE)),
+            scene, SLOT(setMouseMode(MOUSE_INTERACT_MODE)));
+    connect(this, SIGNAL(changeRenderMode(RENDER_MODE)),
+            scene, SLOT(setRenderMode(RENDER_MODE)));
+
+    // Every view shows the selection, and follows a drag started in another
+    foreach(ViewPortScene *other, m_scenes) {
+        connect(scene, SIGNAL(brushSelectionChanged(QList<int>)),
+                other, SLOT(setBrushSelection(QList<int>)));
+        connect(scene, SIGNAL(ghostMoved(QVector3D)), other, SLOT(setGhostOffset(QVector3D)));
+        connect(other, SIGNAL(brushSelectionChanged(QList<int>)),
+                scene, SLOT(setBrushSelection(QList<int>)));
+        connect(other, SIGNAL(ghostMoved(QVector3D)), scene, SLOT(setGhostOffset(QVector3D)));
+    }
+    if(!m_scenes.isEmpty())
+        scene->setBrushSelection(m_scenes.first()->brushSelection());
+    m_scenes.append(scene);
+    StartupTrace::mark(QString("scene %1").arg(m_scenes.count()));
+    return scene;
+}
+//!
+//! \brief MainWindow::eventFilter makes the scene of a 2D view when it is first shown
+//! \param watched
+//! \param event
+//! \return
+//!
+bool MainWindow::eventFilter(QObject *watched, QEvent *event)
+{
+    if(event->type() == QEvent::Show) {
+        ViewPortView *view = qobject_cast<ViewPortView *>(watched);
+        if(view && !view->scene())
+            createScene(view);
+    }
+    return QMainWindow::eventFilter(watched, event);
+}
+//!
+//! \brief MainWindow::memoryReport
+//! \return what the map, the polygon cache and every 2D view hold
+//!
+MemoryReport MainWindow::memoryReport() const
+{
+    MemoryReport report;
+    model.accountMemory(&report);
+    PolygonCache::global()->accountMemory(&report);
+    foreach(const ViewPortScene *scene, m_scenes)
+        scene->accountMemory(&report);
+    return report;
+}
+//!
+//! \brief MainWindow::updateMemoryStatus shows the memory use in the status bar
+//! The tooltip breaks it down per subsystem.
+//!
+void MainWindow::updateMemoryStatus()
+{
+    MemoryReport report = memoryReport();
+    m_status->setText(report.statusText());
+    m_status->setToolTip(report.summary().join('\n'));
+}
+//!
+//! \brief MainWindow::scheduleMemoryStatus refreshes the memory use once the interval is up
+//! Changes coming in while a refresh is pending are picked up by that one.
+//!
+void MainWindow::scheduleMemoryStatus()
+{
+    if(!m_memoryTimer.isActive())
+        m_memoryTimer.start();
+}
+//!
 //! \brief MainWindow::on_actionGridincrement_triggered
 //!
 void MainWindow::on_actionGridincrement_triggered()
@@ -136,13 +222,57 @@ void MainWindow::on_actionSelect_triggered()
     emit(changeViewPortMode(SELECT));
 }
 //!
+//! \brief MainWindow::on_actionThreadedRendering_toggled
+//! \param checked
+//!
+void MainWindow::on_actionThreadedRendering_toggled(bool checked)
+{
+    emit(changeRenderMode(checked ? TILED_RENDER : DIRECT_RENDER));
+}
+//!
 //! \brief MainWindow::on_actionOpen_triggered
 //!
 void MainWindow::on_actionOpen_triggered()
 {
     QString fileName = QFileDialog::getOpenFileName(this,
-        tr("Open Map)"), ":/vmfs/", tr("Valve Map Files (*.vmf)"));
+        tr("Open Map)"), QString(), tr("Valve Map Files (*.vmf)"));
 
     model.readVMF(fileName);
+    ui->graphicsView->setCamera(model.activeCamera());
+
+}
+//!
+//! \brief MainWindow::on_actionMemoryReport_triggered saves the memory use as JSON
+//!
+void MainWindow::on_actionMemoryReport_triggered()
+{
+    QString fileName = QFileDialog::getSaveFileName(this,
+        tr("Save Memory Report"), "memory.json", tr("JSON Files (*.json)"));
+    if(fileName.isEmpty())
+        return;
 
+    QFile file(fileName);
+    if(!file.open(QIODevice::WriteOnly))
+        return;
+    file.write(QJsonDocument(memoryReport().toJson()).toJson());
+}
+//!
+//! \brief MainWindow::on_actionRecordTrace_toggled starts or stops recording the trace
+//! \param checked
+//!
+void MainWindow::on_actionRecordTrace_toggled(bool checked)
+{
+    Trace::setEnabled(checked);
+}
+//!
+//! \brief MainWindow::on_actionSaveTrace_triggered saves the trace as Chrome trace events
+//!
+void MainWindow::on_actionSaveTrace_triggered()
+{
+    QString fileName = QFileDialog::getSaveFileName(this,
+        tr("Save Trace"), "trace.json", tr("JSON Files (*.json)"));
+    if(fileName.isEmpty())
+        return;
+    if(Trace::writeFile(fileName))
+        qWarning("Could not write %s", qPrintable(fileName));
 }
@@ -18,8 +18,11 @@ along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QLabel>
+#include <QTimer>
 #include "viewportscene.h"
 #include "viewportview.h"
+#include "worldtreemodel.h"
 
 namespace Ui {
 class MainWindow;
@@ -37,14 +40,15 @@ public:
     explicit MainWindow(QWidget *parent = 0);
     ~MainWindow();
 
-    ViewPortScene *m_scene_1;
-    ViewPortScene *m_scene_2;
-    ViewPortScene *m_scene_3;
     Map model;
+    SceneUpdateQueue m_updates; //! Batches the changes to model for the views
+    WorldTreeModel m_tree;      //! The world, its groups, entities and visgroups
+    MemoryReport memoryReport() const;
 
 signals:
     void changeGrid(bool);
     void changeViewPortMode(MOUSE_INTERACT_MODE);
+    void changeRenderMode(RENDER_MODE);
 
 
 private slots:
@@ -55,9 +59,23 @@ private slots:
     void on_actionSelect_triggered();
 
     void on_actionOpen_triggered();
+    void on_actionThreadedRendering_toggled(bool checked);
+    void on_actionMemoryReport_triggered();
+    void on_actionRecordTrace_toggled(bool checked);
+    void on_actionSaveTrace_triggered();
+    void updateMemoryStatus();
+    void scheduleMemoryStatus();
 
 private:
     Ui::MainWindow *ui;
+    QLabel *m_status;               //! Memory use, in the status bar
+    QTimer m_memoryTimer;           //! Refreshes m_status at most once per interval
+    QList<ViewPortScene *> m_scenes; //! In the order the views were first shown
+
+    ViewPortScene *createScene(ViewPortView *view);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event);
 };
 
 #endif // MAINWINDOW_H
@@ -16,6 +16,18 @@ along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "map.h"
+#include "jobsystem.h"
+#include "trace.h"
+
+//!
+//! \brief Map::Map
+//! \param parent
+//!
+Map::Map(QObject *parent)
+    : QObject(parent)
+{
+    m_activecamera = -1;
+}
 
 //!
 //! \brief Map::parseGenericStruct converts generic vmf text stucture into a QStringList
@@ -51,149 +63,317 @@ void Map::parseGenericStruct(QTextStream *txt, QStringList *genericStruct)
         }
     }
 }
+//!
+//! \brief keyValue splits a "key" "value" line of a vmf file
+//! \param line
+//! \return the key and the value, or the line alone if it names a block
+//!
+static QStringList keyValue(QString line) {
+    QStringList list = line.remove("\t").split(QRegularExpression("\""),
+                                               QString::SkipEmptyParts);
+    list.removeAll(" ");
+    return list;
+}
+//!
+//! \brief parsePlane reads the three points of a side
+//! \param value - Like "(-128 32 128) (128 32 128) (128 0 128)"
+//! \return the plane, 0 if the points could not be read
+//!
+static Plane *parsePlane(QString value) {
+    QStringList vertexes = value.remove("(").remove(")").split(" ", QString::SkipEmptyParts);
+    if(vertexes.size() != 9) {
+        qWarning("Invalid .vmf: Incorrect number of points defining a plane");
+        return 0;
+    }
+    float v[9];
+    for(int i = 0; i < 9; i++) {
+        bool ok;
+        v[i] = vertexes.at(i).toFloat(&ok);
+        if(!ok) {
+            qWarning("Invalid .vmf: Vertex in plane not a number");
+            return 0;
+        }
+    }
+    return new Plane(QVector3D(v[0], v[1], v[2]),
+                     QVector3D(v[3], v[4], v[5]),
+                     QVector3D(v[6], v[7], v[8]));
+}
+
+//!
+//! \brief Map::s_solid::s_solid a brush of the world in no group
+//!
+Map::s_solid::s_solid()
+    : id(0), entity(-1), groupid(0)
+{
+}
+//!
+//! \brief Map::s_group::s_group
+//!
+Map::s_group::s_group()
+    : id(0), groupid(0)
+{
+}
+//!
+//! \brief Map::s_entity::s_entity
+//!
+Map::s_entity::s_entity()
+    : id(0), groupid(0)
+{
+}
+
 //!
 //! \brief Map::parseWorld parses the world section of the vmf file
+//!  Solids and groups are read, anything else in the world is skipped.
 //! \param txt
-//! \return
+//! \param solids receives the parsed solids, so they can be added in one batch
+//! \return 1 for error
 //!
-bool Map::parseWorld(QTextStream *txt) {
-    QStringList worldSettings;
+bool Map::parseWorld(QTextStream *txt, QList<s_parsedSolid> *solids) {
     QString line;
-    QList<Plane*> planes;
-    bool open = false;
-
+    int depth = 0;
 
-    qDebug() << "WORLD : MASTER";
+    TRACE_SCOPE(PARSE, "world");
     while (txt->readLineInto(&line)) {
-
-MASTER:
-        qDebug() << line;
-        if(line.remove("\t") == "solid") {
-            planes.clear();
-            goto SOLID;
-        }
-        if(line.remove("\t") == "editor") {
-            planes.clear();
-            goto EDITOR;
-        }
         if(line.contains("{")) {
-            open = true;
+            depth++;
             continue;
         }
         if(line.contains("}")) {
-            open = false;
+            if(--depth == 0)
+                return 0;
+            continue;
         }
-        if(open) {
-            worldSettings.append(line.remove("\t").remove(" ")
-                                 .split(QRegularExpression("\""),
-                                        QString::SkipEmptyParts));
+        if(depth != 1)
+            continue;
+
+        QString name = QString(line).remove("\t");
+        if(name == "solid") {
+            s_parsedSolid solid;
+            if(parseSolid(txt, &solid))
+                return 1;
+            solids->append(solid);
         }
-        else {
-            return 0;
+        else if(name == "group") {
+            s_group group;
+            parseGroup(txt, &group);
+            m_groups.append(group);
         }
     }
-SOLID:
-    qDebug() << "WORLD : SOLID";
+    return 1;
+}
+//!
+//! \brief Map::parseSolid parses a solid, from the line after "solid" to its closing brace
+//!  @verbatim
+//!  solid
+//!  {
+//!     "id" "2"
+//!     side
+//!     {
+//!         "plane" "(x y z) (x y z) (x y z)"
+//!     }
+//!     editor
+//!     {
+//!         "visgroupid" "4"
+//!         "groupid" "6"
+//!     }
+//!  }
+//! The planes are kept as text, addParsedSolids reads them on every core.
+//! \param txt
+//! \param solid receives the plane of every side, the id, group and visgroups
+//! \return 1 for error
+//!
+bool Map::parseSolid(QTextStream *txt, s_parsedSolid *solid) {
+    QString line;
+    int depth = 0;
+
+    TRACE_SCOPE(PARSE, "solid");
     while (txt->readLineInto(&line)) {
-        if(line.remove("\t") == "side") {
-            goto SIDE;
-        }
         if(line.contains("{")) {
-            open = true;
+            depth++;
             continue;
         }
         if(line.contains("}")) {
-            open = false;
+            if(--depth == 0)
+                return 0;
+            continue;
         }
-        if(open) {
-            qDebug() << "id = " << line;
+        QStringList list = keyValue(line);
+        if(depth == 1 && list.size() == 1 && list.at(0) == "editor") {
+            parseEditor(txt, &solid->info.groupid, &solid->info.visgroupids);
         }
-        else {
-            Brush b(planes);
-            m_solids.addSolid(b);
-            goto MASTER;
+        else if(depth == 1 && list.size() == 2 && list.at(0) == "id") {
+            solid->info.id = list.at(1).toInt();
+        }
+        else if(depth == 2 && list.size() == 2 && list.at(0) == "plane") {
+            solid->sides.append(list.at(1));
         }
     }
-SIDE:
-    qDebug() << "WORLD : SIDE";
+    return 1;
+}
+//!
+//! \brief Map::parseEditor parses an editor block, from the line after "editor"
+//! \param txt
+//! \param groupid receives the group, left alone if there is none
+//! \param visgroupids receives every visgroup
+//!
+void Map::parseEditor(QTextStream *txt, int *groupid, QList<int> *visgroupids) {
+    QString line;
+    int depth = 0;
     while (txt->readLineInto(&line)) {
         if(line.contains("{")) {
-            open = true;
+            depth++;
             continue;
         }
         if(line.contains("}")) {
-            open = false;
+            if(--depth == 0)
+                return;
+            continue;
         }
-        if(open) {
-            QStringList list;
-            list.append(line.remove("\t").split(QRegularExpression("\""),
-                                                QString::SkipEmptyParts));
-            list.removeAll(" ");
-
-            if(list.at(0) == "plane") {
-                QString splane = list.at(1);
-                QStringList vertexes;
-                vertexes.append(splane.remove("(").remove(")").split(" "));
-                if(vertexes.size() == 9) {
-                    bool ok;
-                    Plane *p = new Plane(QVector3D(QString(vertexes.at(0)).toInt(&ok),
-                                      QString(vertexes.at(1)).toInt(&ok),
-                                      QString(vertexes.at(2)).toInt(&ok)),
-                            QVector3D(QString(vertexes.at(3)).toInt(&ok),
-                                      QString(vertexes.at(4)).toInt(&ok),
-                                      QString(vertexes.at(5)).toInt(&ok)),
-                            QVector3D(QString(vertexes.at(6)).toInt(&ok),
-                                      QString(vertexes.at(7)).toInt(&ok),
-                                      QString(vertexes.at(8)).toInt(&ok)));
-                    planes.append(p);
-                    if(!ok) {
-                        qWarning("Invalid .vmf: Vertex in plane not int");
-                        return 1;
-                    }
-                }
-                else {
-                    qWarning("Invalid .vmf: Incorrect number of points defining a plane");
-                    return 1;
-                }
-            }
-
+        QStringList list = keyValue(line);
+        if(list.size() != 2)
+            continue;
+        if(list.at(0) == "groupid")
+            *groupid = list.at(1).toInt();
+        else if(list.at(0) == "visgroupid")
+            visgroupids->append(list.at(1).toInt());
+    }
+}
+//!
+//! \brief Map::parseGroup parses a group of the world, from the line after "group"
+//! \param txt
+//! \param group
+//!
+void Map::parseGroup(QTextStream *txt, s_group *group) {
+    QString line;
+    int depth = 0;
+    while (txt->readLineInto(&line)) {
+        if(line.contains("{")) {
+            depth++;
+            continue;
         }
-        else {
-            goto SOLID;
+        if(line.contains("}")) {
+            if(--depth == 0)
+                return;
+            continue;
         }
+        QStringList list = keyValue(line);
+        if(depth != 1)
+            continue;
+        if(list.size() == 1 && list.at(0) == "editor")
+            parseEditor(txt, &group->groupid, &group->visgroupids);
+        else if(list.size() == 2 && list.at(0) == "id")
+            group->id = list.at(1).toInt();
     }
-
-EDITOR:
-    qDebug() << "WORLD : EDITOR";
+}
+//!
+//! \brief Map::parseEntity parses an entity, from the line after "entity"
+//!  The solids of a brush entity go into the same batch as the world's.
+//! \param txt
+//! \param entity
+//! \param solids receives the solids of the entity
+//! \return 1 for error
+//!
+bool Map::parseEntity(QTextStream *txt, s_entity *entity, QList<s_parsedSolid> *solids) {
+    QString line;
+    int depth = 0;
+    TRACE_SCOPE(PARSE, "entity");
     while (txt->readLineInto(&line)) {
         if(line.contains("{")) {
-            open = true;
+            depth++;
             continue;
         }
         if(line.contains("}")) {
-            open = false;
+            if(--depth == 0)
+                return 0;
             continue;
         }
-        if(open) {
-            qDebug() << "EDITOR LINE :  " << line;
+        if(depth != 1)
+            continue;
+        QStringList list = keyValue(line);
+        if(list.size() == 1 && list.at(0) == "solid") {
+            s_parsedSolid solid;
+            if(parseSolid(txt, &solid))
+                return 1;
+            solid.info.entity = m_entities.count();
+            solids->append(solid);
         }
-        else {
-            goto MASTER;
+        else if(list.size() == 1 && list.at(0) == "editor") {
+            parseEditor(txt, &entity->groupid, &entity->visgroupids);
+        }
+        else if(list.size() == 2) {
+            if(list.at(0) == "id")
+                entity->id = list.at(1).toInt();
+            else if(list.at(0) == "classname")
+                entity->classname = list.at(1);
+            else if(list.at(0) == "targetname")
+                entity->targetname = list.at(1);
+            else if(list.at(0) == "origin") {
+                QStringList xyz = list.at(1).split(" ", QString::SkipEmptyParts);
+                if(xyz.size() == 3)
+                    entity->origin = QVector3D(xyz.at(0).toFloat(), xyz.at(1).toFloat(),
+                                               xyz.at(2).toFloat());
+            }
         }
     }
+    return 1;
 }
+//!
+//! \brief Map::addParsedSolids adds the brushes of the file in one batch
+//! The planes are read on the job system, they are the bulk of a file.
+//! Solids with a side that can't be read are left out.
+//! \param parsed
+//!
+void Map::addParsedSolids(const QList<s_parsedSolid> &parsed) {
+    TRACE_SCOPE(LOAD, "addParsedSolids");
+    QVector<QList<Plane*> > planes(parsed.count());
+    // Detach here, the workers only write their own elements
+    QList<Plane*> *out = planes.data();
+    JobSystem::global()->parallelFor(0, parsed.count(), [&parsed, out](int i) {
+        foreach(const QString &side, parsed.at(i).sides) {
+            Plane *plane = parsePlane(side);
+            if(!plane) {
+                qDeleteAll(out[i]);
+                out[i].clear();
+                return;
+            }
+            out[i].append(plane);
+        }
+    });
 
+    QList<Brush> solids;
+    QList<s_solid> infos;
+    for(int i = 0; i < parsed.count(); i++) {
+        if(planes.at(i).isEmpty()) {
+            qWarning("Invalid .vmf: Skipped solid %d", parsed.at(i).info.id);
+            continue;
+        }
+        solids.append(Brush(planes.at(i)));
+        infos.append(parsed.at(i).info);
+    }
+
+    QVector<BrushHandle> handles = m_solids.addSolids(solids);
+    for(int i = 0; i < handles.count(); i++) {
+        m_solidInfo.insert(handles.at(i), infos.at(i));
+        if(infos.at(i).entity >= 0)
+            m_entities[infos.at(i).entity].solids.append(handles.at(i));
+    }
+    if(!handles.isEmpty())
+        emit(solidInfoChanged());
+}
 //!
 //! \brief Map::readVMF
 //! \param filename
 //!
 bool Map::readVMF(const QString &filename) {
+    TRACE_SCOPE(LOAD, "readVMF");
 
     QFile file(filename);
     if (file.open(QFile::ReadOnly)) {
         QTextStream txt(&file);
         QString line;
         QStringList list;
+        QList<s_parsedSolid> solids;
+        s_entity entity;
 
 MASTER:
 
@@ -206,8 +386,14 @@ MASTER:
                 goto VIEWSETTINGS;
             if(line == "world")
                 goto WORLD;
-            return 0;
+            if(line == "cameras")
+                goto CAMERAS;
+            if(line == "entity")
+                goto ENTITY;
+            // Skip anything we don't read yet
         }
+        addParsedSolids(solids);
+        return 0;
 
 VERSION:
         parseGenericStruct(&txt, &list);
@@ -222,8 +408,7 @@ VERSION:
         }
 
 VISGROUPS:
-        parseGenericStruct(&txt, &list);
-        list.clear();
+        parseVisgroups(&txt);
         goto MASTER;
 
 VIEWSETTINGS:
@@ -238,10 +423,173 @@ VIEWSETTINGS:
             return 1;
         }
 
+CAMERAS:
+        parseCameras(&txt);
+        goto MASTER;
+
 WORLD:
-        parseWorld(&txt);
+        if(parseWorld(&txt, &solids))
+            qWarning("Invalid .vmf: Parsing World Failed!");
+        goto MASTER;
+
+ENTITY:
+        entity = s_entity();
+        if(parseEntity(&txt, &entity, &solids))
+            qWarning("Invalid .vmf: Parsing Entity Failed!");
+        m_entities.append(entity);
+        goto MASTER;
+    }
+    return 1;
+}
+//!
+//! \brief Map::parseCameras parses the cameras section of the vmf file
+//!  @verbatim
+//!  cameras
+//!  {
+//!     "activecamera" "0"
+//!     camera
+//!     {
+//!         "position" "[x y z]"
+//!         "look" "[x y z]"
+//!     }
+//!  }
+//! \param txt
+//!
+void Map::parseCameras(QTextStream *txt) {
+    QString line;
+    int depth = 0;
+    m_cameras.clear();
+    while (txt->readLineInto(&line)) {
+        if(line.contains("{")) {
+            if(++depth == 2)
+                m_cameras.append(s_cameras());
+            continue;
+        }
+        if(line.contains("}")) {
+            if(--depth == 0)
+                return;
+            continue;
+        }
+        QStringList list = line.remove("\t").split(QRegularExpression("\""),
+                                                   QString::SkipEmptyParts);
+        list.removeAll(" ");
+        if(list.size() != 2)
+            continue;
+
+        if(depth == 1 && list.at(0) == "activecamera") {
+            m_activecamera = list.at(1).toInt();
+        }
+        else if(depth == 2 && (list.at(0) == "position" || list.at(0) == "look")) {
+            QStringList xyz = QString(list.at(1)).remove("[").remove("]").split(" ");
+            if(xyz.size() != 3) {
+                qWarning("Invalid .vmf: Camera vector does not have 3 components");
+                continue;
+            }
+            QVector3D vector(xyz.at(0).toFloat(), xyz.at(1).toFloat(), xyz.at(2).toFloat());
+            if(list.at(0) == "position")
+                m_cameras.last().position = vector;
+            else
+                m_cameras.last().look = vector;
+        }
+    }
+}
+//!
+//! \brief Map::parseVisgroups parses the visgroups section of the vmf file
+//!  Visgroups can be nested, each one remembers the one it is in.
+//!  @verbatim
+//!  visgroups
+//!  {
+//!     visgroup
+//!     {
+//!         "name" "Trees"
+//!         "visgroupid" "1"
+//!         "color" "r g b"
+//!         visgroup
+//!         {
+//!         }
+//!     }
+//!  }
+//! \param txt
+//!
+void Map::parseVisgroups(QTextStream *txt) {
+    QString line;
+    QList<int> open; // Index of every visgroup being read, innermost last
+    int depth = 0;
+    m_visgroups.clear();
+    while (txt->readLineInto(&line)) {
+        if(line.contains("{")) {
+            if(++depth >= 2) {
+                s_visgroup visgroup;
+                visgroup.id = 0;
+                visgroup.parent = open.isEmpty() ? -1 : open.last();
+                m_visgroups.append(visgroup);
+                open.append(m_visgroups.count() - 1);
+            }
+            continue;
+        }
+        if(line.contains("}")) {
+            if(--depth == 0)
+                return;
+            open.removeLast();
+            continue;
+        }
+        QStringList list = keyValue(line);
+        if(open.isEmpty() || list.size() != 2)
+            continue;
+        s_visgroup &visgroup = m_visgroups[open.last()];
+        if(list.at(0) == "name") {
+            visgroup.name = list.at(1);
+        }
+        else if(list.at(0) == "visgroupid") {
+            visgroup.id = list.at(1).toInt();
+        }
+        else if(list.at(0) == "color") {
+            QStringList rgb = list.at(1).split(" ", QString::SkipEmptyParts);
+            if(rgb.size() == 3)
+                visgroup.color = QColor(rgb.at(0).toInt(), rgb.at(1).toInt(), rgb.at(2).toInt());
+        }
+    }
+}
+//!
+//! \brief Map::activeCamera
+//! \return the camera used for the 3D view, or one at the origin facing North
+//! when the map has none
+//!
+Map::s_cameras Map::activeCamera() const {
+    if(m_activecamera >= 0 && m_activecamera < m_cameras.count())
+        return m_cameras.at(m_activecamera);
+    s_cameras camera;
+    camera.position = QVector3D(0, 0, 0);
+    camera.look = QVector3D(0, 1, 0);
+    return camera;
+}
+//!
+//! \brief Map::accountMemory adds the solids and what the file says about them to a report
+//! \param report
+//!
+void Map::accountMemory(MemoryReport *report) const {
+    m_solids.accountMemory(report);
 
+    // QHash nodes hold a next pointer and the hash next to the key and the value
+    qint64 bytes = qint64(m_solidInfo.capacity()) * sizeof(void *)
+            + qint64(m_solidInfo.count()) * (sizeof(void *) + sizeof(uint) + sizeof(BrushHandle) + sizeof(s_solid));
+    foreach(const s_solid &info, m_solidInfo)
+        bytes += MemoryReport::containerBytes(info.visgroupids);
+    bytes += MemoryReport::containerBytes(m_groups);
+    foreach(const s_group &group, m_groups)
+        bytes += MemoryReport::containerBytes(group.visgroupids);
+    bytes += MemoryReport::containerBytes(m_entities);
+    foreach(const s_entity &entity, m_entities) {
+        bytes += (entity.classname.capacity() + entity.targetname.capacity()) * sizeof(QChar)
+                + MemoryReport::containerBytes(entity.visgroupids)
+                + MemoryReport::containerBytes(entity.solids);
     }
+    bytes += MemoryReport::containerBytes(m_visgroups);
+    foreach(const s_visgroup &visgroup, m_visgroups)
+        bytes += visgroup.name.capacity() * sizeof(QChar);
+    bytes += MemoryReport::containerBytes(m_cameras);
+    report->add(MemoryReport::WORLD_INFO, bytes,
+                m_solidInfo.count() + m_groups.count() + m_entities.count() + m_visgroups.count());
 }
 
 bool Map::populateVersionInfo(QStringList *genericList) {
@@ -18,6 +18,8 @@ along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef MAP_H
 #define MAP_H
 #include <QObject>
+#include <QColor>
+#include <QHash>
 #include "brush.h"
 #include "solids.h"
 
@@ -25,12 +27,8 @@ class Map : public QObject {
 
     Q_OBJECT
 
-    void parseGenericStruct(QTextStream *txt, QStringList *genericStruct);
-    bool parseWorld(QTextStream *txt);
-    bool populateVersionInfo(QStringList *genericList);
-    bool populateViewSettings(QStringList *genericList);
-
 public:
+    Map(QObject *parent = 0);
     bool readVMF(const QString &filename);
     //! versioninfo{}
     struct {
@@ -42,6 +40,13 @@ public:
     } m_versionInfo;
 
     //! visgroups{}
+    struct s_visgroup {
+        QString name;   //! Shown in the list of visgroups.
+        int id;         //! What the visgroupid of solids, groups and entities refers to.
+        int parent;     //! Index in m_visgroups of the visgroup this one is nested in, -1 at the top.
+        QColor color;
+    };
+    QList<s_visgroup> m_visgroups;
 
     //! viewsettings{}
     struct {
@@ -55,7 +60,38 @@ public:
     //! world{}
     Solids m_solids; //! This is a model that holds the blocks
 
+    //! What the editor{} block of a brush says about it
+    struct s_solid {
+        s_solid();
+        int id;         //! The id of the solid in the file.
+        int entity;     //! Index in m_entities of the brush entity it makes up, -1 for the world.
+        int groupid;    //! The group it was grouped into, 0 for none.
+        QList<int> visgroupids;
+    };
+    QHash<BrushHandle, s_solid> m_solidInfo; //! Brushes made in the editor have none
+
+    //!    group{}
+    struct s_group {
+        s_group();
+        int id;
+        int groupid;    //! The group this group is nested in, 0 for none.
+        QList<int> visgroupids;
+    };
+    QList<s_group> m_groups;
+
     //!    entity{}
+    struct s_entity {
+        s_entity();
+        int id;
+        QString classname;
+        QString targetname;
+        QVector3D origin;
+        int groupid;
+        QList<int> visgroupids;
+        QVector<BrushHandle> solids; //! The brushes of a brush entity, none for a point entity.
+    };
+    QList<s_entity> m_entities;
+
     //!    hidden{}
 
     //!    cameras{}
@@ -66,9 +102,33 @@ public:
         QVector3D position; //! The eye position of the camera in the map.
         QVector3D look; //! The position of the camera target -- the point the camera is looking toward.
     };
+    QList<s_cameras> m_cameras;
+    s_cameras activeCamera() const;
+    void accountMemory(MemoryReport *report) const;
 
     //!    cordon{}
 
+signals:
+    void solidInfoChanged();   //! Brushes were added with their entity, group and visgroups
+
+private:
+    //! A solid read from the file, its planes still as text
+    struct s_parsedSolid {
+        QStringList sides;  //! The "plane" value of every side.
+        s_solid info;
+    };
+
+    void parseGenericStruct(QTextStream *txt, QStringList *genericStruct);
+    bool parseWorld(QTextStream *txt, QList<s_parsedSolid> *solids);
+    bool parseSolid(QTextStream *txt, s_parsedSolid *solid);
+    void parseEditor(QTextStream *txt, int *groupid, QList<int> *visgroupids);
+    void parseGroup(QTextStream *txt, s_group *group);
+    bool parseEntity(QTextStream *txt, s_entity *entity, QList<s_parsedSolid> *solids);
+    bool populateVersionInfo(QStringList *genericList);
+    bool populateViewSettings(QStringList *genericList);
+    void parseCameras(QTextStream *txt);
+    void parseVisgroups(QTextStream *txt);
+    void addParsedSolids(const QList<s_parsedSolid> &parsed);
 };
 
 #endif // MAP_H
@@ -0,0 +1,160 @@
+/*
+This file is part of World Editor.
+
+World Editor is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+World Editor is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "memoryreport.h"
+
+//!
+//! \brief MemoryReport::MemoryReport an empty report
+//!
+MemoryReport::MemoryReport()
+{
+    for(int i = 0; i < SUBSYSTEM_COUNT; i++) {
+        m_bytes[i] = 0;
+        m_counts[i] = 0;
+    }
+}
+//!
+//! \brief MemoryReport::add
+//! \param subsystem
+//! \param bytes
+//! \param count - Objects of the kind the subsystem is named after
+//!
+void MemoryReport::add(Subsystem subsystem, qint64 bytes, qint64 count) {
+    m_bytes[subsystem] += bytes;
+    m_counts[subsystem] += count;
+}
+//!
+//! \brief MemoryReport::bytes
+//! \param subsystem
+//! \return
+//!
+qint64 MemoryReport::bytes(Subsystem subsystem) const {
+    return m_bytes[subsystem];
+}
+//!
+//! \brief MemoryReport::count
+//! \param subsystem
+//! \return
+//!
+qint64 MemoryReport::count(Subsystem subsystem) const {
+    return m_counts[subsystem];
+}
+//!
+//! \brief MemoryReport::totalBytes
+//! \return
+//!
+qint64 MemoryReport::totalBytes() const {
+    qint64 total = 0;
+    for(int i = 0; i < SUBSYSTEM_COUNT; i++)
+        total += m_bytes[i];
+    return total;
+}
+//!
+//! \brief MemoryReport::bytesPerBrush
+//! \return everything divided by the number of brushes, 0 without brushes
+//!
+qint64 MemoryReport::bytesPerBrush() const {
+    if(m_counts[BRUSHES] == 0)
+        return 0;
+    return totalBytes() / m_counts[BRUSHES];
+}
+//!
+//! \brief MemoryReport::name
+//! \param subsystem
+//! \return the key of the subsystem in toJson
+//!
+QString MemoryReport::name(Subsystem subsystem) {
+    switch(subsystem) {
+    case BRUSHES:
+        return "brushes";
+    case PLANES:
+        return "planes";
+    case POLYGONS:
+        return "polygons";
+    case HANDLES:
+        return "handles";
+    case WORLD_INFO:
+        return "worldInfo";
+    case SNAPSHOT:
+        return "snapshot";
+    case POLYGON_CACHE:
+        return "polygonCache";
+    case SCENE_GEOMETRY:
+        return "sceneGeometry";
+    case SCENE_ITEMS:
+        return "sceneItems";
+    case GRID_TILES:
+        return "gridTiles";
+    default:
+        return QString();
+    }
+}
+//!
+//! \brief MemoryReport::formatBytes
+//! \param bytes
+//! \return bytes in B, KiB, MiB or GiB
+//!
+QString MemoryReport::formatBytes(qint64 bytes) {
+    if(bytes < 1024)
+        return QString("%1 B").arg(bytes);
+    if(bytes < 1024 * 1024)
+        return QString("%1 KiB").arg(bytes / 1024.0, 0, 'f', 1);
+    if(bytes < qint64(1024) * 1024 * 1024)
+        return QString("%1 MiB").arg(bytes / (1024.0 * 1024), 0, 'f', 1);
+    return QString("%1 GiB").arg(bytes / (1024.0 * 1024 * 1024), 0, 'f', 2);
+}
+//!
+//! \brief MemoryReport::toJson
+//! \return {"totalBytes", "bytesPerBrush", "subsystems": {name: {"bytes", "count"}}}
+//!
+QJsonObject MemoryReport::toJson() const {
+    QJsonObject subsystems;
+    for(int i = 0; i < SUBSYSTEM_COUNT; i++) {
+        QJsonObject values;
+        values["bytes"] = double(m_bytes[i]);
+        values["count"] = double(m_counts[i]);
+        subsystems[name(Subsystem(i))] = values;
+    }
+    QJsonObject json;
+    json["totalBytes"] = double(totalBytes());
+    json["bytesPerBrush"] = double(bytesPerBrush());
+    json["subsystems"] = subsystems;
+    return json;
+}
+//!
+//! \brief MemoryReport::summary
+//! \return a line for every subsystem, then the total
+//!
+QStringList MemoryReport::summary() const {
+    QStringList lines;
+    for(int i = 0; i < SUBSYSTEM_COUNT; i++) {
+        lines << QString("%1 %2 %3")
+                 .arg(name(Subsystem(i)), -14)
+                 .arg(formatBytes(m_bytes[i]), 10)
+                 .arg(m_counts[i], 9);
+    }
+    lines << QString("%1 %2").arg("total", -14).arg(formatBytes(totalBytes()), 10);
+    return lines;
+}
+//!
+//! \brief MemoryReport::statusText
+//! \return one line for the status bar
+//!
+QString MemoryReport::statusText() const {
+    return QString("Memory: %1, %2 per brush")
+            .arg(formatBytes(totalBytes()), formatBytes(bytesPerBrush()));
+}
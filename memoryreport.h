@@ -0,0 +1,96 @@
+/*
+This file is part of World Editor.
+
+World Editor is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+World Editor is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MEMORYREPORT_H
+#define MEMORYREPORT_H
+
+#include <QJsonObject>
+#include <QList>
+#include <QStringList>
+#include <QVector>
+
+//!
+//! \brief The MemoryReport class adds up the memory held by each part of the editor
+//! Every part reports its own containers through an accountMemory method.
+//! Sizes are estimates from the capacity of the containers and the size of
+//! what they hold, without the allocator's own overhead.
+//!
+class MemoryReport
+{
+public:
+    enum Subsystem {
+        BRUSHES,        //! Brush objects, their plane lists and shared state
+        PLANES,         //! Plane objects
+        POLYGONS,       //! Brushes polygonised for the 2D views by Solids
+        HANDLES,        //! Handle to row tables of Solids
+        WORLD_INFO,     //! Entities, groups, visgroups and what each brush belongs to
+        SNAPSHOT,       //! Chunks of the published Solids snapshot
+        POLYGON_CACHE,  //! The PolygonCache
+        SCENE_GEOMETRY, //! Flat brush arrays of the 2D views
+        SCENE_ITEMS,    //! QGraphicsItems of the 2D views
+        GRID_TILES,     //! Pre-rendered grid tiles of the 2D views
+        SUBSYSTEM_COUNT
+    };
+
+private:
+    qint64 m_bytes[SUBSYSTEM_COUNT];
+    qint64 m_counts[SUBSYSTEM_COUNT];
+
+public:
+    MemoryReport();
+    void add(Subsystem subsystem, qint64 bytes, qint64 count = 0);
+    qint64 bytes(Subsystem subsystem) const;
+    qint64 count(Subsystem subsystem) const;
+    qint64 totalBytes() const;
+    qint64 bytesPerBrush() const;
+
+    static QString name(Subsystem subsystem);
+    static QString formatBytes(qint64 bytes);
+    QJsonObject toJson() const;
+    QStringList summary() const;
+    QString statusText() const;
+
+    template<typename T>
+    static qint64 containerBytes(const QVector<T> &vector);
+    template<typename T>
+    static qint64 containerBytes(const QList<T> &list);
+};
+
+//!
+//! \brief MemoryReport::containerBytes
+//! \param vector
+//! \return the header and the whole capacity of the vector
+//!
+template<typename T>
+qint64 MemoryReport::containerBytes(const QVector<T> &vector) {
+    return sizeof(QArrayData) + qint64(vector.capacity()) * sizeof(T);
+}
+//!
+//! \brief MemoryReport::containerBytes
+//! A QList holds pointers, and items larger than a pointer each in a block of their own.
+//! \param list
+//! \return
+//!
+template<typename T>
+qint64 MemoryReport::containerBytes(const QList<T> &list) {
+    qint64 bytes = sizeof(QListData::Data) + qint64(list.size()) * sizeof(void *);
+    if(QTypeInfo<T>::isLarge || QTypeInfo<T>::isStatic)
+        bytes += qint64(list.size()) * sizeof(T);
+    return bytes;
+}
+
+#endif // MEMORYREPORT_H
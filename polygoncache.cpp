@@ -0,0 +1,136 @@
+/*
+This file is part of World Editor.
+
+World Editor is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+World Editor is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "polygoncache.h"
+#include "polygoniser.h"
+
+//!
+//! \brief PolygonCache::PolygonCache
+//! \param maxCost maximum number of points held before evicting
+//!
+PolygonCache::PolygonCache(int maxCost)
+    : m_cache(maxCost), m_hits(0), m_misses(0), m_invalidations(0)
+{
+}
+//!
+//! \brief PolygonCache::global
+//! \return the cache used by Brush::polygonise
+//!
+PolygonCache *PolygonCache::global() {
+    static PolygonCache cache;
+    return &cache;
+}
+//!
+//! \brief PolygonCache::polygons returns the brush projected in a 2D view
+//! Polygonises the brush if it is not cached or the cached entry is stale.
+//! \param brush
+//! \param primary - The arbitrary horizontal axis in a 2D view
+//! \param secondary - The arbitrary vertical axis in a 2D view
+//! \return
+//!
+QList<QPolygonF> PolygonCache::polygons(const Brush &brush, axis primary, axis secondary) {
+    PolygonCacheKey key = { brush.getId(), primary, secondary };
+    int revision = brush.getRevision();
+    {
+        QMutexLocker locker(&m_mutex);
+        Entry *entry = m_cache.object(key);
+        if(entry && entry->revision == revision) {
+            m_hits++;
+            return entry->polygons;
+        }
+        m_misses++;
+    }
+
+    // Polygonise without holding the lock so other threads can carry on
+    Entry *entry = new Entry;
+    entry->revision = revision;
+    entry->polygons = Polygoniser::poligonise(&brush, primary, secondary);
+    QList<QPolygonF> result = entry->polygons;
+
+    int cost = 1;
+    foreach(const QPolygonF &poly, result)
+        cost += poly.size();
+
+    QMutexLocker locker(&m_mutex);
+    m_cache.insert(key, entry, cost);
+    return result;
+}
+//!
+//! \brief PolygonCache::invalidate drops every entry of a brush
+//! \param brushId
+//!
+void PolygonCache::invalidate(quint64 brushId) {
+    QMutexLocker locker(&m_mutex);
+    for(int primary = X_AXIS; primary <= Z_AXIS; primary++) {
+        for(int secondary = X_AXIS; secondary <= Z_AXIS; secondary++) {
+            PolygonCacheKey key = { brushId, primary, secondary };
+            if(m_cache.remove(key))
+                m_invalidations++;
+        }
+    }
+}
+//!
+//! \brief PolygonCache::clear
+//!
+void PolygonCache::clear() {
+    QMutexLocker locker(&m_mutex);
+    m_cache.clear();
+}
+//!
+//! \brief PolygonCache::setMaxCost evicts entries if the cache is now too big
+//! \param maxCost
+//!
+void PolygonCache::setMaxCost(int maxCost) {
+    QMutexLocker locker(&m_mutex);
+    m_cache.setMaxCost(maxCost);
+}
+//!
+//! \brief PolygonCache::statistics
+//! \return
+//!
+PolygonCache::Statistics PolygonCache::statistics() const {
+    QMutexLocker locker(&m_mutex);
+    Statistics stats;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.invalidations = m_invalidations;
+    stats.entries = m_cache.count();
+    stats.totalCost = m_cache.totalCost();
+    stats.maxCost = m_cache.maxCost();
+    return stats;
+}
+//!
+//! \brief PolygonCache::accountMemory adds the cached polygons to a report
+//! The points come from the cost, the lists and the cache nodes are estimated per entry.
+//! \param report
+//!
+void PolygonCache::accountMemory(MemoryReport *report) const {
+    QMutexLocker locker(&m_mutex);
+    const qint64 perEntry = sizeof(Entry) + sizeof(PolygonCacheKey) + 6 * sizeof(void *);
+    report->add(MemoryReport::POLYGON_CACHE,
+                qint64(m_cache.totalCost()) * sizeof(QPointF) + m_cache.count() * perEntry,
+                m_cache.count());
+}
+//!
+//! \brief PolygonCache::resetStatistics
+//!
+void PolygonCache::resetStatistics() {
+    QMutexLocker locker(&m_mutex);
+    m_hits = 0;
+    m_misses = 0;
+    m_invalidations = 0;
+}
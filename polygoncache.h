@@ -0,0 +1,87 @@
+/*
+This file is part of World Editor.
+
+World Editor is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+World Editor is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef POLYGONCACHE_H
+#define POLYGONCACHE_H
+
+#include <QCache>
+#include <QMutex>
+#include <QPolygonF>
+#include "brush.h"
+
+//!
+//! \brief The PolygonCacheKey struct identifies a brush projected in a 2D view
+//!
+struct PolygonCacheKey
+{
+    quint64 brushId;
+    int primary;
+    int secondary;
+};
+
+inline bool operator==(const PolygonCacheKey &a, const PolygonCacheKey &b) {
+    return a.brushId == b.brushId && a.primary == b.primary && a.secondary == b.secondary;
+}
+
+inline uint qHash(const PolygonCacheKey &key, uint seed = 0) {
+    return qHash(key.brushId, seed) ^ uint(key.primary << 4 | key.secondary);
+}
+
+//!
+//! \brief The PolygonCache class remembers projected polygons between calls
+//! Entries are keyed by brush and axis pair, dropped when the brush's planes
+//! change and evicted least recently used first once the cache is full.
+//! The cost of an entry is the number of points it holds.
+//!
+class PolygonCache
+{
+public:
+    //! Counters for instrumentation
+    struct Statistics {
+        quint64 hits;
+        quint64 misses;
+        quint64 invalidations;
+        int entries;
+        int totalCost;
+        int maxCost;
+    };
+
+    explicit PolygonCache(int maxCost = 4*1024*1024);
+    static PolygonCache *global();
+
+    QList<QPolygonF> polygons(const Brush &brush, axis primary, axis secondary);
+    void invalidate(quint64 brushId);
+    void clear();
+    void setMaxCost(int maxCost);
+    Statistics statistics() const;
+    void resetStatistics();
+    void accountMemory(MemoryReport *report) const;
+
+private:
+    struct Entry {
+        int revision;               //! Brush revision the polygons were made at
+        QList<QPolygonF> polygons;
+    };
+
+    mutable QMutex m_mutex;
+    QCache<PolygonCacheKey, Entry> m_cache;
+    quint64 m_hits;
+    quint64 m_misses;
+    quint64 m_invalidations;
+};
+
+#endif // POLYGONCACHE_H
@@ -19,10 +19,13 @@ along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
  *
 */
 
+#include <algorithm>
 #include "polygoniser.h"
+#include "jobsystem.h"
+#include "trace.h"
 
-//! first point.
-static QPointF p0;
+//! first point, one per thread so brushes can be polygonised in parallel
+static thread_local QPointF p0;
 
 //!
 //! \brief Polygoniser::turns a list of points into a convex polygon
@@ -52,16 +55,18 @@ bool Polygoniser::planesConnected(QVector3D u)
 }
 
 //!
-//! \brief Polygoniser::poligonise
+//! \brief Polygoniser::windings works out which points belong to each face of a brush
+//! This is the expensive part of polygonising a brush, it does not depend on
+//! the 2D view so it is done once in 3D and cached by the brush.
 //! \param brush
-//! \return
+//! \return one winding per plane of the brush
 //!
-QList<QPolygonF> Polygoniser::poligonise(Brush *brush, axis primary, axis secondary) {
-    QList<QPolygonF> polygons;
-    QList<Plane*> planes = brush->getPlanes();
+QList<Winding> Polygoniser::windings(const Brush *brush) {
+    QList<Winding> windings;
+    const QList<Plane*> &planes = brush->getPlanes();
     foreach(Plane *pla1, planes) {
         // List of points that intersect the plane
-        QVector<QPointF> list;
+        Winding list;
         foreach(Plane *pla2, planes) {
 
             QVector3D crossProduct = QVector3D::crossProduct(
@@ -78,38 +83,331 @@ QList<QPolygonF> Polygoniser::poligonise(Brush *brush, axis primary, axis second
             if(pla2->getBotLeft().distanceToPlane(pla1->getBotLeft(),
                                                   pla1->getTopLeft(),
                                                   pla1->getTopRight()) < 0.5)
-                list.append(toPointF(pla2->getBotLeft(), primary, secondary));
+                list.append(pla2->getBotLeft());
 
             if(pla2->getTopLeft().distanceToPlane(pla1->getBotLeft(),
                                                   pla1->getTopLeft(),
                                                   pla1->getTopRight()) < 0.5)
-                list.append(toPointF(pla2->getTopLeft(), primary, secondary));
+                list.append(pla2->getTopLeft());
 
             if(pla2->getTopRight().distanceToPlane(pla1->getBotLeft(),
                                                    pla1->getTopLeft(),
                                                    pla1->getTopRight()) < 0.5)
-                list.append(toPointF(pla2->getTopRight(), primary, secondary));
+                list.append(pla2->getTopRight());
         }
 
-        list.append(toPointF(pla1->getBotLeft(),primary,secondary));
-        list.append(toPointF(pla1->getTopLeft(),primary,secondary));
-        list.append(toPointF(pla1->getTopRight(),primary,secondary));
+        list.append(pla1->getBotLeft());
+        list.append(pla1->getTopLeft());
+        list.append(pla1->getTopRight());
 
         // Remove any duplicates
-        if(!list.empty()) {
-            foreach(QPointF point, list) {
-                if(list.contains(point)) {
-                    list.removeAll(point);
-                    list.append(point);
-                }
+        foreach(QVector3D point, list) {
+            if(list.contains(point)) {
+                list.removeAll(point);
+                list.append(point);
             }
-
-            polygons.append( convexHull(list) );
         }
+        windings.append(list);
+    }
+    return windings;
+}
+//!
+//! \brief Polygoniser::project flattens 3D face windings into polygons in a 2D view
+//! \param windings
+//! \param primary - The arbitrary horizontal axis in a 2D view
+//! \param secondary - The arbitrary vertical axis in a 2D view
+//! \return
+//!
+QList<QPolygonF> Polygoniser::project(const QList<Winding> &windings, axis primary, axis secondary) {
+    QList<QPolygonF> polygons;
+    foreach(const Winding &winding, windings) {
+        QVector<QPointF> list;
+        foreach(QVector3D vertex, winding) {
+            // Points which differ only in the hidden axis end up on top of each other
+            QPointF point = toPointF(vertex, primary, secondary);
+            if(!list.contains(point))
+                list.append(point);
+        }
+        if(!list.empty())
+            polygons.append( convexHull(list) );
     }
     return polygons;
 }
 //!
+//! \brief Polygoniser::poligonise
+//! \param brush
+//! \return
+//!
+QList<QPolygonF> Polygoniser::poligonise(const Brush *brush, axis primary, axis secondary) {
+    return project(brush->getWindings(), primary, secondary);
+}
+//!
+//! \brief PolygonArena::clear empties the arena but keeps its memory
+//!
+void PolygonArena::clear() {
+    points.resize(0);
+    offsets.resize(0);
+    counts.resize(0);
+    brushOffsets.resize(0);
+    brushCounts.resize(0);
+}
+//!
+//! \brief PolygonArena::append adds the polygons of one brush
+//! \param polygons
+//! \param transform optionally applied to every point
+//!
+void PolygonArena::append(const QList<QPolygonF> &polygons, const QTransform *transform) {
+    brushOffsets.append(counts.size());
+    brushCounts.append(polygons.size());
+    foreach(const QPolygonF &poly, polygons) {
+        offsets.append(points.size());
+        counts.append(poly.size());
+        if (transform) {
+            for (int i = 0; i < poly.size(); i++)
+                points.append(transform->map(poly.at(i)));
+        }
+        else {
+            points += poly;
+        }
+    }
+}
+//!
+//! \brief PolygonArena::append adds every brush of another arena after these
+//! \param other
+//!
+void PolygonArena::append(const PolygonArena &other) {
+    const int pointBase = points.size();
+    const int polygonBase = counts.size();
+    points += other.points;
+    counts += other.counts;
+    brushCounts += other.brushCounts;
+    offsets.reserve(offsets.size() + other.offsets.size());
+    foreach(int offset, other.offsets)
+        offsets.append(pointBase + offset);
+    brushOffsets.reserve(brushOffsets.size() + other.brushOffsets.size());
+    foreach(int offset, other.brushOffsets)
+        brushOffsets.append(polygonBase + offset);
+}
+//!
+//! \brief PolygonArena::polygonCount
+//! \return
+//!
+int PolygonArena::polygonCount() const {
+    return counts.size();
+}
+//!
+//! \brief PolygonArena::brushCount
+//! \return
+//!
+int PolygonArena::brushCount() const {
+    return brushCounts.size();
+}
+//!
+//! \brief PolygonArena::polygon copies one polygon out of the arena
+//! \param i
+//! \return
+//!
+QPolygonF PolygonArena::polygon(int i) const {
+    return QPolygonF(points.mid(offsets.at(i), counts.at(i)));
+}
+//!
+//! \brief PolygoniserScratch::reserve makes room for a brush with this many planes
+//! A face can't have more points than three per plane.
+//! \param planes
+//!
+void PolygoniserScratch::reserve(int planes) {
+    vertexes.resize(planes*3);
+    normals.resize(planes);
+    points.resize(planes*3);
+}
+
+//!
+//! \brief turn orientation of an ordered triplet, like Polygoniser::orientation
+//! but without truncating to int so large coordinates can't overflow
+//! \return 0 colinear, 1 clockwise, 2 counterclockwise
+//!
+static inline int turn(const QPointF &p, const QPointF &q, const QPointF &r)
+{
+    qreal val = (q.y() - p.y()) * (r.x() - q.x()) -
+            (q.x() - p.x()) * (r.y() - q.y());
+
+    if (val == 0) return 0;
+    return (val > 0)? 1: 2;
+}
+
+//!
+//! \brief hullInPlace Graham scan that works inside the array it is given
+//! The points have to be sorted bottom-most then left-most and be unique.
+//! The stack lives at the front of the array, it never overtakes the read position.
+//! \param points
+//! \param n
+//! \return number of points at the front of the array forming the polygon
+//!
+static int hullInPlace(QPointF *points, int n)
+{
+    if (n < 3)
+        return n;
+
+    const QPointF p0 = points[0];
+    std::sort(points + 1, points + n, [&p0](const QPointF &a, const QPointF &b) {
+        int o = turn(p0, a, b);
+        if (o == 0) {
+            QPointF da = a - p0;
+            QPointF db = b - p0;
+            return QPointF::dotProduct(da, da) < QPointF::dotProduct(db, db);
+        }
+        return o == 2;
+    });
+
+    // Keep only the farthest of the points making the same angle with p0
+    int m = 1;
+    for (int i = 1; i < n; i++) {
+        while (i < n-1 && turn(p0, points[i], points[i+1]) == 0)
+            i++;
+        points[m++] = points[i];
+    }
+    if (m < 3)
+        return m;
+
+    int top = 2;
+    for (int i = 3; i < m; i++) {
+        while (top > 0 && turn(points[top-1], points[top], points[i]) != 2)
+            top--;
+        points[++top] = points[i];
+    }
+    return top + 1;
+}
+
+//!
+//! \brief Polygoniser::poligonise polygonises a brush without allocating per face
+//! The planes are copied into the scratch buffers once, each face is built in
+//! place, de-duplicated by sort and unique, and its polygon is appended to the arena.
+//! Once the scratch and the arena are big enough no more memory is allocated.
+//! \param brush
+//! \param primary - The arbitrary horizontal axis in a 2D view
+//! \param secondary - The arbitrary vertical axis in a 2D view
+//! \param scratch working memory, reuse it between calls
+//! \param arena receives one polygon per plane
+//! \param transform optionally applied to every point on its way into the arena
+//!
+void Polygoniser::poligonise(const Brush *brush, axis primary, axis secondary,
+                             PolygoniserScratch *scratch, PolygonArena *arena,
+                             const QTransform *transform) {
+    const QList<Plane*> &planes = brush->getPlanes();
+    const int n = planes.size();
+    scratch->reserve(n);
+
+    QVector3D *vertexes = scratch->vertexes.data();
+    QVector3D *normals = scratch->normals.data();
+    QPointF *points = scratch->points.data();
+
+    for (int i = 0; i < n; i++) {
+        const Plane *pla = planes.at(i);
+        vertexes[i*3] = pla->getBotLeft();
+        vertexes[i*3+1] = pla->getTopLeft();
+        vertexes[i*3+2] = pla->getTopRight();
+        // Same normal QVector3D::distanceToPlane works out for every call
+        normals[i] = QVector3D::normal(vertexes[i*3+1] - vertexes[i*3],
+                                       vertexes[i*3+2] - vertexes[i*3]);
+    }
+
+    arena->brushOffsets.append(arena->counts.size());
+    arena->brushCounts.append(n);
+
+    for (int i = 0; i < n; i++) {
+        int count = 0;
+        for (int j = 0; j < n; j++) {
+            // If the planes are parrallel dont bother...
+            if (!planesConnected(QVector3D::crossProduct(normals[i], normals[j])))
+                continue;
+            for (int k = 0; k < 3; k++) {
+                const QVector3D &vertex = vertexes[j*3+k];
+                if (QVector3D::dotProduct(vertex - vertexes[i*3], normals[i]) < 0.5)
+                    points[count++] = toPointF(vertex, primary, secondary);
+            }
+        }
+        for (int k = 0; k < 3; k++)
+            points[count++] = toPointF(vertexes[i*3+k], primary, secondary);
+
+        // Remove any duplicates, the sort also puts the bottom-most point first
+        std::sort(points, points + count, [](const QPointF &a, const QPointF &b) {
+            return a.y() < b.y() || (a.y() == b.y() && a.x() < b.x());
+        });
+        count = std::unique(points, points + count) - points;
+
+        count = hullInPlace(points, count);
+        arena->offsets.append(arena->points.size());
+        arena->counts.append(count);
+        if (transform) {
+            for (int k = 0; k < count; k++)
+                arena->points.append(transform->map(points[k]));
+        }
+        else {
+            for (int k = 0; k < count; k++)
+                arena->points.append(points[k]);
+        }
+    }
+}
+//!
+//! \brief Polygoniser::poligoniseBatch polygonises a range of brushes into one arena
+//! Renderers and exporters can read the flat buffers directly, and passing the
+//! scene transform saves them copying every polygon again to place it.
+//! \param brushes
+//! \param first first brush of the range
+//! \param last last brush of the range, inclusive
+//! \param primary - The arbitrary horizontal axis in a 2D view
+//! \param secondary - The arbitrary vertical axis in a 2D view
+//! \param arena the polygons are appended to it
+//! \param transform optionally applied to every point
+//!
+void Polygoniser::poligoniseBatch(const QList<Brush> &brushes, int first, int last,
+                                  axis primary, axis secondary, PolygonArena *arena,
+                                  const QTransform *transform) {
+    PolygoniserScratch scratch;
+    for (int i = first; i <= last; i++)
+        poligonise(&brushes.at(i), primary, secondary, &scratch, arena, transform);
+}
+//!
+//! \brief Polygoniser::viewIndex index of a 2D view in ProjectedPolygons
+//! \param primary - The arbitrary horizontal axis in a 2D view
+//! \param secondary - The arbitrary vertical axis in a 2D view
+//! \return 0 for Y/Z, 1 for X/Z, 2 for X/Y, -1 if the pair is not one of those views
+//!
+int Polygoniser::viewIndex(axis primary, axis secondary) {
+    if(primary >= secondary)
+        return -1;
+    return 3 - primary - secondary;
+}
+//!
+//! \brief Polygoniser::poligoniseViews polygonises a brush for the Y/Z, X/Z and X/Y views
+//! \param brush
+//! \return
+//!
+ProjectedPolygons Polygoniser::poligoniseViews(const Brush &brush) {
+    // The windings are worked out once and shared by the three views
+    QList<Winding> faces = brush.getWindings();
+    ProjectedPolygons result;
+    result.views[viewIndex(Y_AXIS, Z_AXIS)] = project(faces, Y_AXIS, Z_AXIS);
+    result.views[viewIndex(X_AXIS, Z_AXIS)] = project(faces, X_AXIS, Z_AXIS);
+    result.views[viewIndex(X_AXIS, Y_AXIS)] = project(faces, X_AXIS, Y_AXIS);
+    return result;
+}
+//!
+//! \brief Polygoniser::poligoniseAll polygonises a batch of brushes on the global job system
+//! \param brushes
+//! \return one ProjectedPolygons per brush, in the same order as the input
+//!
+QVector<ProjectedPolygons> Polygoniser::poligoniseAll(const QList<Brush> &brushes) {
+    TRACE_SCOPE(POLYGONISE, "poligoniseAll");
+    QVector<ProjectedPolygons> result(brushes.count());
+    // Detach here, the workers only write their own elements
+    ProjectedPolygons *out = result.data();
+    JobSystem::global()->parallelFor(0, brushes.count(), [&brushes, out](int i) {
+        out[i] = poligoniseViews(brushes.at(i));
+    });
+    return result;
+}
+//!
 //! \brief Polygoniser::nextToTop next to top in a stack of points
 //! A utility function to find next to top in a stack of points
 //! \param S Stack of points
@@ -6,9 +6,52 @@
 #include <QPolygonF>
 #include <QVector3D>
 #include <QStack>
+#include <QTransform>
 #include <QDebug>
 
 #include "brush.h"
+
+//!
+//! \brief The ProjectedPolygons struct holds a brush polygonised in all three 2D views
+//!
+struct ProjectedPolygons
+{
+    QList<QPolygonF> views[3]; //! Indexed by Polygoniser::viewIndex
+};
+
+//!
+//! \brief The PolygonArena struct holds many polygons back to back in flat buffers
+//! Clearing it keeps its memory, so it can be refilled without allocating.
+//!
+struct PolygonArena
+{
+    QVector<QPointF> points;    //! The points of every polygon
+    QVector<int> offsets;       //! Index in points of the first point of each polygon
+    QVector<int> counts;        //! Number of points in each polygon
+    QVector<int> brushOffsets;  //! Index of the first polygon of each brush
+    QVector<int> brushCounts;   //! Number of polygons of each brush
+
+    void clear();
+    void append(const QList<QPolygonF> &polygons, const QTransform *transform = 0);
+    void append(const PolygonArena &other);
+    int polygonCount() const;
+    int brushCount() const;
+    QPolygonF polygon(int i) const;
+};
+
+//!
+//! \brief The PolygoniserScratch struct is reusable working memory for the polygoniser
+//! It grows to fit the brush with the most planes and then stays that size.
+//!
+struct PolygoniserScratch
+{
+    QVector<QVector3D> vertexes;    //! The three points of each plane
+    QVector<QVector3D> normals;     //! The normal of each plane
+    QVector<QPointF> points;        //! The points of the face being built
+
+    void reserve(int planes);
+};
+
 //!
 //! \brief The Polygoniser class
 //!
@@ -24,7 +67,18 @@ class Polygoniser
 
 public:
    static QPolygonF poligonise(QVector<QPointF> points);
-   static QList<QPolygonF> poligonise(Brush *brush, axis primary, axis secondary);
+   static QList<QPolygonF> poligonise(const Brush *brush, axis primary, axis secondary);
+   static void poligonise(const Brush *brush, axis primary, axis secondary,
+                          PolygoniserScratch *scratch, PolygonArena *arena,
+                          const QTransform *transform = 0);
+   static void poligoniseBatch(const QList<Brush> &brushes, int first, int last,
+                               axis primary, axis secondary, PolygonArena *arena,
+                               const QTransform *transform = 0);
+   static QList<Winding> windings(const Brush *brush);
+   static QList<QPolygonF> project(const QList<Winding> &windings, axis primary, axis secondary);
+   static ProjectedPolygons poligoniseViews(const Brush &brush);
+   static QVector<ProjectedPolygons> poligoniseAll(const QList<Brush> &brushes);
+   static int viewIndex(axis primary, axis secondary);
 
 };
 
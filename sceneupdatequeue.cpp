@@ -0,0 +1,179 @@
+/*
+This file is part of World Editor.
+
+World Editor is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+World Editor is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include "sceneupdatequeue.h"
+#include "solids.h"
+
+//!
+//! \brief SceneUpdate::SceneUpdate
+//!
+SceneUpdate::SceneUpdate()
+    : reset(false), firstInserted(-1)
+{
+}
+//!
+//! \brief SceneUpdate::isEmpty
+//! \return
+//!
+bool SceneUpdate::isEmpty() const {
+    return !reset && removed.isEmpty() && firstInserted < 0 && changed.isEmpty();
+}
+//!
+//! \brief SceneUpdate::clear
+//!
+void SceneUpdate::clear() {
+    reset = false;
+    removed.resize(0);
+    firstInserted = -1;
+    changed.resize(0);
+}
+
+//!
+//! \brief SceneUpdateQueue::SceneUpdateQueue
+//! \param model
+//! \param parent
+//!
+SceneUpdateQueue::SceneUpdateQueue(QAbstractItemModel *model, QObject *parent)
+    : QObject(parent), m_model(model)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setInterval(0);
+    connect(&m_timer, SIGNAL(timeout()), this, SLOT(flush()));
+
+    connect(model, SIGNAL(rowsInserted(QModelIndex,int,int)),
+            this, SLOT(rowsInserted(QModelIndex,int,int)));
+    connect(model, SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)),
+            this, SLOT(rowsAboutToBeRemoved(QModelIndex,int,int)));
+    connect(model, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)),
+            this, SLOT(modelReset()));
+    connect(model, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+            this, SLOT(dataChanged(QModelIndex,QModelIndex)));
+    // Solids only changes its layout to move rows it is about to remove to
+    // the end, the others keep their order
+    connect(model, SIGNAL(layoutAboutToBeChanged()), this, SLOT(layoutAboutToBeChanged()));
+    connect(model, SIGNAL(modelReset()), this, SLOT(modelReset()));
+}
+//!
+//! \brief SceneUpdateQueue::isPending
+//! \return true if changes are waiting for the next batch
+//!
+bool SceneUpdateQueue::isPending() const {
+    return !m_pending.isEmpty();
+}
+//!
+//! \brief SceneUpdateQueue::schedule flushes once control returns to the event loop
+//!
+void SceneUpdateQueue::schedule() {
+    if(!m_timer.isActive())
+        m_timer.start();
+}
+//!
+//! \brief SceneUpdateQueue::flush sends the pending changes now
+//!
+void SceneUpdateQueue::flush() {
+    m_timer.stop();
+    if(m_pending.isEmpty())
+        return;
+
+    SceneUpdate update = m_pending;
+    m_pending.clear();
+    if(update.reset) {
+        update.removed.resize(0);
+        update.firstInserted = -1;
+        update.changed.resize(0);
+    }
+    else {
+        std::sort(update.changed.begin(), update.changed.end());
+        update.changed.erase(std::unique(update.changed.begin(), update.changed.end()),
+                             update.changed.end());
+    }
+    emit(updated(update));
+}
+//!
+//! \brief SceneUpdateQueue::flushRows sends the changed and inserted rows before the
+//! model renumbers them
+//!
+void SceneUpdateQueue::flushRows() {
+    if(m_pending.firstInserted >= 0 || !m_pending.changed.isEmpty())
+        flush();
+}
+//!
+//! \brief SceneUpdateQueue::rowsInserted
+//! Rows appended at the end leave the others in place, anything else moves them.
+//! \param parent
+//! \param first
+//! \param last
+//!
+void SceneUpdateQueue::rowsInserted(const QModelIndex &parent, int first, int last) {
+    if(last != m_model->rowCount(parent) - 1)
+        m_pending.reset = true;
+    else if(m_pending.firstInserted < 0 || first < m_pending.firstInserted)
+        m_pending.firstInserted = first;
+    schedule();
+}
+//!
+//! \brief SceneUpdateQueue::rowsAboutToBeRemoved keeps the handles of the rows
+//! Removing every row is sent as a reset, there is nothing left to keep.
+//! \param parent
+//! \param first
+//! \param last
+//!
+void SceneUpdateQueue::rowsAboutToBeRemoved(const QModelIndex &parent, int first, int last) {
+    if(m_pending.reset)
+        return;
+    flushRows();
+    if(first == 0 && last == m_model->rowCount(parent) - 1) {
+        m_pending.reset = true;
+    }
+    else {
+        m_pending.removed.reserve(m_pending.removed.size() + last - first + 1);
+        for(int row = first; row <= last; row++)
+            m_pending.removed.append(m_model->index(row, 0, parent).data(Solids::HandleRole).toInt());
+    }
+    schedule();
+}
+//!
+//! \brief SceneUpdateQueue::layoutAboutToBeChanged
+//!
+void SceneUpdateQueue::layoutAboutToBeChanged() {
+    if(!m_pending.reset)
+        flushRows();
+}
+//!
+//! \brief SceneUpdateQueue::dataChanged
+//! Rows inserted in the same batch are read whole anyway, so they are skipped.
+//! \param topLeft
+//! \param bottomRight
+//!
+void SceneUpdateQueue::dataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight) {
+    if(m_pending.reset)
+        return;
+    int last = bottomRight.row();
+    if(m_pending.firstInserted >= 0)
+        last = qMin(last, m_pending.firstInserted - 1);
+    for(int row = topLeft.row(); row <= last; row++)
+        m_pending.changed.append(row);
+    schedule();
+}
+//!
+//! \brief SceneUpdateQueue::modelReset
+//!
+void SceneUpdateQueue::modelReset() {
+    m_pending.reset = true;
+    schedule();
+}
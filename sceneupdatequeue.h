@@ -0,0 +1,78 @@
+/*
+This file is part of World Editor.
+
+World Editor is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+World Editor is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCENEUPDATEQUEUE_H
+#define SCENEUPDATEQUEUE_H
+
+#include <QAbstractItemModel>
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+
+//!
+//! \brief The SceneUpdate struct is every change to the model since the last batch
+//!
+struct SceneUpdate
+{
+    bool reset;             //! Rows were moved or the model reset, rebuild from the model
+    QVector<int> removed;   //! Handles of the removed rows, see Solids::HandleRole
+    int firstInserted;      //! Rows from here to the end are new, -1 when none are
+    QVector<int> changed;   //! Older rows whose data changed, sorted without duplicates
+
+    SceneUpdate();
+    bool isEmpty() const;
+    void clear();
+};
+
+//!
+//! \brief The SceneUpdateQueue class coalesces model notifications into one batch per tick
+//! The scenes connect to updated() rather than to the model, so inserting
+//! 10k rows, or changing the same row many times, costs them a single update
+//! once control returns to the event loop.
+//! Rows are numbered as they are once the removals are applied. A removal
+//! flushes the changed and inserted rows before it, so none of them are
+//! ever renumbered, while removals in a row still make one batch.
+//!
+class SceneUpdateQueue : public QObject
+{
+    Q_OBJECT
+    QAbstractItemModel *m_model;
+    SceneUpdate m_pending;
+    QTimer m_timer;
+
+    void schedule();
+    void flushRows();
+
+public:
+    SceneUpdateQueue(QAbstractItemModel *model, QObject *parent = 0);
+    bool isPending() const;
+
+signals:
+    void updated(const SceneUpdate &update);
+
+public slots:
+    void flush();
+
+private slots:
+    void rowsInserted(const QModelIndex &parent, int first, int last);
+    void rowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+    void layoutAboutToBeChanged();
+    void dataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    void modelReset();
+};
+
+#endif // SCENEUPDATEQUEUE_H
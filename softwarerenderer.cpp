@@ -0,0 +1,681 @@
+/*
+This file is part of World Editor.
+
+World Editor is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+World Editor is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QSet>
+#include <QtMath>
+#include <algorithm>
+#include <cstring>
+#include "polygoniser.h"
+#include "softwarerenderer.h"
+#include "jobsystem.h"
+#include "trace.h"
+
+#define RASTER_TILE_PIXELS 64
+#define RASTER_NEAR_PLANE 4.0f
+#define RASTER_FAR_PLANE 65536.0f
+//! Triangles reaching further than this many screen widths off screen are
+//! clipped, so the edge functions keep enough float precision
+#define RASTER_GUARD_BAND 4.0f
+//! Brushes turned into triangles by each worker when building a mesh
+#define MESH_CHUNK_BRUSHES 256
+//! Triangles set up by each worker, smaller meshes use fewer workers
+#define SETUP_CHUNK_TRIANGLES 1024
+//! Fraction of dead triangles in the mesh that triggers a compaction
+#define DEAD_TRIANGLES_RATIO 0.5
+
+//!
+//! \brief The MeshChunk struct is a range of brushes triangulated by one worker
+//!
+struct MeshChunk
+{
+    int first;
+    int last;
+    RasterMesh mesh;
+};
+
+//!
+//! \brief RasterMesh::triangleCount
+//! \return
+//!
+int RasterMesh::triangleCount() const {
+    return colours.count();
+}
+//!
+//! \brief RasterMesh::brushCount
+//! \return
+//!
+int RasterMesh::brushCount() const {
+    return brushCounts.count();
+}
+//!
+//! \brief RasterMesh::clear
+//!
+void RasterMesh::clear() {
+    x.resize(0);
+    y.resize(0);
+    z.resize(0);
+    colours.resize(0);
+    brushFirst.resize(0);
+    brushCounts.resize(0);
+}
+//!
+//! \brief RasterMesh::append
+//! \param other
+//!
+void RasterMesh::append(const RasterMesh &other) {
+    const int offset = triangleCount();
+    x += other.x;
+    y += other.y;
+    z += other.z;
+    colours += other.colours;
+    brushFirst.reserve(brushFirst.size() + other.brushFirst.size());
+    foreach(int first, other.brushFirst)
+        brushFirst.append(first + offset);
+    brushCounts += other.brushCounts;
+}
+//!
+//! \brief SoftwareRenderer::SoftwareRenderer
+//!
+SoftwareRenderer::SoftwareRenderer()
+{
+    m_deadTriangles = 0;
+    m_width = 0;
+    m_tilesX = 0;
+    m_tilesY = 0;
+}
+//!
+//! \brief SoftwareRenderer::appendBrush triangulates the faces of a brush into the mesh
+//! The polygoniser gives the points of each face unordered, so they are sorted
+//! around the outward normal first. Every face is then flat shaded from a
+//! fixed light and split into a fan. The brush gets a range in the mesh
+//! even when it has no triangles.
+//! \param brush
+//! \param mesh
+//!
+void SoftwareRenderer::appendBrush(const Brush &brush, RasterMesh *mesh) {
+    static const QVector3D light = QVector3D(0.3f, 0.5f, 0.8f).normalized();
+    QList<Winding> windings = brush.getWindings();
+    mesh->brushFirst.append(mesh->triangleCount());
+    mesh->brushCounts.append(0);
+
+    QVector3D centre;
+    int count = 0;
+    foreach(const Winding &winding, windings) {
+        foreach(const QVector3D &point, winding) {
+            centre += point;
+            count++;
+        }
+    }
+    if(count == 0)
+        return;
+    centre /= count;
+
+    QVector<QPair<float, int> > order;
+    foreach(const Winding &winding, windings) {
+        if(winding.size() < 3)
+            continue;
+
+        QVector3D faceCentre;
+        foreach(const QVector3D &point, winding)
+            faceCentre += point;
+        faceCentre /= winding.size();
+
+        // The longest cross product is the least affected by nearly collinear points
+        QVector3D normal;
+        for(int i = 2; i < winding.size(); i++) {
+            QVector3D cross = QVector3D::crossProduct(winding.at(1) - winding.at(0),
+                                                      winding.at(i) - winding.at(0));
+            if(cross.lengthSquared() > normal.lengthSquared())
+                normal = cross;
+        }
+        if(normal.isNull())
+            continue;
+        normal.normalize();
+        if(QVector3D::dotProduct(normal, faceCentre - centre) < 0)
+            normal = -normal;
+
+        QVector3D u = (winding.at(0) - faceCentre).normalized();
+        QVector3D v = QVector3D::crossProduct(normal, u);
+        order.resize(0);
+        for(int i = 0; i < winding.size(); i++) {
+            QVector3D d = winding.at(i) - faceCentre;
+            order.append(qMakePair(float(qAtan2(QVector3D::dotProduct(d, v),
+                                                QVector3D::dotProduct(d, u))), i));
+        }
+        std::sort(order.begin(), order.end());
+
+        float shade = 0.35f + 0.65f * qMax(0.0f, QVector3D::dotProduct(normal, light));
+        QRgb colour = qRgb(int(200 * shade), int(200 * shade), int(210 * shade));
+
+        const QVector3D &first = winding.at(order.at(0).second);
+        for(int i = 1; i + 1 < order.size(); i++) {
+            const QVector3D &second = winding.at(order.at(i).second);
+            const QVector3D &third = winding.at(order.at(i + 1).second);
+            mesh->x << first.x() << second.x() << third.x();
+            mesh->y << first.y() << second.y() << third.y();
+            mesh->z << first.z() << second.z() << third.z();
+            mesh->colours << colour;
+            mesh->brushCounts.last()++;
+        }
+    }
+}
+//!
+//! \brief SoftwareRenderer::buildMesh triangulates brushes on the job system
+//! \param brushes
+//! \return
+//!
+RasterMesh SoftwareRenderer::buildMesh(const QList<Brush> &brushes) {
+    QVector<MeshChunk> chunks;
+    for(int first = 0; first < brushes.count(); first += MESH_CHUNK_BRUSHES) {
+        MeshChunk chunk;
+        chunk.first = first;
+        chunk.last = qMin(first + MESH_CHUNK_BRUSHES, brushes.count()) - 1;
+        chunks.append(chunk);
+    }
+
+    MeshChunk *data = chunks.data();
+    JobSystem::global()->parallelFor(0, chunks.size(), [&brushes, data](int c) {
+        for(int i = data[c].first; i <= data[c].last; i++)
+            appendBrush(brushes.at(i), &data[c].mesh);
+    }, 1);
+
+    RasterMesh mesh;
+    int triangles = 0;
+    foreach(const MeshChunk &chunk, chunks)
+        triangles += chunk.mesh.triangleCount();
+    mesh.x.reserve(triangles * 3);
+    mesh.y.reserve(triangles * 3);
+    mesh.z.reserve(triangles * 3);
+    mesh.colours.reserve(triangles);
+    mesh.brushFirst.reserve(brushes.count());
+    mesh.brushCounts.reserve(brushes.count());
+    foreach(const MeshChunk &chunk, chunks)
+        mesh.append(chunk.mesh);
+    return mesh;
+}
+//!
+//! \brief SoftwareRenderer::cameraMatrix builds the view projection of a map camera
+//! \param position - The eye of the camera
+//! \param look - The point the camera is looking toward
+//! \param aspect - Width over height of the target
+//! \param fov - Vertical field of view in degrees
+//! \return
+//!
+QMatrix4x4 SoftwareRenderer::cameraMatrix(const QVector3D &position, const QVector3D &look,
+                                          float aspect, float fov) {
+    QVector3D forward = look - position;
+    // Z is up in the map, unless we are looking straight up or down it
+    QVector3D up(0, 0, 1);
+    if(QVector3D::crossProduct(forward, up).isNull())
+        up = QVector3D(0, 1, 0);
+
+    QMatrix4x4 projection;
+    projection.perspective(fov, aspect, RASTER_NEAR_PLANE, RASTER_FAR_PLANE);
+    QMatrix4x4 view;
+    view.lookAt(position, look, up);
+    return projection * view;
+}
+//!
+//! \brief SoftwareRenderer::setMesh
+//! \param mesh - Its brushes are known by their position in it
+//!
+void SoftwareRenderer::setMesh(const RasterMesh &mesh) {
+    m_mesh = mesh;
+    m_brushIds.resize(mesh.brushCount());
+    for(int i = 0; i < m_brushIds.size(); i++)
+        m_brushIds[i] = i;
+    m_deadTriangles = 0;
+}
+//!
+//! \brief SoftwareRenderer::mesh
+//! \return
+//!
+const RasterMesh &SoftwareRenderer::mesh() const {
+    return m_mesh;
+}
+//!
+//! \brief SoftwareRenderer::addBrushes triangulates brushes onto the end of the mesh
+//! \param ids - One per brush, used to remove them later
+//! \param brushes
+//!
+void SoftwareRenderer::addBrushes(const QVector<int> &ids, const QList<Brush> &brushes) {
+    Q_ASSERT(ids.size() == brushes.size());
+    if(brushes.isEmpty())
+        return;
+    if(m_mesh.brushCount() == 0) {
+        m_mesh = buildMesh(brushes);
+        m_deadTriangles = 0;
+    } else {
+        m_mesh.append(buildMesh(brushes));
+    }
+    m_brushIds += ids;
+}
+//!
+//! \brief SoftwareRenderer::replaceBrushes triangulates brushes again
+//! Triangles are overwritten where they are when the count matches, otherwise
+//! the new ones go at the end and the old ones are left dead.
+//! \param indexes - Positions of the brushes, in the order they were added
+//! \param brushes - The new brush at each of indexes
+//!
+void SoftwareRenderer::replaceBrushes(const QVector<int> &indexes, const QList<Brush> &brushes) {
+    Q_ASSERT(indexes.size() == brushes.size());
+    if(brushes.isEmpty())
+        return;
+    const RasterMesh mesh = buildMesh(brushes);
+    for(int i = 0; i < indexes.size(); i++) {
+        int index = indexes.at(i);
+        if(index < 0 || index >= m_mesh.brushCount())
+            continue;
+        int first = m_mesh.brushFirst.at(index);
+        const int count = m_mesh.brushCounts.at(index);
+        const int newFirst = mesh.brushFirst.at(i);
+        const int newCount = mesh.brushCounts.at(i);
+        if(newCount != count) {
+            killTriangles(first, count);
+            first = m_mesh.triangleCount();
+            m_mesh.brushFirst[index] = first;
+            m_mesh.brushCounts[index] = newCount;
+            m_mesh.x.resize((first + newCount) * 3);
+            m_mesh.y.resize((first + newCount) * 3);
+            m_mesh.z.resize((first + newCount) * 3);
+            m_mesh.colours.resize(first + newCount);
+        }
+        memcpy(m_mesh.x.data() + first * 3, mesh.x.constData() + newFirst * 3,
+               sizeof(float) * 3 * newCount);
+        memcpy(m_mesh.y.data() + first * 3, mesh.y.constData() + newFirst * 3,
+               sizeof(float) * 3 * newCount);
+        memcpy(m_mesh.z.data() + first * 3, mesh.z.constData() + newFirst * 3,
+               sizeof(float) * 3 * newCount);
+        memcpy(m_mesh.colours.data() + first, mesh.colours.constData() + newFirst,
+               sizeof(QRgb) * newCount);
+    }
+    if(m_deadTriangles > m_mesh.triangleCount() * DEAD_TRIANGLES_RATIO)
+        compact();
+}
+//!
+//! \brief SoftwareRenderer::removeBrushes takes many brushes out in one pass
+//! Their triangles are left dead like those of replaced brushes. Only the
+//! arrays with an entry per brush close up, so the others keep their order.
+//! \param ids - As the brushes were added, unknown ones are ignored
+//!
+void SoftwareRenderer::removeBrushes(const QVector<int> &ids) {
+    if(ids.isEmpty())
+        return;
+    QSet<int> removed;
+    removed.reserve(ids.size());
+    foreach(int id, ids)
+        removed.insert(id);
+
+    const int count = m_brushIds.size();
+    int kept = 0;
+    for(int b = 0; b < count; b++) {
+        if(removed.contains(m_brushIds.at(b))) {
+            killTriangles(m_mesh.brushFirst.at(b), m_mesh.brushCounts.at(b));
+            continue;
+        }
+        if(kept != b) {
+            m_brushIds[kept] = m_brushIds.at(b);
+            m_mesh.brushFirst[kept] = m_mesh.brushFirst.at(b);
+            m_mesh.brushCounts[kept] = m_mesh.brushCounts.at(b);
+        }
+        kept++;
+    }
+    if(kept == count)
+        return;
+    if(kept == 0) {
+        clear();
+        return;
+    }
+    m_brushIds.resize(kept);
+    m_mesh.brushFirst.resize(kept);
+    m_mesh.brushCounts.resize(kept);
+
+    if(m_deadTriangles > m_mesh.triangleCount() * DEAD_TRIANGLES_RATIO)
+        compact();
+}
+//!
+//! \brief SoftwareRenderer::clear
+//!
+void SoftwareRenderer::clear() {
+    m_mesh.clear();
+    m_brushIds.resize(0);
+    m_deadTriangles = 0;
+}
+//!
+//! \brief SoftwareRenderer::brushCount
+//! \return
+//!
+int SoftwareRenderer::brushCount() const {
+    return m_mesh.brushCount();
+}
+//!
+//! \brief SoftwareRenderer::liveTriangleCount
+//! \return the triangles of the mesh less the dead ones
+//!
+int SoftwareRenderer::liveTriangleCount() const {
+    return m_mesh.triangleCount() - m_deadTriangles;
+}
+//!
+//! \brief SoftwareRenderer::killTriangles leaves a range of triangles dead
+//! Every vertex is moved to the same point, so setup culls them for having
+//! no area until the mesh is compacted.
+//! \param first
+//! \param count
+//!
+void SoftwareRenderer::killTriangles(int first, int count) {
+    float *x = m_mesh.x.data();
+    float *y = m_mesh.y.data();
+    float *z = m_mesh.z.data();
+    for(int i = first * 3; i < (first + count) * 3; i++) {
+        x[i] = 0;
+        y[i] = 0;
+        z[i] = 0;
+    }
+    m_deadTriangles += count;
+}
+//!
+//! \brief SoftwareRenderer::compact copies the live triangles to new arrays
+//! The brushes keep their order, the gaps left by dead triangles close up.
+//!
+void SoftwareRenderer::compact() {
+    RasterMesh mesh;
+    const int triangles = liveTriangleCount();
+    mesh.x.reserve(triangles * 3);
+    mesh.y.reserve(triangles * 3);
+    mesh.z.reserve(triangles * 3);
+    mesh.colours.reserve(triangles);
+    mesh.brushFirst.reserve(m_mesh.brushCount());
+    mesh.brushCounts = m_mesh.brushCounts;
+    for(int b = 0; b < m_mesh.brushCount(); b++) {
+        const int first = m_mesh.brushFirst.at(b);
+        const int count = m_mesh.brushCounts.at(b);
+        mesh.brushFirst.append(mesh.triangleCount());
+        for(int i = first * 3; i < (first + count) * 3; i++) {
+            mesh.x.append(m_mesh.x.at(i));
+            mesh.y.append(m_mesh.y.at(i));
+            mesh.z.append(m_mesh.z.at(i));
+        }
+        for(int i = first; i < first + count; i++)
+            mesh.colours.append(m_mesh.colours.at(i));
+    }
+    m_mesh = mesh;
+    m_deadTriangles = 0;
+}
+//!
+//! \brief SoftwareRenderer::render draws the mesh into a 32 bit image
+//! \param target - Format_RGB32 or Format_ARGB32_Premultiplied
+//! \param viewProjection
+//! \param background
+//!
+void SoftwareRenderer::render(QImage *target, const QMatrix4x4 &viewProjection, QRgb background) {
+    Q_ASSERT(target->depth() == 32);
+    const int width = target->width();
+    const int height = target->height();
+    if(width <= 0 || height <= 0)
+        return;
+    TRACE_SCOPE(PAINT, "render");
+
+    m_width = width;
+    m_tilesX = (width + RASTER_TILE_PIXELS - 1) / RASTER_TILE_PIXELS;
+    m_tilesY = (height + RASTER_TILE_PIXELS - 1) / RASTER_TILE_PIXELS;
+    m_depth.resize(width * height);
+
+    const int triangles = m_mesh.triangleCount();
+    int chunks = qBound(1, (triangles + SETUP_CHUNK_TRIANGLES - 1) / SETUP_CHUNK_TRIANGLES,
+                        JobSystem::global()->workerCount() * 4);
+    m_bins.resize(chunks);
+    for(int i = 0; i < chunks; i++) {
+        m_bins[i].first = qint64(triangles) * i / chunks;
+        m_bins[i].last = qint64(triangles) * (i + 1) / chunks - 1;
+    }
+
+    const float *m = viewProjection.constData();
+    RasterBin *bins = m_bins.data();
+    JobSystem::global()->parallelFor(0, chunks, [this, bins, m, width, height](int i) {
+        setupTriangles(&bins[i], m, width, height);
+    }, 1);
+
+    // Detach once here, the workers only touch their own tiles
+    uchar *bits = target->bits();
+    const int bytesPerLine = target->bytesPerLine();
+    JobSystem::global()->parallelFor(0, m_tilesX * m_tilesY, [=](int tile) {
+        rasteriseTile(tile, bits, bytesPerLine, width, height, background);
+    }, 1);
+}
+//!
+//! \brief SoftwareRenderer::depthAt
+//! \param x
+//! \param y
+//! \return 1/w of the nearest face drawn at the pixel of the last frame, 0 when empty
+//!
+float SoftwareRenderer::depthAt(int x, int y) const {
+    int i = y * m_width + x;
+    if(x < 0 || x >= m_width || i < 0 || i >= m_depth.size())
+        return 0;
+    return m_depth.at(i);
+}
+//!
+//! \brief clipPolygon clips a convex polygon in clip space against one plane
+//! \param in
+//! \param count - Number of vertexes in in
+//! \param plane - Vertexes are kept where the dot product with this is positive
+//! \param out - Receives up to count + 1 vertexes
+//! \return the number of vertexes in out
+//!
+static int clipPolygon(float in[][4], int count, const float plane[4], float out[][4]) {
+    int clipped = 0;
+    for(int i = 0; i < count; i++) {
+        const float *a = in[i];
+        const float *b = in[(i + 1) % count];
+        float da = plane[0] * a[0] + plane[1] * a[1] + plane[2] * a[2] + plane[3] * a[3];
+        float db = plane[0] * b[0] + plane[1] * b[1] + plane[2] * b[2] + plane[3] * b[3];
+        if(da >= 0) {
+            for(int k = 0; k < 4; k++)
+                out[clipped][k] = a[k];
+            clipped++;
+        }
+        if((da >= 0) != (db >= 0)) {
+            float t = da / (da - db);
+            for(int k = 0; k < 4; k++)
+                out[clipped][k] = a[k] + (b[k] - a[k]) * t;
+            clipped++;
+        }
+    }
+    return clipped;
+}
+//!
+//! \brief outsideFrustum
+//! \param v - Three clip space vertexes
+//! \return true if every vertex is beyond the same side of the frustum
+//!
+static bool outsideFrustum(float v[3][4]) {
+    for(int axis = 0; axis < 3; axis++) {
+        if(v[0][axis] > v[0][3] && v[1][axis] > v[1][3] && v[2][axis] > v[2][3])
+            return true;
+        if(v[0][axis] < -v[0][3] && v[1][axis] < -v[1][3] && v[2][axis] < -v[2][3])
+            return true;
+    }
+    return false;
+}
+//!
+//! \brief SoftwareRenderer::setupTriangles transforms, clips, culls and bins a range of the mesh
+//! \param bin
+//! \param m - Column major view projection
+//! \param width
+//! \param height
+//!
+void SoftwareRenderer::setupTriangles(RasterBin *bin, const float *m, int width, int height) {
+    bin->triangles.resize(0);
+    bin->tiles.resize(m_tilesX * m_tilesY);
+    for(int i = 0; i < bin->tiles.size(); i++)
+        bin->tiles[i].resize(0);
+
+    const float *xs = m_mesh.x.constData();
+    const float *ys = m_mesh.y.constData();
+    const float *zs = m_mesh.z.constData();
+
+    for(int t = bin->first; t <= bin->last; t++) {
+        float clip[3][4];
+        for(int v = 0; v < 3; v++) {
+            float x = xs[t * 3 + v];
+            float y = ys[t * 3 + v];
+            float z = zs[t * 3 + v];
+            clip[v][0] = m[0] * x + m[4] * y + m[8] * z + m[12];
+            clip[v][1] = m[1] * x + m[5] * y + m[9] * z + m[13];
+            clip[v][2] = m[2] * x + m[6] * y + m[10] * z + m[14];
+            clip[v][3] = m[3] * x + m[7] * y + m[11] * z + m[15];
+        }
+        if(outsideFrustum(clip))
+            continue;
+
+        // Near plane then, only when needed, the guard band
+        static const float planes[5][4] = {
+            { 0, 0, 1, 1 },
+            { -1, 0, 0, RASTER_GUARD_BAND }, { 1, 0, 0, RASTER_GUARD_BAND },
+            { 0, -1, 0, RASTER_GUARD_BAND }, { 0, 1, 0, RASTER_GUARD_BAND },
+        };
+        float polygon[9][4];
+        float scratch[9][4];
+        int count = clipPolygon(clip, 3, planes[0], polygon);
+        for(int p = 1; p < 5 && count >= 3; p++) {
+            bool inside = true;
+            for(int v = 0; v < count; v++) {
+                const float *q = polygon[v];
+                inside &= planes[p][0] * q[0] + planes[p][1] * q[1] + planes[p][3] * q[3] >= 0;
+            }
+            if(inside)
+                continue;
+            count = clipPolygon(polygon, count, planes[p], scratch);
+            memcpy(polygon, scratch, sizeof(float) * 4 * count);
+        }
+
+        float sx[9], sy[9], sz[9];
+        for(int v = 0; v < count; v++) {
+            float invW = 1.0f / polygon[v][3];
+            sx[v] = (polygon[v][0] * invW * 0.5f + 0.5f) * width;
+            sy[v] = (0.5f - polygon[v][1] * invW * 0.5f) * height;
+            sz[v] = invW;
+        }
+
+        for(int f = 1; f + 1 < count; f++) {
+            // Front faces wind clockwise once y points down the screen
+            int i0 = 0, i1 = f + 1, i2 = f;
+            float area = (sx[i1] - sx[i0]) * (sy[i2] - sy[i0]) - (sx[i2] - sx[i0]) * (sy[i1] - sy[i0]);
+            if(area <= 0)
+                continue;
+
+            ScreenTriangle tri;
+            const int edges[3][2] = { { i1, i2 }, { i2, i0 }, { i0, i1 } };
+            for(int e = 0; e < 3; e++) {
+                int a = edges[e][0];
+                int b = edges[e][1];
+                tri.edgeA[e] = sy[a] - sy[b];
+                tri.edgeB[e] = sx[b] - sx[a];
+                tri.edgeC[e] = -(tri.edgeA[e] * sx[a] + tri.edgeB[e] * sy[a]);
+            }
+            float invArea = 1.0f / area;
+            tri.depthDx = (tri.edgeA[0] * sz[i0] + tri.edgeA[1] * sz[i1] + tri.edgeA[2] * sz[i2]) * invArea;
+            tri.depthDy = (tri.edgeB[0] * sz[i0] + tri.edgeB[1] * sz[i1] + tri.edgeB[2] * sz[i2]) * invArea;
+            tri.depth = (tri.edgeC[0] * sz[i0] + tri.edgeC[1] * sz[i1] + tri.edgeC[2] * sz[i2]) * invArea;
+
+            float minX = qMin(sx[i0], qMin(sx[i1], sx[i2]));
+            float maxX = qMax(sx[i0], qMax(sx[i1], sx[i2]));
+            float minY = qMin(sy[i0], qMin(sy[i1], sy[i2]));
+            float maxY = qMax(sy[i0], qMax(sy[i1], sy[i2]));
+            if(maxX < 0 || maxY < 0 || minX > width || minY > height)
+                continue;
+            tri.minX = int(qMax(minX, 0.0f));
+            tri.minY = int(qMax(minY, 0.0f));
+            tri.maxX = qMin(width - 1, int(qMin(maxX, float(width))));
+            tri.maxY = qMin(height - 1, int(qMin(maxY, float(height))));
+            if(tri.minX > tri.maxX || tri.minY > tri.maxY)
+                continue;
+            tri.colour = m_mesh.colours.at(t);
+
+            int index = bin->triangles.size();
+            bin->triangles.append(tri);
+            for(int ty = tri.minY / RASTER_TILE_PIXELS; ty <= tri.maxY / RASTER_TILE_PIXELS; ty++) {
+                for(int tx = tri.minX / RASTER_TILE_PIXELS; tx <= tri.maxX / RASTER_TILE_PIXELS; tx++)
+                    bin->tiles[ty * m_tilesX + tx].append(index);
+            }
+        }
+    }
+}
+//!
+//! \brief SoftwareRenderer::rasteriseTile clears a tile then draws every triangle binned in it
+//! Bins are walked in mesh order, so the result does not depend on the thread count.
+//! \param tile
+//! \param bits
+//! \param bytesPerLine
+//! \param width
+//! \param height
+//! \param background
+//!
+void SoftwareRenderer::rasteriseTile(int tile, uchar *bits, int bytesPerLine, int width, int height,
+                                     QRgb background) {
+    const int x0 = (tile % m_tilesX) * RASTER_TILE_PIXELS;
+    const int y0 = (tile / m_tilesX) * RASTER_TILE_PIXELS;
+    const int x1 = qMin(x0 + RASTER_TILE_PIXELS, width) - 1;
+    const int y1 = qMin(y0 + RASTER_TILE_PIXELS, height) - 1;
+    float *depth = m_depth.data();
+
+    for(int y = y0; y <= y1; y++) {
+        std::fill(depth + y * width + x0, depth + y * width + x1 + 1, 0.0f);
+        QRgb *row = reinterpret_cast<QRgb *>(bits + y * bytesPerLine);
+        std::fill(row + x0, row + x1 + 1, background);
+    }
+
+    for(int b = 0; b < m_bins.size(); b++) {
+        const RasterBin &bin = m_bins.at(b);
+        const QVector<int> &list = bin.tiles.at(tile);
+        for(int i = 0; i < list.size(); i++) {
+            const ScreenTriangle &tri = bin.triangles.at(list.at(i));
+            const int left = qMax(x0, tri.minX);
+            const int right = qMin(x1, tri.maxX);
+            const int top = qMax(y0, tri.minY);
+            const int bottom = qMin(y1, tri.maxY);
+            if(left > right || top > bottom)
+                continue;
+
+            const int span = right - left + 1;
+            const float a0 = tri.edgeA[0], a1 = tri.edgeA[1], a2 = tri.edgeA[2];
+            const float dz = tri.depthDx;
+            const QRgb colour = tri.colour;
+            const float px = left + 0.5f;
+
+            for(int y = top; y <= bottom; y++) {
+                const float py = y + 0.5f;
+                const float e0 = a0 * px + tri.edgeB[0] * py + tri.edgeC[0];
+                const float e1 = a1 * px + tri.edgeB[1] * py + tri.edgeC[1];
+                const float e2 = a2 * px + tri.edgeB[2] * py + tri.edgeC[2];
+                const float z0 = tri.depth + dz * px + tri.depthDy * py;
+                float *zrow = depth + y * width + left;
+                QRgb *crow = reinterpret_cast<QRgb *>(bits + y * bytesPerLine) + left;
+
+                // Selects rather than branches, so this loop vectorises
+                for(int x = 0; x < span; x++) {
+                    const float fx = float(x);
+                    const float z = z0 + dz * fx;
+                    const bool inside = (e0 + a0 * fx >= 0) & (e1 + a1 * fx >= 0)
+                            & (e2 + a2 * fx >= 0) & (z > zrow[x]);
+                    zrow[x] = inside ? z : zrow[x];
+                    crow[x] = inside ? colour : crow[x];
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,117 @@
+/*
+This file is part of World Editor.
+
+World Editor is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+World Editor is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SOFTWARERENDERER_H
+#define SOFTWARERENDERER_H
+
+#include <QImage>
+#include <QMatrix4x4>
+#include <QVector>
+#include "brush.h"
+
+//!
+//! \brief The RasterMesh struct holds flat shaded triangles in flat arrays
+//! Each triangle has three vertexes back to back in x, y and z. The
+//! triangles of a brush are contiguous.
+//!
+struct RasterMesh
+{
+    QVector<float> x;
+    QVector<float> y;
+    QVector<float> z;
+    QVector<QRgb> colours;      //! Shaded colour of each triangle
+    QVector<int> brushFirst;    //! First triangle of each brush
+    QVector<int> brushCounts;   //! Number of triangles of each brush
+
+    int triangleCount() const;
+    int brushCount() const;
+    void clear();
+    void append(const RasterMesh &other);
+};
+
+//!
+//! \brief The ScreenTriangle struct is a triangle set up for rasterisation
+//! The edges and the depth are planes in screen space, evaluated at pixel centres.
+//!
+struct ScreenTriangle
+{
+    float edgeA[3];
+    float edgeB[3];
+    float edgeC[3];
+    float depth;    //! 1/w at the screen origin
+    float depthDx;
+    float depthDy;
+    int minX, minY, maxX, maxY;
+    QRgb colour;
+};
+
+//!
+//! \brief The RasterBin struct is the triangles set up by one worker, binned by tile
+//!
+struct RasterBin
+{
+    int first;  //! First triangle of the mesh handled by this bin
+    int last;
+    QVector<ScreenTriangle> triangles;
+    QVector<QVector<int> > tiles;   //! Indexes into triangles for every tile
+};
+
+//!
+//! \brief The SoftwareRenderer class draws the brushes in perspective on the CPU
+//! A frame runs in two parallel passes. Chunks of the mesh are transformed,
+//! clipped against the near plane, culled and binned into screen tiles, then
+//! every tile is rasterised on its own against a 1/w depth buffer. The inner
+//! loop works on whole rows with selects instead of branches so the compiler
+//! can vectorise it.
+//!
+class SoftwareRenderer
+{
+    RasterMesh m_mesh;
+    QVector<int> m_brushIds;    //! Id each brush of the mesh was added with
+    int m_deadTriangles;        //! Left behind by replaced and removed brushes
+    QVector<float> m_depth;
+    QVector<RasterBin> m_bins;
+    int m_width;
+    int m_tilesX;
+    int m_tilesY;
+
+    void setupTriangles(RasterBin *bin, const float *m, int width, int height);
+    void rasteriseTile(int tile, uchar *bits, int bytesPerLine, int width, int height,
+                       QRgb background);
+    void killTriangles(int first, int count);
+    void compact();
+
+public:
+    SoftwareRenderer();
+    static void appendBrush(const Brush &brush, RasterMesh *mesh);
+    static RasterMesh buildMesh(const QList<Brush> &brushes);
+    static QMatrix4x4 cameraMatrix(const QVector3D &position, const QVector3D &look,
+                                   float aspect, float fov = 75);
+
+    void setMesh(const RasterMesh &mesh);
+    const RasterMesh &mesh() const;
+    void addBrushes(const QVector<int> &ids, const QList<Brush> &brushes);
+    void replaceBrushes(const QVector<int> &indexes, const QList<Brush> &brushes);
+    void removeBrushes(const QVector<int> &ids);
+    void clear();
+    int brushCount() const;
+    int liveTriangleCount() const;
+    void render(QImage *target, const QMatrix4x4 &viewProjection, QRgb background);
+    float depthAt(int x, int y) const;
+};
+
+#endif // SOFTWARERENDERER_H
@@ -15,14 +15,18 @@ You should have received a copy of the GNU General Public License
 along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
 #include "solids.h"
+#include "polygoncache.h"
+#include "trace.h"
 
 //!
 //! \brief Solids::Solids
 //! \param parent
 //!
 Solids::Solids(QObject *parent)
-    : QAbstractListModel(parent)
+    : QAbstractListModel(parent), m_published(std::make_shared<SolidsVersion>()),
+      m_dirtyFrom(INT_MAX)
 {
 }
 //!
@@ -60,6 +64,8 @@ int Solids::rowCount(const QModelIndex & parent) const {
 }
 //!
 //! \brief Solids::data
+//! BrushRole hands out a copy of the brush for generic views, code which
+//! knows it has a Solids should use brush() or visitBrushes() instead.
 //! \param index
 //! \param role
 //! \return
@@ -75,13 +81,371 @@ QVariant Solids::data(const QModelIndex & index, int role) const {
         v.setValue(brush);
         return v;
     }
+    if (role == HandleRole)
+        return m_handles.at(index.row());
+    return QVariant();
 }
 //!
 //! \brief Solids::addBrush
 //! \param newBrush
 //!
 void Solids::addSolid(const Brush &newBrush) {
-    beginInsertRows(QModelIndex(), rowCount(), rowCount());
-    m_brushes << newBrush;
+    addSolids(QList<Brush>() << newBrush);
+}
+//!
+//! \brief Solids::addSolids inserts a batch of brushes with a single rowsInserted
+//! The batch is polygonised for all three 2D views on the thread pool first,
+//! so the views only have to build their items from the results.
+//! \param newBrushes
+//! \return the handles given to the new brushes
+//!
+QVector<BrushHandle> Solids::addSolids(const QList<Brush> &newBrushes) {
+    QVector<BrushHandle> handles;
+    if(newBrushes.isEmpty())
+        return handles;
+    TRACE_SCOPE(SCENE, "addSolids");
+    QVector<ProjectedPolygons> polygons = Polygoniser::poligoniseAll(newBrushes);
+    beginInsertRows(QModelIndex(), rowCount(), rowCount() + newBrushes.count() - 1);
+    handles.reserve(newBrushes.count());
+    for(int i = 0; i < newBrushes.count(); i++) {
+        handles.append(m_handleRows.size());
+        m_handleRows.append(m_brushes.count() + i);
+    }
+    m_dirtyFrom = qMin(m_dirtyFrom, m_brushes.count());
+    m_brushes.append(newBrushes);
+    m_polygons += polygons;
+    m_handles += handles;
+    publish();
     endInsertRows();
+    return handles;
+}
+//!
+//! \brief Solids::removeSolids removes a batch of brushes
+//! \param handles - Unknown or already removed handles are ignored
+//!
+void Solids::removeSolids(const QList<BrushHandle> &handles) {
+    QVector<int> rows;
+    rows.reserve(handles.count());
+    foreach(BrushHandle handle, handles) {
+        int r = row(handle);
+        if(r >= 0)
+            rows.append(r);
+    }
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    removeSortedRows(rows);
+}
+//!
+//! \brief Solids::removeRows
+//! \param row
+//! \param count
+//! \param parent
+//! \return
+//!
+bool Solids::removeRows(int row, int count, const QModelIndex &parent) {
+    if(parent.isValid() || row < 0 || count <= 0 || row + count > rowCount())
+        return false;
+    QVector<int> rows;
+    for(int r = row; r < row + count; r++)
+        rows.append(r);
+    removeSortedRows(rows);
+    return true;
+}
+//!
+//! \brief Solids::removeSortedRows removes rows without a reset or a signal per row
+//! A single run of rows is removed as it is. Scattered rows are tombstoned and
+//! compacted to the end in one pass, announced as one layout change, then
+//! removed from the end with one rowsRemoved. PolygonCache forgets the removed brushes.
+//! \param rows - Sorted without duplicates
+//!
+void Solids::removeSortedRows(const QVector<int> &rows) {
+    if(rows.isEmpty())
+        return;
+    const int count = m_brushes.count();
+    const int removed = rows.count();
+    int first = rows.first();
+    m_dirtyFrom = qMin(m_dirtyFrom, first);
+
+    if(rows.last() - first + 1 != removed) {
+        emit(layoutAboutToBeChanged());
+        QVector<bool> tombstones(count, false);
+        foreach(int r, rows)
+            tombstones[r] = true;
+
+        // Survivors keep their order at the front, the tombstones follow them
+        QVector<int> newRows(count);
+        int front = 0;
+        int back = count - removed;
+        for(int r = 0; r < count; r++)
+            newRows[r] = tombstones.at(r) ? back++ : front++;
+
+        QList<Brush> brushes;
+        brushes.reserve(count);
+        QVector<ProjectedPolygons> polygons(count);
+        QVector<BrushHandle> handles(count);
+        for(int r = 0; r < count; r++) {
+            polygons[newRows.at(r)] = m_polygons.at(r);
+            handles[newRows.at(r)] = m_handles.at(r);
+        }
+        for(int r = 0; r < count; r++) {
+            if(!tombstones.at(r))
+                brushes.append(m_brushes.at(r));
+        }
+        foreach(int r, rows)
+            brushes.append(m_brushes.at(r));
+        m_brushes = brushes;
+        m_polygons = polygons;
+        m_handles = handles;
+        for(int r = 0; r < count; r++)
+            m_handleRows[m_handles.at(r)] = r;
+
+        QModelIndexList from = persistentIndexList();
+        QModelIndexList to;
+        foreach(const QModelIndex &index, from)
+            to.append(this->index(newRows.at(index.row()), 0));
+        changePersistentIndexList(from, to);
+        emit(layoutChanged());
+        first = count - removed;
+    }
+
+    const int last = first + removed - 1;
+    beginRemoveRows(QModelIndex(), first, last);
+    for(int r = first; r <= last; r++) {
+        m_handleRows[m_handles.at(r)] = -1;
+        PolygonCache::global()->invalidate(m_brushes.at(r).getId());
+    }
+    m_brushes.erase(m_brushes.begin() + first, m_brushes.begin() + last + 1);
+    m_polygons.remove(first, removed);
+    m_handles.remove(first, removed);
+    for(int r = first; r < m_handles.size(); r++)
+        m_handleRows[m_handles.at(r)] = r;
+    publish();
+    endRemoveRows();
+}
+//!
+//! \brief Solids::publish makes the current rows the version snapshots read
+//! Chunks without a moved or edited row are shared with the last version,
+//! so the cost is in the number of changed chunks rather than in the
+//! size of the map. The new version replaces the old one atomically.
+//!
+void Solids::publish() {
+    std::shared_ptr<const SolidsVersion> previous = std::atomic_load(&m_published);
+    std::shared_ptr<SolidsVersion> next = std::make_shared<SolidsVersion>();
+    next->revision = previous->revision + 1;
+    next->count = m_brushes.count();
+
+    const int chunks = (next->count + SNAPSHOT_CHUNK_BRUSHES - 1) / SNAPSHOT_CHUNK_BRUSHES;
+    const int firstMoved = m_dirtyFrom / SNAPSHOT_CHUNK_BRUSHES;
+    next->chunks.reserve(chunks);
+    for(int c = 0; c < chunks; c++) {
+        if(c < firstMoved && c < previous->chunks.size() && !m_dirtyChunks.contains(c)) {
+            next->chunks.append(previous->chunks.at(c));
+            continue;
+        }
+        std::shared_ptr<SolidsChunk> chunk = std::make_shared<SolidsChunk>();
+        const int first = c * SNAPSHOT_CHUNK_BRUSHES;
+        const int last = qMin(first + SNAPSHOT_CHUNK_BRUSHES, next->count);
+        chunk->brushes.reserve(last - first);
+        for(int r = first; r < last; r++)
+            chunk->brushes.append(m_brushes.at(r));
+        chunk->handles = m_handles.mid(first, last - first);
+        next->chunks.append(chunk);
+    }
+    std::atomic_store(&m_published, std::shared_ptr<const SolidsVersion>(next));
+    m_dirtyFrom = INT_MAX;
+    m_dirtyChunks.clear();
+}
+//!
+//! \brief Solids::snapshot can be called from any thread
+//! \return the last published version of the model
+//!
+SolidsSnapshot Solids::snapshot() const {
+    return SolidsSnapshot(std::atomic_load(&m_published));
+}
+//!
+//! \brief Solids::handle
+//! \param row
+//! \return the handle of the brush in the row, -1 if there is none
+//!
+BrushHandle Solids::handle(int row) const {
+    if(row < 0 || row >= m_handles.size())
+        return -1;
+    return m_handles.at(row);
+}
+//!
+//! \brief Solids::row
+//! \param handle
+//! \return the row the brush is in, -1 if it was removed
+//!
+int Solids::row(BrushHandle handle) const {
+    if(handle < 0 || handle >= m_handleRows.size())
+        return -1;
+    return m_handleRows.at(handle);
+}
+//!
+//! \brief Solids::polygons returns the polygons of a brush projected in a 2D view
+//! \param row
+//! \param primary - The arbitrary horizontal axis in a 2D view
+//! \param secondary - The arbitrary vertical axis in a 2D view
+//! \return
+//!
+QList<QPolygonF> Solids::polygons(int row, axis primary, axis secondary) const {
+    if (row < 0 || row >= m_brushes.count())
+        return QList<QPolygonF>();
+
+    int view = Polygoniser::viewIndex(primary, secondary);
+    if(view < 0)
+        return Polygoniser::poligonise(&m_brushes.at(row), primary, secondary);
+    return m_polygons.at(row).views[view];
+}
+//!
+//! \brief Solids::editSolids applies an edit to a batch of brushes
+//! The brushes are polygonised again on the thread pool, then dataChanged is
+//! emitted once for every run of neighbouring rows rather than once per brush.
+//! \param handles - Unknown or removed handles are ignored
+//! \param edit - Called with each brush to change it
+//!
+template<typename Edit>
+void Solids::editSolids(const QList<BrushHandle> &handles, Edit edit) {
+    QVector<int> rows;
+    rows.reserve(handles.count());
+    foreach(BrushHandle handle, handles) {
+        int r = row(handle);
+        if(r >= 0)
+            rows.append(r);
+    }
+    if(rows.isEmpty())
+        return;
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+    QList<Brush> edited;
+    edited.reserve(rows.count());
+    foreach(int r, rows) {
+        // Snapshots may still be reading the old planes, the last one frees them
+        const quint64 oldId = m_brushes.at(r).getId();
+        m_brushes[r] = m_brushes.at(r).clone();
+        // The clone has a new id, nothing looks the polygons of the old one up again
+        PolygonCache::global()->invalidate(oldId);
+        edit(m_brushes[r]);
+        edited.append(m_brushes.at(r));
+        m_dirtyChunks.insert(r / SNAPSHOT_CHUNK_BRUSHES);
+    }
+    QVector<ProjectedPolygons> polygons = Polygoniser::poligoniseAll(edited);
+    for(int i = 0; i < rows.count(); i++)
+        m_polygons[rows.at(i)] = polygons.at(i);
+    publish();
+
+    int first = 0;
+    for(int i = 1; i <= rows.count(); i++) {
+        if(i < rows.count() && rows.at(i) == rows.at(i - 1) + 1)
+            continue;
+        emit(dataChanged(index(rows.at(first), 0), index(rows.at(i - 1), 0)));
+        first = i;
+    }
+}
+//!
+//! \brief Solids::translateSolids moves brushes as one edit
+//! \param handles
+//! \param primary - The arbitrary horizontal axis in a 2D view
+//! \param secondary - The arbitrary vertical axis in a 2D view
+//! \param offset - Units to move along primary and secondary
+//!
+void Solids::translateSolids(const QList<BrushHandle> &handles, axis primary, axis secondary, QVector2D offset) {
+    editSolids(handles, [=](Brush &brush) {
+        brush.translate(primary, secondary, offset);
+    });
+}
+//!
+//! \brief Solids::rotateSolids turns brushes around their own centres as one edit
+//! \param handles
+//! \param primary - The arbitrary horizontal axis in a 2D view
+//! \param secondary - The arbitrary vertical axis in a 2D view
+//! \param angle - Degrees
+//!
+void Solids::rotateSolids(const QList<BrushHandle> &handles, axis primary, axis secondary, float angle) {
+    editSolids(handles, [=](Brush &brush) {
+        brush.rotate(primary, secondary, angle);
+    });
+}
+//!
+//! \brief Solids::scaleSolids scales brushes from the world origin as one edit
+//! \param handles
+//! \param primary - The arbitrary horizontal axis in a 2D view
+//! \param secondary - The arbitrary vertical axis in a 2D view
+//! \param factor - Scale along primary and secondary
+//!
+void Solids::scaleSolids(const QList<BrushHandle> &handles, axis primary, axis secondary, QVector2D factor) {
+    editSolids(handles, [=](Brush &brush) {
+        brush.scale(primary, secondary, factor);
+    });
+}
+//!
+//! \brief Solids::brushes
+//! \return every brush in row order
+//!
+const QList<Brush> &Solids::brushes() const {
+    return m_brushes;
+}
+//!
+//! \brief Solids::brush reads a brush in place, unlike data() with BrushRole
+//! \param row - Must be a valid row
+//! \return
+//!
+const Brush &Solids::brush(int row) const {
+    Q_ASSERT(row >= 0 && row < m_brushes.count());
+    return m_brushes.at(row);
+}
+//!
+//! \brief Solids::find
+//! \param handle
+//! \return the brush, 0 if it was removed
+//!
+const Brush *Solids::find(BrushHandle handle) const {
+    int r = row(handle);
+    if(r < 0)
+        return 0;
+    return &m_brushes.at(r);
+}
+//!
+//! \brief Solids::projected
+//! \param row - Must be a valid row
+//! \return the brush polygonised in all three 2D views
+//!
+const ProjectedPolygons &Solids::projected(int row) const {
+    Q_ASSERT(row >= 0 && row < m_polygons.count());
+    return m_polygons.at(row);
+}
+//!
+//! \brief Solids::accountMemory adds the brushes, their projections, the handles and the snapshot to a report
+//! Brushes in the snapshot alias the planes of the rows, only their Brush objects are counted again.
+//! \param report
+//!
+void Solids::accountMemory(MemoryReport *report) const {
+    report->add(MemoryReport::BRUSHES, MemoryReport::containerBytes(m_brushes));
+    foreach(const Brush &brush, m_brushes)
+        brush.accountMemory(report);
+
+    qint64 polygonBytes = MemoryReport::containerBytes(m_polygons);
+    qint64 polygonCount = 0;
+    foreach(const ProjectedPolygons &projected, m_polygons) {
+        for(int view = 0; view < 3; view++) {
+            polygonBytes += MemoryReport::containerBytes(projected.views[view]);
+            foreach(const QPolygonF &polygon, projected.views[view])
+                polygonBytes += MemoryReport::containerBytes(polygon);
+            polygonCount += projected.views[view].count();
+        }
+    }
+    report->add(MemoryReport::POLYGONS, polygonBytes, polygonCount);
+
+    report->add(MemoryReport::HANDLES, MemoryReport::containerBytes(m_handles)
+                + MemoryReport::containerBytes(m_handleRows), m_handles.count());
+
+    std::shared_ptr<const SolidsVersion> version = std::atomic_load(&m_published);
+    qint64 snapshotBytes = sizeof(SolidsVersion) + MemoryReport::containerBytes(version->chunks);
+    foreach(const std::shared_ptr<const SolidsChunk> &chunk, version->chunks) {
+        snapshotBytes += sizeof(SolidsChunk) + MemoryReport::containerBytes(chunk->brushes)
+                + MemoryReport::containerBytes(chunk->handles);
+    }
+    report->add(MemoryReport::SNAPSHOT, snapshotBytes, version->chunks.count());
 }
@@ -3,7 +3,10 @@
 
 #include <QObject>
 #include <QAbstractListModel>
+#include <QSet>
 #include "brush.h"
+#include "polygoniser.h"
+#include "solidssnapshot.h"
 
 //!
 //! \brief The Solids List Model contains all the data defined by the world
@@ -12,10 +15,22 @@ class Solids : public QAbstractListModel
 {
     Q_OBJECT
     QList<Brush> m_brushes; //! The Brushes defining the 3D blocks in the game world
+    QVector<ProjectedPolygons> m_polygons; //! The brushes polygonised for each 2D view
+    QVector<BrushHandle> m_handles; //! The handle of each row
+    QVector<int> m_handleRows;  //! The row of each handle, -1 once removed
+    std::shared_ptr<const SolidsVersion> m_published;  //! Only touched with std::atomic_load/store
+    int m_dirtyFrom;            //! Rows from here on moved since the last publish
+    QSet<int> m_dirtyChunks;    //! Chunks with rows edited since the last publish
+
+    void removeSortedRows(const QVector<int> &rows);
+    void publish();
+    template<typename Edit>
+    void editSolids(const QList<BrushHandle> &handles, Edit edit);
 
 public:
     enum SolidsRoles {
         BrushRole = Qt::UserRole + 1,
+        HandleRole,
     };
 
     Solids(QObject *parent = 0);
@@ -25,7 +40,39 @@ public:
     int rowCount(const QModelIndex &parent = QModelIndex()) const;
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
     void addSolid(const Brush &newBrush);
+    QVector<BrushHandle> addSolids(const QList<Brush> &newBrushes);
+    void removeSolids(const QList<BrushHandle> &handles);
+    bool removeRows(int row, int count, const QModelIndex &parent = QModelIndex());
+    BrushHandle handle(int row) const;
+    int row(BrushHandle handle) const;
+    QList<QPolygonF> polygons(int row, axis primary, axis secondary) const;
+    const QList<Brush> &brushes() const;
+    const Brush &brush(int row) const;
+    const Brush *find(BrushHandle handle) const;
+    const ProjectedPolygons &projected(int row) const;
+    template<typename Visitor>
+    void visitBrushes(int first, int last, Visitor visit) const;
+    SolidsSnapshot snapshot() const;
+    void translateSolids(const QList<BrushHandle> &handles, axis primary, axis secondary, QVector2D offset);
+    void rotateSolids(const QList<BrushHandle> &handles, axis primary, axis secondary, float angle);
+    void scaleSolids(const QList<BrushHandle> &handles, axis primary, axis secondary, QVector2D factor);
+    void accountMemory(MemoryReport *report) const;
 
 };
 
+//!
+//! \brief Solids::visitBrushes calls visit(row, brush, polygons) for a range of rows
+//! Nothing is copied, so visit must not keep the references or edit the model.
+//! \param first
+//! \param last - Clamped to the last row
+//! \param visit
+//!
+template<typename Visitor>
+void Solids::visitBrushes(int first, int last, Visitor visit) const {
+    first = qMax(first, 0);
+    last = qMin(last, m_brushes.count() - 1);
+    for(int row = first; row <= last; row++)
+        visit(row, m_brushes.at(row), m_polygons.at(row));
+}
+
 #endif // SOLIDS_H
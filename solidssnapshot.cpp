@@ -0,0 +1,85 @@
+/*
+This file is part of World Editor.
+
+World Editor is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+World Editor is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "solidssnapshot.h"
+
+//!
+//! \brief SolidsVersion::SolidsVersion an empty model
+//!
+SolidsVersion::SolidsVersion()
+    : revision(0), count(0)
+{
+}
+
+//!
+//! \brief SolidsSnapshot::SolidsSnapshot an empty snapshot
+//!
+SolidsSnapshot::SolidsSnapshot()
+    : m_version(std::make_shared<SolidsVersion>())
+{
+}
+//!
+//! \brief SolidsSnapshot::SolidsSnapshot
+//! \param version - Published by Solids
+//!
+SolidsSnapshot::SolidsSnapshot(const std::shared_ptr<const SolidsVersion> &version)
+    : m_version(version)
+{
+}
+//!
+//! \brief SolidsSnapshot::revision
+//! \return the version of the model the snapshot was taken from
+//!
+quint64 SolidsSnapshot::revision() const {
+    return m_version->revision;
+}
+//!
+//! \brief SolidsSnapshot::count
+//! \return
+//!
+int SolidsSnapshot::count() const {
+    return m_version->count;
+}
+//!
+//! \brief SolidsSnapshot::brush
+//! \param row - Must be a valid row
+//! \return
+//!
+const Brush &SolidsSnapshot::brush(int row) const {
+    Q_ASSERT(row >= 0 && row < m_version->count);
+    return m_version->chunks.at(row / SNAPSHOT_CHUNK_BRUSHES)->brushes.at(row % SNAPSHOT_CHUNK_BRUSHES);
+}
+//!
+//! \brief SolidsSnapshot::handle
+//! \param row - Must be a valid row
+//! \return
+//!
+BrushHandle SolidsSnapshot::handle(int row) const {
+    Q_ASSERT(row >= 0 && row < m_version->count);
+    return m_version->chunks.at(row / SNAPSHOT_CHUNK_BRUSHES)->handles.at(row % SNAPSHOT_CHUNK_BRUSHES);
+}
+//!
+//! \brief SolidsSnapshot::sharesChunk
+//! \param other
+//! \param chunk
+//! \return true if both snapshots point at the same memory for a chunk
+//!
+bool SolidsSnapshot::sharesChunk(const SolidsSnapshot &other, int chunk) const {
+    if(chunk < 0 || chunk >= m_version->chunks.size() || chunk >= other.m_version->chunks.size())
+        return false;
+    return m_version->chunks.at(chunk) == other.m_version->chunks.at(chunk);
+}
@@ -0,0 +1,74 @@
+/*
+This file is part of World Editor.
+
+World Editor is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+World Editor is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SOLIDSSNAPSHOT_H
+#define SOLIDSSNAPSHOT_H
+
+#include <memory>
+#include <QVector>
+#include "brush.h"
+
+//! Identifies a brush for as long as it is in the model, whatever its row.
+//! Handles are never reused, so a stale one simply finds no row.
+typedef int BrushHandle;
+
+//! Rows held by each chunk of a snapshot
+#define SNAPSHOT_CHUNK_BRUSHES 256
+
+//!
+//! \brief The SolidsChunk struct is a run of rows frozen in a snapshot
+//! A chunk never changes once published, versions of the model which did
+//! not touch its rows point at the same chunk.
+//!
+struct SolidsChunk
+{
+    QVector<Brush> brushes;
+    QVector<BrushHandle> handles;
+};
+
+//!
+//! \brief The SolidsVersion struct is every row of the model at one point in time
+//!
+struct SolidsVersion
+{
+    SolidsVersion();
+    quint64 revision;   //! Counts the versions published by the model
+    int count;          //! Number of rows
+    QVector<std::shared_ptr<const SolidsChunk> > chunks;
+};
+
+//!
+//! \brief The SolidsSnapshot class is a consistent read only view of a Solids model
+//! Snapshots are cheap to copy and safe to read from any thread, without
+//! locks, while the model carries on being edited. The planes of a brush
+//! are never changed once a snapshot can see them, the model edits a copy.
+//!
+class SolidsSnapshot
+{
+    std::shared_ptr<const SolidsVersion> m_version;
+
+public:
+    SolidsSnapshot();
+    SolidsSnapshot(const std::shared_ptr<const SolidsVersion> &version);
+    quint64 revision() const;
+    int count() const;
+    const Brush &brush(int row) const;
+    BrushHandle handle(int row) const;
+    bool sharesChunk(const SolidsSnapshot &other, int chunk) const;
+};
+
+#endif // SOLIDSSNAPSHOT_H
@@ -0,0 +1,83 @@
+/*
+This file is part of World Editor.
+
+World Editor is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+World Editor is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QDebug>
+#include <QStringList>
+#include "startuptrace.h"
+
+QElapsedTimer StartupTrace::s_timer;
+QVector<QPair<QString, qint64> > StartupTrace::s_marks;
+bool StartupTrace::s_finished = false;
+
+//!
+//! \brief StartupTrace::begin starts the clock, call it first thing in main
+//!
+void StartupTrace::begin() {
+    s_marks.clear();
+    s_finished = false;
+    s_timer.start();
+}
+//!
+//! \brief StartupTrace::mark records that a step of the startup is done
+//! Does nothing once the first frame is out, or if begin was never called.
+//! \param step
+//!
+void StartupTrace::mark(const QString &step) {
+    if(s_finished || !s_timer.isValid())
+        return;
+    s_marks.append(qMakePair(step, s_timer.nsecsElapsed()));
+}
+//!
+//! \brief StartupTrace::firstFrame marks the first frame and prints the trace
+//! Only the first call does anything, every paint can call it.
+//!
+void StartupTrace::firstFrame() {
+    if(s_finished || !s_timer.isValid())
+        return;
+    mark("first frame");
+    s_finished = true;
+    qDebug().noquote() << summary();
+}
+//!
+//! \brief StartupTrace::isFinished
+//! \return true once the first frame was painted
+//!
+bool StartupTrace::isFinished() {
+    return s_finished;
+}
+//!
+//! \brief StartupTrace::elapsed
+//! \param step
+//! \return ns from begin to the step, -1 if it wasn't marked
+//!
+qint64 StartupTrace::elapsed(const QString &step) {
+    for(int i = 0; i < s_marks.size(); i++) {
+        if(s_marks.at(i).first == step)
+            return s_marks.at(i).second;
+    }
+    return -1;
+}
+//!
+//! \brief StartupTrace::summary
+//! \return every step with the ms since begin, like "Startup: window 40.1 ms, first frame 95.3 ms"
+//!
+QString StartupTrace::summary() {
+    QStringList steps;
+    for(int i = 0; i < s_marks.size(); i++)
+        steps << QString("%1 %2 ms").arg(s_marks.at(i).first).arg(s_marks.at(i).second / 1e6, 0, 'f', 1);
+    return "Startup: " + steps.join(", ");
+}
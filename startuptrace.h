@@ -0,0 +1,47 @@
+/*
+This file is part of World Editor.
+
+World Editor is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+World Editor is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef STARTUPTRACE_H
+#define STARTUPTRACE_H
+
+#include <QElapsedTimer>
+#include <QPair>
+#include <QString>
+#include <QVector>
+
+//!
+//! \brief The StartupTrace class times the steps from launch to the first frame
+//! main starts it, the steps in between mark themselves, and the first
+//! 2D view to paint finishes it and prints one line with every step.
+//! Only used from the GUI thread.
+//!
+class StartupTrace
+{
+    static QElapsedTimer s_timer;
+    static QVector<QPair<QString, qint64> > s_marks;   //! Step and ns since begin
+    static bool s_finished;
+
+public:
+    static void begin();
+    static void mark(const QString &step);
+    static void firstFrame();
+    static bool isFinished();
+    static qint64 elapsed(const QString &step);
+    static QString summary();
+};
+
+#endif // STARTUPTRACE_H
@@ -23,25 +23,43 @@ allTests::allTests(QObject *parent) : QObject(parent)
 }
 
 bool allTests::runTests() {
+    int failures = 0;
+
     //! Run Plane tests
     PlaneTests planeTest;
-    QTest::qExec(&planeTest);
+    failures += QTest::qExec(&planeTest);
 
     //! Run Brush tests
     BrushTests brushTest;
-    QTest::qExec(&brushTest);
+    failures += QTest::qExec(&brushTest);
 
     //! Run Map tests
     MapTests mapTest;
-    QTest::qExec(&mapTest);
+    failures += QTest::qExec(&mapTest);
 
     //! Run Polygon tests
     PolygonTests polyTests;
-    QTest::qExec(&polyTests);
+    failures += QTest::qExec(&polyTests);
 
     //! Run Polygon tests
     ViewPortTests vtests;
-    QTest::qExec(&vtests);
+    failures += QTest::qExec(&vtests);
+
+    //! Run Renderer tests
+    RendererTests rtests;
+    failures += QTest::qExec(&rtests);
+
+    //! Run World tree tests
+    WorldTreeTests ttests;
+    failures += QTest::qExec(&ttests);
+
+    //! Run Job system tests
+    JobSystemTests jtests;
+    failures += QTest::qExec(&jtests);
+
+    //! Run Trace tests
+    TraceTests traceTests;
+    failures += QTest::qExec(&traceTests);
 
-    return 0;
+    return failures != 0;
 }
@@ -23,6 +23,10 @@ along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
 #include "tests/maptests.h"
 #include "tests/polygontests.h"
 #include "tests/viewporttests.h"
+#include "tests/renderertests.h"
+#include "tests/worldtreetests.h"
+#include "tests/jobsystemtests.h"
+#include "tests/tracetests.h"
 
 class allTests : public QObject
 {
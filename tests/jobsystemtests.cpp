@@ -0,0 +1,160 @@
+#include "jobsystemtests.h"
+#include <QThread>
+
+//!
+//! \brief JobSystemTests::testRun every job runs once, off the calling thread
+//!
+void JobSystemTests::testRun() {
+    JobSystem jobs(4);
+    QCOMPARE(jobs.workerCount(), 4);
+
+    QAtomicInt count(0);
+    QAtomicInt elsewhere(0);
+    QThread *caller = QThread::currentThread();
+    QVector<JobHandle> handles;
+    for(int i = 0; i < 1000; i++) {
+        handles.append(jobs.run([&]() {
+            count.ref();
+            if(QThread::currentThread() != caller)
+                elsewhere.ref();
+        }));
+    }
+    jobs.wait(handles);
+    QCOMPARE(count.load(), 1000);
+    QVERIFY(elsewhere.load() > 0);
+    foreach(const JobHandle &handle, handles)
+        QVERIFY(handle.isFinished());
+    QVERIFY(JobHandle().isFinished());
+}
+//!
+//! \brief JobSystemTests::testParallelFor every index is visited exactly once
+//!
+void JobSystemTests::testParallelFor() {
+    JobSystem jobs(4);
+    QVector<int> visits(10007, 0);
+    int *data = visits.data();
+    jobs.parallelFor(0, visits.size(), [data](int i) {
+        data[i]++;
+    }, 64);
+    QCOMPARE(visits.count(1), visits.size());
+
+    // Empty and reversed ranges do nothing
+    int calls = 0;
+    jobs.parallelFor(5, 5, [&calls](int) { calls++; });
+    jobs.parallelFor(5, 0, [&calls](int) { calls++; });
+    QCOMPARE(calls, 0);
+}
+//!
+//! \brief JobSystemTests::testDependencies a continuation runs after all of its dependencies
+//!
+void JobSystemTests::testDependencies() {
+    JobSystem jobs(4);
+    QAtomicInt finished(0);
+    QAtomicInt seen(-1);
+
+    QVector<JobHandle> first;
+    for(int i = 0; i < 8; i++) {
+        first.append(jobs.run([&finished]() {
+            QThread::msleep(2);
+            finished.ref();
+        }));
+    }
+    JobHandle second = jobs.then(first, [&]() {
+        seen.store(finished.load());
+    });
+    JobHandle third = jobs.then(QVector<JobHandle>() << second, [&]() {
+        seen.ref();
+    });
+    jobs.wait(third);
+    QVERIFY(second.isFinished());
+    QCOMPARE(seen.load(), 9);
+
+    // Finished and null dependencies don't hold a job back
+    bool ran = false;
+    jobs.wait(jobs.then(QVector<JobHandle>() << second << JobHandle(), [&ran]() { ran = true; }));
+    QVERIFY(ran);
+}
+//!
+//! \brief JobSystemTests::testCancellation jobs not started when the token is cancelled are skipped
+//!
+void JobSystemTests::testCancellation() {
+    JobSystem jobs(2);
+    CancellationToken token;
+    QAtomicInt ran(0);
+
+    // Hold both workers until everything is queued
+    QAtomicInt started(0);
+    QAtomicInt release(0);
+    QVector<JobHandle> blockers;
+    for(int i = 0; i < 2; i++) {
+        blockers.append(jobs.run([&started, &release]() {
+            started.ref();
+            while(!release.loadAcquire())
+                QThread::yieldCurrentThread();
+        }));
+    }
+    while(started.loadAcquire() < 2)
+        QThread::yieldCurrentThread();
+    QVector<JobHandle> handles;
+    for(int i = 0; i < 100; i++)
+        handles.append(jobs.run([&ran]() { ran.ref(); }, token));
+    bool continued = false;
+    JobHandle after = jobs.then(handles, [&continued]() { continued = true; });
+
+    token.cancel();
+    QVERIFY(token.isCancelled());
+    release.storeRelease(1);
+    jobs.wait(after);
+    jobs.wait(blockers);
+    QCOMPARE(ran.load(), 0);
+    // Cancelled jobs still count as finished for their continuations
+    QVERIFY(continued);
+
+    // A cancelled parallel for stops handing out indexes
+    CancellationToken stop;
+    QAtomicInt visited(0);
+    jobs.parallelFor(0, 100000, [&](int) {
+        if(visited.fetchAndAddRelaxed(1) == 10)
+            stop.cancel();
+    }, 100, stop);
+    QVERIFY(visited.load() < 100000);
+}
+//!
+//! \brief JobSystemTests::testNestedWait jobs can wait for jobs they submit without deadlocking
+//!
+void JobSystemTests::testNestedWait() {
+    JobSystem jobs(2);
+    QAtomicInt leaves(0);
+    QVector<JobHandle> outer;
+    for(int i = 0; i < 8; i++) {
+        outer.append(jobs.run([&]() {
+            jobs.parallelFor(0, 64, [&leaves](int) { leaves.ref(); }, 1);
+        }));
+    }
+    jobs.wait(outer);
+    QCOMPARE(leaves.load(), 8 * 64);
+}
+//!
+//! \brief JobSystemTests::testPostToMain results posted from a worker arrive on the main thread
+//!
+void JobSystemTests::testPostToMain() {
+    JobSystem jobs(2);
+    QObject context;
+    QThread *main = QThread::currentThread();
+    QThread *arrived = 0;
+    int result = 0;
+
+    jobs.wait(jobs.run([&]() {
+        int sum = 0;
+        for(int i = 1; i <= 100; i++)
+            sum += i;
+        JobSystem::postToMain(&context, [&, sum]() {
+            arrived = QThread::currentThread();
+            result = sum;
+        });
+    }));
+    // Queued, so nothing has happened before the event loop runs
+    QCOMPARE(result, 0);
+    QTRY_COMPARE(result, 5050);
+    QCOMPARE(arrived, main);
+}
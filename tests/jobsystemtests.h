@@ -0,0 +1,22 @@
+#ifndef JOBSYSTEMTESTS_H
+#define JOBSYSTEMTESTS_H
+
+#include <QObject>
+#include <QTest>
+
+#include "jobsystem.h"
+
+class JobSystemTests : public QObject
+{
+    Q_OBJECT
+private slots:
+    void testRun();
+    void testParallelFor();
+    void testDependencies();
+    void testCancellation();
+    void testNestedWait();
+    void testPostToMain();
+
+};
+
+#endif // JOBSYSTEMTESTS_H
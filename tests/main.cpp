@@ -0,0 +1,13 @@
+#include <QApplication>
+#include "alltests.h"
+
+//!
+//! \brief main runs every test suite
+//! \return 0 when they all passed
+//!
+int main(int argc, char *argv[])
+{
+    QApplication a(argc, argv);
+    allTests tests;
+    return tests.runTests();
+}
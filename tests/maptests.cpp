@@ -15,8 +15,14 @@ You should have received a copy of the GNU General Public License
 along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include "solids.h"
+#include "polygoncache.h"
 #include "maptests.h"
+#include "testbrushes.h"
 #include "QSignalSpy"
+#include <QtConcurrent>
+
+//! Bytes a simple box may take in the map, projections included
+#define BOX_MEMORY_BUDGET (8*1024)
 
 //!
 //! \brief MapTests::init
@@ -47,6 +53,255 @@ void MapTests::testInsertBrush() {
     QCOMPARE(spy.count(), 1); // make sure the signal was emitted exactly one time
 }
 
+//!
+//! \brief MapTests::testInsertBrushes
+//!
+void MapTests::testInsertBrushes() {
+
+    Solids newSolids;
+    QSignalSpy spy(&newSolids, SIGNAL(rowsInserted(QModelIndex,int,int)));
+
+    QList<Brush> brushes;
+    for(int i = 0; i < 3; i++) {
+        QList<Plane*> planes;
+        planes.prepend(new Plane(QVector3D(-128, 32, 128),QVector3D(128, 32, 128),QVector3D(128, 0, 128)));
+        planes.prepend(new Plane(QVector3D(-128, 0, 0),QVector3D(128, 0, 0),QVector3D(128, 32, 0)));
+        planes.prepend(new Plane(QVector3D(-128, 32, 128),QVector3D(-128, 0, 128),QVector3D(-128, 0, 0)));
+        planes.prepend(new Plane(QVector3D(128, 32, 0),QVector3D(128, 0, 0),QVector3D(128, 0, 128)));
+        planes.prepend(new Plane(QVector3D(128, 32, 128),QVector3D(-128, 32, 128),QVector3D(-128, 32, 0)));
+        planes.prepend(new Plane(QVector3D(128, 0, 0),QVector3D(-128, 0, 0),QVector3D(-128, 0, 128)));
+        brushes.append(Brush(planes));
+    }
+    newSolids.addSolids(brushes);
+
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(1).toInt(), 0);
+    QCOMPARE(spy.at(0).at(2).toInt(), 2);
+    for(int row = 0; row < 3; row++) {
+        QCOMPARE(newSolids.polygons(row, X_AXIS, Y_AXIS).count(), 6);
+        QCOMPARE(newSolids.polygons(row, Y_AXIS, Z_AXIS).count(), 6);
+        QCOMPARE(newSolids.polygons(row, X_AXIS, Z_AXIS).count(), 6);
+    }
+}
+
+//!
+//! \brief MapTests::testRemoveSolids
+//!
+void MapTests::testRemoveSolids() {
+
+    Solids newSolids;
+    QList<Brush> brushes = boxBrushes(5);
+    QVector<BrushHandle> handles = newSolids.addSolids(brushes);
+    QCOMPARE(handles.count(), 5);
+
+    QSignalSpy removed(&newSolids, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+    QSignalSpy layout(&newSolids, SIGNAL(layoutChanged()));
+    newSolids.removeSolids(QList<BrushHandle>() << handles.at(2) << handles.at(1));
+
+    QCOMPARE(removed.count(), 1);
+    QCOMPARE(removed.at(0).at(1).toInt(), 1);
+    QCOMPARE(removed.at(0).at(2).toInt(), 2);
+    QCOMPARE(layout.count(), 0);
+    QCOMPARE(newSolids.rowCount(), 3);
+    QCOMPARE(newSolids.row(handles.at(1)), -1);
+    QCOMPARE(newSolids.row(handles.at(2)), -1);
+    QCOMPARE(newSolids.row(handles.at(3)), 1);
+    QCOMPARE(newSolids.row(handles.at(4)), 2);
+    QCOMPARE(newSolids.handle(2), handles.at(4));
+    QCOMPARE(newSolids.index(1, 0).data(Solids::HandleRole).toInt(), handles.at(3));
+
+    // Stale handles are ignored
+    newSolids.removeSolids(QList<BrushHandle>() << handles.at(1));
+    QCOMPARE(removed.count(), 1);
+}
+
+//!
+//! \brief MapTests::testRemoveScatteredSolids
+//!
+void MapTests::testRemoveScatteredSolids() {
+
+    Solids newSolids;
+    QList<Brush> brushes = boxBrushes(2000);
+    QVector<BrushHandle> handles = newSolids.addSolids(brushes);
+
+    QPersistentModelIndex kept(newSolids.index(1999, 0));
+    QSignalSpy removed(&newSolids, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+    QSignalSpy layout(&newSolids, SIGNAL(layoutChanged()));
+    QSignalSpy reset(&newSolids, SIGNAL(modelReset()));
+
+    QList<BrushHandle> alternate;
+    for(int i = 0; i < 2000; i += 2)
+        alternate.append(handles.at(i));
+    newSolids.removeSolids(alternate);
+
+    QCOMPARE(removed.count(), 1);
+    QCOMPARE(layout.count(), 1);
+    QCOMPARE(reset.count(), 0);
+    QCOMPARE(newSolids.rowCount(), 1000);
+    for(int row = 0; row < 1000; row++)
+        QCOMPARE(newSolids.handle(row), handles.at(row * 2 + 1));
+    QCOMPARE(newSolids.row(handles.at(0)), -1);
+    QVERIFY(kept.isValid());
+    QCOMPARE(kept.row(), 999);
+}
+
+//!
+//! \brief MapTests::testEditSolids neighbouring rows are reported as one change
+//!
+void MapTests::testEditSolids() {
+
+    Solids newSolids;
+    QList<Brush> brushes = boxBrushes(10);
+    QVector<BrushHandle> handles = newSolids.addSolids(brushes);
+
+    QSignalSpy changed(&newSolids, SIGNAL(dataChanged(QModelIndex,QModelIndex,QVector<int>)));
+    newSolids.translateSolids(QList<BrushHandle>() << handles.at(7) << handles.at(3)
+                              << handles.at(2) << handles.at(4) << -1,
+                              X_AXIS, Y_AXIS, QVector2D(64, 0));
+
+    QCOMPARE(changed.count(), 2);
+    QCOMPARE(changed.at(0).at(0).toModelIndex().row(), 2);
+    QCOMPARE(changed.at(0).at(1).toModelIndex().row(), 4);
+    QCOMPARE(changed.at(1).at(0).toModelIndex().row(), 7);
+    QCOMPARE(changed.at(1).at(1).toModelIndex().row(), 7);
+
+    Brush moved = newSolids.brush(3);
+    QCOMPARE(moved.getCenter(X_AXIS, Y_AXIS), QVector2D(64, 16));
+    Brush still = newSolids.brush(5);
+    QCOMPARE(still.getCenter(X_AXIS, Y_AXIS), QVector2D(0, 16));
+    QRectF bounds;
+    foreach(const QPolygonF &polygon, newSolids.polygons(3, X_AXIS, Y_AXIS))
+        bounds = bounds.united(polygon.boundingRect());
+    QCOMPARE(bounds.center().x(), 64.0);
+}
+
+//!
+//! \brief MapTests::testPolygonCacheFollowsEdits edited and removed brushes leave no polygons behind
+//!
+void MapTests::testPolygonCacheFollowsEdits() {
+    PolygonCache *cache = PolygonCache::global();
+    cache->clear();
+    Solids newSolids;
+    QVector<BrushHandle> handles = newSolids.addSolids(boxBrushes(10));
+    for(int r = 0; r < 10; r++) {
+        Brush brush = newSolids.brush(r);
+        brush.polygonise(X_AXIS, Y_AXIS);
+    }
+    QCOMPARE(cache->statistics().entries, 10);
+
+    // Edited rows hold a clone with a new id, the entries of the old one go
+    newSolids.translateSolids(QList<BrushHandle>() << handles.at(2) << handles.at(5),
+                              X_AXIS, Y_AXIS, QVector2D(64, 0));
+    QCOMPARE(cache->statistics().entries, 8);
+
+    newSolids.removeSolids(QList<BrushHandle>() << handles.at(0) << handles.at(7));
+    QCOMPARE(cache->statistics().entries, 6);
+    newSolids.removeRows(0, newSolids.rowCount());
+    QCOMPARE(cache->statistics().entries, 0);
+}
+
+//!
+//! \brief MapTests::testSnapshot snapshots keep their rows and share the unchanged ones
+//!
+void MapTests::testSnapshot() {
+
+    Solids newSolids;
+    QList<Brush> brushes = boxBrushes(1000);
+    QVector<BrushHandle> handles = newSolids.addSolids(brushes);
+
+    SolidsSnapshot before = newSolids.snapshot();
+    QCOMPARE(before.count(), 1000);
+    QCOMPARE(before.handle(300), handles.at(300));
+
+    newSolids.translateSolids(QList<BrushHandle>() << handles.at(300), X_AXIS, Y_AXIS,
+                              QVector2D(64, 0));
+    SolidsSnapshot after = newSolids.snapshot();
+    QCOMPARE(after.revision(), before.revision() + 1);
+
+    Brush old = before.brush(300);
+    QCOMPARE(old.getCenter(X_AXIS, Y_AXIS), QVector2D(0, 16));
+    Brush moved = after.brush(300);
+    QCOMPARE(moved.getCenter(X_AXIS, Y_AXIS), QVector2D(64, 16));
+
+    // Only the chunk holding the edited row was copied
+    QVERIFY(after.sharesChunk(before, 0));
+    QVERIFY(!after.sharesChunk(before, 300 / SNAPSHOT_CHUNK_BRUSHES));
+    QVERIFY(after.sharesChunk(before, 999 / SNAPSHOT_CHUNK_BRUSHES));
+
+    newSolids.removeSolids(QList<BrushHandle>() << handles.at(0));
+    QCOMPARE(newSolids.snapshot().count(), 999);
+    QCOMPARE(newSolids.snapshot().handle(0), handles.at(1));
+    QCOMPARE(after.count(), 1000);
+    QCOMPARE(after.handle(0), handles.at(0));
+}
+
+//!
+//! \brief MapTests::testConcurrentSnapshots a worker reads snapshots while the model is edited
+//!
+void MapTests::testConcurrentSnapshots() {
+
+    Solids newSolids;
+    QList<Brush> brushes = boxBrushes(2000);
+    QVector<BrushHandle> handles = newSolids.addSolids(brushes);
+
+    QAtomicInt stop(0);
+    QFuture<int> reader = QtConcurrent::run([&]() {
+        int inconsistent = 0;
+        while(!stop.loadAcquire()) {
+            SolidsSnapshot snapshot = newSolids.snapshot();
+            // Every brush of one snapshot has been moved the same number of times
+            qreal x = snapshot.brush(0).getPlanes().first()->getBotLeft().x();
+            for(int row = 1; row < snapshot.count(); row++) {
+                if(snapshot.brush(row).getPlanes().first()->getBotLeft().x() != x)
+                    inconsistent++;
+            }
+        }
+        return inconsistent;
+    });
+
+    QList<BrushHandle> all = handles.toList();
+    for(int i = 0; i < 20; i++)
+        newSolids.translateSolids(all, X_AXIS, Y_AXIS, QVector2D(64, 0));
+    stop.storeRelease(1);
+
+    QCOMPARE(reader.result(), 0);
+    QCOMPARE(newSolids.snapshot().brush(0).getPlanes().first()->getBotLeft().x(),
+             brushes.first().getPlanes().first()->getBotLeft().x() + 20 * 64);
+}
+
+//!
+//! \brief MapTests::testEditsFreePlanes edited brushes free their old planes with the last snapshot
+//!
+void MapTests::testEditsFreePlanes() {
+
+    const int live = Plane::liveCount();
+    {
+        Solids newSolids;
+        QVector<BrushHandle> handles = newSolids.addSolids(boxBrushes(100));
+        QList<BrushHandle> all = handles.toList();
+        QCOMPARE(Plane::liveCount(), live + 600);
+
+        for(int i = 0; i < 20; i++) {
+            newSolids.translateSolids(all, X_AXIS, Y_AXIS, QVector2D(64, 0));
+            newSolids.rotateSolids(all, X_AXIS, Y_AXIS, 90);
+        }
+        QCOMPARE(Plane::liveCount(), live + 600);
+
+        // A snapshot keeps the planes it was taken with until it goes
+        {
+            SolidsSnapshot held = newSolids.snapshot();
+            newSolids.translateSolids(QList<BrushHandle>() << handles.at(0), X_AXIS, Y_AXIS,
+                                      QVector2D(64, 0));
+            QCOMPARE(Plane::liveCount(), live + 606);
+        }
+        QCOMPARE(Plane::liveCount(), live + 600);
+
+        newSolids.removeSolids(all.mid(0, 50));
+        QCOMPARE(Plane::liveCount(), live + 300);
+    }
+    QCOMPARE(Plane::liveCount(), live);
+}
+
 //!
 //! \brief MapTests::testReturnBrush
 //!
@@ -70,6 +325,36 @@ void MapTests::testReturnBrush() {
 
 }
 
+//!
+//! \brief MapTests::testBrushAccess
+//!
+void MapTests::testBrushAccess() {
+    Map map;
+    map.readVMF(":/vmfs/testBox.vmf");
+    const Solids &solids = map.m_solids;
+
+    // The accessors hand out the stored brush, not a copy of it
+    QCOMPARE(&solids.brush(0), &solids.brushes().at(0));
+    QCOMPARE(solids.find(solids.handle(0)), &solids.brush(0));
+    QCOMPARE(solids.brush(0).getId(),
+             solids.index(0, 0).data(Solids::BrushRole).value<Brush>().getId());
+
+    int visited = 0;
+    solids.visitBrushes(0, solids.rowCount() + 5, [&](int row, const Brush &brush,
+                                                      const ProjectedPolygons &projected) {
+        QCOMPARE(&brush, &solids.brush(row));
+        QCOMPARE(projected.views[Polygoniser::viewIndex(X_AXIS, Y_AXIS)].count(),
+                 solids.polygons(row, X_AXIS, Y_AXIS).count());
+        visited++;
+    });
+    QCOMPARE(visited, solids.rowCount());
+
+    solids.visitBrushes(-3, -1, [&](int, const Brush &, const ProjectedPolygons &) {
+        visited++;
+    });
+    QCOMPARE(visited, solids.rowCount());
+}
+
 void MapTests::testReadVMFSolid() {
     Map map;
     map.readVMF(":/vmfs/testBox.vmf");
@@ -98,3 +383,134 @@ void MapTests::testReadVMFViewSettings() {
     QCOMPARE(map.m_viewSettings.nGridSpacing, 32);
     QCOMPARE(map.m_viewSettings.bShow3DGrid, false);
 }
+
+void MapTests::testReadVMFCameras() {
+    Map map;
+    QCOMPARE(map.activeCamera().position, QVector3D(0, 0, 0));
+    QCOMPARE(map.activeCamera().look, QVector3D(0, 1, 0));
+
+    map.readVMF(":/vmfs/testCamera.vmf");
+    QCOMPARE(map.m_cameras.count(), 2);
+    QCOMPARE(map.m_activecamera, 1);
+    QCOMPARE(map.activeCamera().position, QVector3D(-384, -384, 192.5));
+    QCOMPARE(map.activeCamera().look, QVector3D(0, 16, 64));
+    QCOMPARE(map.m_solids.rowCount(), 1);
+}
+
+//!
+//! \brief MapTests::testReadVMFAllSolids every solid of the world is read, not only the first
+//!
+void MapTests::testReadVMFAllSolids() {
+    Map map;
+    map.readVMF(":/vmfs/testSolids.vmf");
+    QCOMPARE(map.m_solids.rowCount(), 2);
+    Brush first = map.m_solids.index(0,0).data(Solids::BrushRole).value<Brush>();
+    QCOMPARE(first.getCenter(X_AXIS, Y_AXIS), QVector2D(0,16));
+}
+
+//!
+//! \brief MapTests::testReadVMFFloatPlanes plane points with a fraction are not truncated
+//!
+void MapTests::testReadVMFFloatPlanes() {
+    Map map;
+    map.readVMF(":/vmfs/testSolids.vmf");
+    QCOMPARE(map.m_solids.rowCount(), 2);
+    Brush second = map.m_solids.index(1,0).data(Solids::BrushRole).value<Brush>();
+    QCOMPARE(second.getCenter(X_AXIS, Y_AXIS), QVector2D(288.5,16));
+}
+
+//!
+//! \brief MapTests::testReadVMFSkipsUnknownSections blocks the reader does not know are skipped
+//!  whole, at the top level and in the world, and reading carries on after them.
+//!
+void MapTests::testReadVMFSkipsUnknownSections() {
+    Map map;
+    map.readVMF(":/vmfs/testSections.vmf");
+    QCOMPARE(map.m_versionInfo.editorBuild, 7152);
+    // The solid under hidden{} is not part of the world
+    QCOMPARE(map.m_solids.rowCount(), 1);
+    Brush solid = map.m_solids.index(0,0).data(Solids::BrushRole).value<Brush>();
+    QCOMPARE(solid.getCenter(X_AXIS, Y_AXIS), QVector2D(0,16));
+    QCOMPARE(map.m_cameras.count(), 1);
+    QCOMPARE(map.m_activecamera, 0);
+}
+
+//!
+//! \brief MapTests::testReadVMFGroups groups, entities and visgroups are kept for each solid
+//!
+void MapTests::testReadVMFGroups() {
+    Map map;
+    QSignalSpy infoChanged(&map, SIGNAL(solidInfoChanged()));
+    map.readVMF(":/vmfs/testGroups.vmf");
+
+    // The hidden solid is skipped, the func_detail solid is added with the world's
+    QCOMPARE(map.m_solids.rowCount(), 3);
+    QCOMPARE(infoChanged.count(), 1);
+
+    QCOMPARE(map.m_visgroups.count(), 2);
+    QCOMPARE(map.m_visgroups.at(0).name, QString("Buildings"));
+    QCOMPARE(map.m_visgroups.at(0).parent, -1);
+    QCOMPARE(map.m_visgroups.at(1).name, QString("Roofs"));
+    QCOMPARE(map.m_visgroups.at(1).id, 2);
+    QCOMPARE(map.m_visgroups.at(1).parent, 0);
+    QCOMPARE(map.m_visgroups.at(1).color, QColor(0, 255, 0));
+
+    QCOMPARE(map.m_groups.count(), 1);
+    QCOMPARE(map.m_groups.at(0).id, 10);
+
+    Map::s_solid grouped = map.m_solidInfo.value(map.m_solids.handle(0));
+    QCOMPARE(grouped.id, 2);
+    QCOMPARE(grouped.groupid, 10);
+    QCOMPARE(grouped.visgroupids, QList<int>() << 1);
+    QCOMPARE(grouped.entity, -1);
+    QCOMPARE(map.m_solidInfo.value(map.m_solids.handle(1)).groupid, 0);
+
+    QCOMPARE(map.m_entities.count(), 2);
+    QCOMPARE(map.m_entities.at(0).classname, QString("func_detail"));
+    QCOMPARE(map.m_entities.at(0).visgroupids, QList<int>() << 2);
+    QCOMPARE(map.m_entities.at(0).solids.count(), 1);
+    QCOMPARE(map.m_solidInfo.value(map.m_entities.at(0).solids.at(0)).entity, 0);
+    QCOMPARE(map.m_entities.at(1).classname, QString("info_player_start"));
+    QCOMPARE(map.m_entities.at(1).targetname, QString("spawn"));
+    QCOMPARE(map.m_entities.at(1).origin, QVector3D(16, -32, 8));
+    QCOMPARE(map.m_entities.at(1).groupid, 10);
+    QVERIFY(map.m_entities.at(1).solids.isEmpty());
+}
+//!
+//! \brief MapTests::testMemoryReport counts every brush and plane and keeps boxes within budget
+//!
+void MapTests::testMemoryReport() {
+    Map map;
+    QList<Brush> brushes = boxBrushes(500);
+    map.m_solids.addSolids(brushes);
+
+    MemoryReport report;
+    map.accountMemory(&report);
+    QCOMPARE(report.count(MemoryReport::BRUSHES), qint64(500));
+    QCOMPARE(report.count(MemoryReport::PLANES), qint64(3000));
+    QCOMPARE(report.bytes(MemoryReport::PLANES), qint64(3000 * sizeof(Plane)));
+    QCOMPARE(report.count(MemoryReport::HANDLES), qint64(500));
+    QVERIFY(report.count(MemoryReport::POLYGONS) > 0);
+    QCOMPARE(report.count(MemoryReport::SNAPSHOT),
+             qint64((500 + SNAPSHOT_CHUNK_BRUSHES - 1) / SNAPSHOT_CHUNK_BRUSHES));
+    QVERIFY(report.bytesPerBrush() > 0);
+    QVERIFY2(report.bytesPerBrush() <= BOX_MEMORY_BUDGET,
+             qPrintable(report.summary().join('\n')));
+
+    // Removing brushes frees their planes, and the report follows what is allocated
+    const int live = Plane::liveCount();
+    map.m_solids.removeRows(0, 250);
+    QCOMPARE(Plane::liveCount(), live - 1500);
+    MemoryReport after;
+    map.accountMemory(&after);
+    QCOMPARE(after.count(MemoryReport::BRUSHES), qint64(250));
+    QCOMPARE(after.count(MemoryReport::PLANES), qint64(1500));
+    QCOMPARE(report.bytes(MemoryReport::PLANES) - after.bytes(MemoryReport::PLANES),
+             qint64(1500 * sizeof(Plane)));
+
+    QJsonObject json = report.toJson();
+    QCOMPARE(qint64(json["totalBytes"].toDouble()), report.totalBytes());
+    QJsonObject subsystems = json["subsystems"].toObject();
+    QCOMPARE(subsystems.count(), int(MemoryReport::SUBSYSTEM_COUNT));
+    QCOMPARE(qint64(subsystems["planes"].toObject()["count"].toDouble()), qint64(3000));
+}
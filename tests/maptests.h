@@ -29,10 +29,25 @@ class MapTests : public QObject
 private slots:
   void init();
   void testInsertBrush();
+  void testInsertBrushes();
+  void testRemoveSolids();
+  void testRemoveScatteredSolids();
+  void testEditSolids();
+  void testPolygonCacheFollowsEdits();
+  void testSnapshot();
+  void testConcurrentSnapshots();
+  void testEditsFreePlanes();
   void testReturnBrush();
+  void testBrushAccess();
   void testReadVMFSolid();
   void testReadVMFViewSettings();
   void testReadVMFVersionInfo();
+  void testReadVMFCameras();
+  void testReadVMFAllSolids();
+  void testReadVMFFloatPlanes();
+  void testReadVMFSkipsUnknownSections();
+  void testReadVMFGroups();
+  void testMemoryReport();
 
 };
 
@@ -1,6 +1,25 @@
 
 #include "polygontests.h"
 
+//!
+//! \brief octagonalPrism the brush from PolygonTests::testOctagonalPrism
+//! \return
+//!
+static Brush *octagonalPrism() {
+    QList<Plane*> planes;
+    planes.prepend(new Plane(QVector3D(-64,-32,64),QVector3D(-64,32,64),QVector3D(-32,64,64)));
+    planes.prepend(new Plane(QVector3D(-64,32,0),QVector3D(-64,-32,0),QVector3D(-32,-64,0)));
+    planes.prepend(new Plane(QVector3D(-64,-32,0),QVector3D(-64,32,0),QVector3D(-64,32,64)));
+    planes.prepend(new Plane(QVector3D(64,32,0),QVector3D(64,-32,0),QVector3D(64,-32,64)));
+    planes.prepend(new Plane(QVector3D(-32,64,0),QVector3D(32,64,0),QVector3D(32,64,64)));
+    planes.prepend(new Plane(QVector3D(32,-64,0),QVector3D(-32,-64,0),QVector3D(-32,-64,64)));
+    planes.prepend(new Plane(QVector3D(32,64,0),QVector3D(64,32,0),QVector3D(64,32,64)));
+    planes.prepend(new Plane(QVector3D(64,-32,0),QVector3D(32,-64,0),QVector3D(32,-64,64)));
+    planes.prepend(new Plane(QVector3D(-32,-64,0),QVector3D(-64,-32,0),QVector3D(-64,-32,64)));
+    planes.prepend(new Plane(QVector3D(-64,32,0),QVector3D(-32,64,0),QVector3D(-32,64,64)));
+    return new Brush(planes);
+}
+
 //!
 //! \brief PolygonTests::cleanup
 //!
@@ -237,3 +256,142 @@ void PolygonTests::testOctagonalPrism() {
     QVERIFY(polys.contains(QPolygonF(Shape10)));
 
 }
+//!
+//! \brief PolygonTests::testWindingsInvalidated
+//! The cached 3D windings have to follow the brush when it is edited
+//!
+void PolygonTests::testWindingsInvalidated() {
+
+    QList<Plane*> planes;
+    Plane *plane;
+    planes.prepend(plane = new Plane(QVector3D(-128, 32, 128),QVector3D(128, 32, 128),QVector3D(128, 0, 128)));
+    planes.prepend(plane = new Plane(QVector3D(-128, 0, 0),QVector3D(128, 0, 0),QVector3D(128, 32, 0)));
+    planes.prepend(plane = new Plane(QVector3D(-128, 32, 128),QVector3D(-128, 0, 128),QVector3D(-128, 0, 0)));
+    planes.prepend(plane = new Plane(QVector3D(128, 32, 0),QVector3D(128, 0, 0),QVector3D(128, 0, 128)));
+    planes.prepend(plane = new Plane(QVector3D(128, 32, 128),QVector3D(-128, 32, 128),QVector3D(-128, 32, 0)));
+    planes.prepend(plane = new Plane(QVector3D(128, 0, 0),QVector3D(-128, 0, 0),QVector3D(-128, 0, 128)));
+    Brush brush(planes);
+    Brush copy = brush;
+
+    QCOMPARE(brush.getWindings().count(), 6);
+    foreach(Winding winding, brush.getWindings())
+        QCOMPARE(winding.count(), 4);
+
+    copy.translate(X_AXIS, Y_AXIS, QVector2D(128, 0));
+
+    QList<QPolygonF> polys = brush.polygonise(X_AXIS, Y_AXIS);
+    QVector<QPointF> Shape; Shape <<  QPointF(0,0)  << QPointF(256,0) << QPointF(256,32) << QPointF(0,32);
+    QVERIFY(polys.contains(QPolygonF(Shape)));
+}
+//!
+//! \brief PolygonTests::testPolygonCache
+//!
+void PolygonTests::testPolygonCache() {
+
+    QList<Plane*> planes;
+    Plane *plane;
+    planes.prepend(plane = new Plane(QVector3D(-128, 32, 128),QVector3D(128, 32, 128),QVector3D(128, 0, 128)));
+    planes.prepend(plane = new Plane(QVector3D(-128, 0, 0),QVector3D(128, 0, 0),QVector3D(128, 32, 0)));
+    planes.prepend(plane = new Plane(QVector3D(-128, 32, 128),QVector3D(-128, 0, 128),QVector3D(-128, 0, 0)));
+    planes.prepend(plane = new Plane(QVector3D(128, 32, 0),QVector3D(128, 0, 0),QVector3D(128, 0, 128)));
+    planes.prepend(plane = new Plane(QVector3D(128, 32, 128),QVector3D(-128, 32, 128),QVector3D(-128, 32, 0)));
+    planes.prepend(plane = new Plane(QVector3D(128, 0, 0),QVector3D(-128, 0, 0),QVector3D(-128, 0, 128)));
+    Brush brush(planes);
+
+    PolygonCache cache;
+    cache.polygons(brush, X_AXIS, Y_AXIS);
+    cache.polygons(brush, X_AXIS, Y_AXIS);
+    cache.polygons(brush, X_AXIS, Z_AXIS);
+    QCOMPARE(cache.statistics().misses, quint64(2));
+    QCOMPARE(cache.statistics().hits, quint64(1));
+    QCOMPARE(cache.statistics().entries, 2);
+
+    // Editing the brush makes the entries stale
+    brush.translate(X_AXIS, Y_AXIS, QVector2D(64, 0));
+    QList<QPolygonF> polys = cache.polygons(brush, X_AXIS, Y_AXIS);
+    QCOMPARE(cache.statistics().misses, quint64(3));
+    QVector<QPointF> Shape; Shape <<  QPointF(-64,0)  << QPointF(192,0) << QPointF(192,32) << QPointF(-64,32);
+    QVERIFY(polys.contains(QPolygonF(Shape)));
+
+    // Least recently used entries go first once the cache is full
+    cache.invalidate(brush.getId());
+    QCOMPARE(cache.statistics().entries, 0);
+    cache.setMaxCost(30);
+    cache.polygons(brush, X_AXIS, Y_AXIS);
+    cache.polygons(brush, X_AXIS, Z_AXIS);
+    QVERIFY(cache.statistics().totalCost <= 30);
+    QCOMPARE(cache.statistics().entries, 1);
+}
+//!
+//! \brief PolygonTests::testScratchPoligonise
+//! The scratch path has to agree with Polygoniser::poligonise
+//!
+void PolygonTests::testScratchPoligonise() {
+    Brush *brush = octagonalPrism();
+    PolygoniserScratch scratch;
+    PolygonArena arena;
+
+    for(int view = 0; view < 3; view++) {
+        axis primary = (view == 0) ? Y_AXIS : X_AXIS;
+        axis secondary = (view == 2) ? Y_AXIS : Z_AXIS;
+        QList<QPolygonF> polys = Polygoniser::poligonise(brush, primary, secondary);
+
+        arena.clear();
+        Polygoniser::poligonise(brush, primary, secondary, &scratch, &arena);
+        QCOMPARE(arena.polygonCount(), polys.count());
+        for(int i = 0; i < arena.polygonCount(); i++)
+            QVERIFY(polys.contains(arena.polygon(i)));
+    }
+}
+//!
+//! \brief PolygonTests::testPoligoniseBatch
+//!
+void PolygonTests::testPoligoniseBatch() {
+    QList<Brush> brushes;
+    brushes << *octagonalPrism() << *octagonalPrism() << *octagonalPrism();
+    QTransform transform = QTransform::fromScale(2, 2);
+
+    PolygonArena arena;
+    Polygoniser::poligoniseBatch(brushes, 1, 2, X_AXIS, Y_AXIS, &arena, &transform);
+
+    QCOMPARE(arena.brushCount(), 2);
+    QCOMPARE(arena.polygonCount(), 20);
+    QCOMPARE(arena.brushOffsets.at(1), 10);
+    QCOMPARE(arena.brushCounts.at(1), 10);
+    QCOMPARE(arena.offsets.at(0), 0);
+    QCOMPARE(arena.offsets.at(1), arena.counts.at(0));
+
+    QList<QPolygonF> polys;
+    for(int i = 0; i < arena.brushCounts.at(0); i++)
+        polys.append(arena.polygon(i));
+    QVector<QPointF> Shape; Shape << QPointF(64,-128) << QPointF(128,-64);
+    QVERIFY(polys.contains(QPolygonF(Shape)));
+}
+//!
+//! \brief PolygonTests::testScratchNoAllocation
+//! Once warmed up, polygonising must not allocate: none of the buffers may
+//! grow or move when the same brush is polygonised again.
+//!
+void PolygonTests::testScratchNoAllocation() {
+    Brush *brush = octagonalPrism();
+    PolygoniserScratch scratch;
+    PolygonArena arena;
+
+    Polygoniser::poligonise(brush, X_AXIS, Y_AXIS, &scratch, &arena);
+    const QPointF *points = arena.points.constData();
+    const QPointF *scratchPoints = scratch.points.constData();
+    int capacity = arena.points.capacity() + arena.offsets.capacity() + arena.counts.capacity()
+            + scratch.points.capacity() + scratch.vertexes.capacity() + scratch.normals.capacity();
+
+    for(int i = 0; i < 100; i++) {
+        arena.clear();
+        Polygoniser::poligonise(brush, X_AXIS, Y_AXIS, &scratch, &arena);
+    }
+
+    QCOMPARE(arena.polygonCount(), 10);
+    QCOMPARE(arena.points.capacity() + arena.offsets.capacity() + arena.counts.capacity()
+             + scratch.points.capacity() + scratch.vertexes.capacity() + scratch.normals.capacity(),
+             capacity);
+    QVERIFY(arena.points.constData() == points);
+    QVERIFY(scratch.points.constData() == scratchPoints);
+}
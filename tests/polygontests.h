@@ -4,6 +4,7 @@
 #include <QObject>
 #include <QTest>
 #include "polygoniser.h"
+#include "polygoncache.h"
 
 class PolygonTests : public QObject
 {
@@ -23,6 +24,11 @@ private slots:
     //Brushes
     void testCuboid();
     void testOctagonalPrism();
+    void testWindingsInvalidated();
+    void testPolygonCache();
+    void testScratchPoligonise();
+    void testPoligoniseBatch();
+    void testScratchNoAllocation();
 
 };
 
@@ -0,0 +1,149 @@
+#include "renderertests.h"
+#include "testbrushes.h"
+
+#define BACKGROUND qRgb(0, 0, 0)
+
+//!
+//! \brief cuboid
+//! \param min - The lowest corner
+//! \param max - The highest corner
+//! \return a box brush
+//!
+static Brush cuboid(const QVector3D &min, const QVector3D &max) {
+    return Brush(cuboidPlanes(min, max));
+}
+
+//!
+//! \brief RendererTests::testRenderBox
+//!
+void RendererTests::testRenderBox() {
+    SoftwareRenderer renderer;
+    renderer.setMesh(SoftwareRenderer::buildMesh(
+                         QList<Brush>() << cuboid(QVector3D(-128, 0, 0), QVector3D(128, 32, 128))));
+    // 6 quads, 2 triangles each
+    QCOMPARE(renderer.mesh().triangleCount(), 12);
+
+    QImage frame(64, 64, QImage::Format_RGB32);
+    renderer.render(&frame, SoftwareRenderer::cameraMatrix(QVector3D(0, -512, 64),
+                                                           QVector3D(0, 0, 64), 1), BACKGROUND);
+
+    QVERIFY(frame.pixel(32, 32) != BACKGROUND);
+    QVERIFY(qAbs(renderer.depthAt(32, 32) - 1.0f / 512) < 1e-6f);
+    QCOMPARE(frame.pixel(0, 0), BACKGROUND);
+    QCOMPARE(renderer.depthAt(0, 0), 0.0f);
+}
+
+//!
+//! \brief RendererTests::testDepthOrder the nearest face wins whatever the mesh order
+//!
+void RendererTests::testDepthOrder() {
+    Brush near = cuboid(QVector3D(-128, 0, 0), QVector3D(128, 32, 128));
+    Brush far = cuboid(QVector3D(-256, 256, -64), QVector3D(256, 288, 192));
+    QMatrix4x4 camera = SoftwareRenderer::cameraMatrix(QVector3D(0, -512, 64), QVector3D(0, 0, 64), 1);
+
+    SoftwareRenderer renderer;
+    QImage first(64, 64, QImage::Format_RGB32);
+    renderer.setMesh(SoftwareRenderer::buildMesh(QList<Brush>() << near << far));
+    renderer.render(&first, camera, BACKGROUND);
+    QVERIFY(qAbs(renderer.depthAt(32, 32) - 1.0f / 512) < 1e-6f);
+
+    QImage second(64, 64, QImage::Format_RGB32);
+    renderer.setMesh(SoftwareRenderer::buildMesh(QList<Brush>() << far << near));
+    renderer.render(&second, camera, BACKGROUND);
+    QVERIFY(qAbs(renderer.depthAt(32, 32) - 1.0f / 512) < 1e-6f);
+
+    QCOMPARE(first, second);
+}
+
+//!
+//! \brief RendererTests::testBehindCamera
+//!
+void RendererTests::testBehindCamera() {
+    SoftwareRenderer renderer;
+    renderer.setMesh(SoftwareRenderer::buildMesh(
+                         QList<Brush>() << cuboid(QVector3D(-128, 0, 0), QVector3D(128, 32, 128))));
+
+    QImage frame(64, 64, QImage::Format_RGB32);
+    renderer.render(&frame, SoftwareRenderer::cameraMatrix(QVector3D(0, -512, 64),
+                                                           QVector3D(0, -1024, 64), 1), BACKGROUND);
+
+    for(int y = 0; y < frame.height(); y++)
+        for(int x = 0; x < frame.width(); x++)
+            QCOMPARE(frame.pixel(x, y), BACKGROUND);
+}
+
+//!
+//! \brief RendererTests::testGuardBandClip a face reaching far off screen still fills it
+//!
+void RendererTests::testGuardBandClip() {
+    SoftwareRenderer renderer;
+    renderer.setMesh(SoftwareRenderer::buildMesh(
+                         QList<Brush>() << cuboid(QVector3D(-8192, 0, -8192), QVector3D(8192, 32, 8192))));
+
+    QImage frame(128, 64, QImage::Format_RGB32);
+    renderer.render(&frame, SoftwareRenderer::cameraMatrix(QVector3D(0, -16, 64),
+                                                           QVector3D(0, 0, 64), 2), BACKGROUND);
+
+    for(int y = 0; y < frame.height(); y++) {
+        for(int x = 0; x < frame.width(); x++) {
+            QVERIFY(frame.pixel(x, y) != BACKGROUND);
+            QVERIFY(qAbs(renderer.depthAt(x, y) - 1.0f / 16) < 1e-5f);
+        }
+    }
+}
+
+//!
+//! \brief RendererTests::testIncrementalMesh edits draw like a mesh built from scratch
+//!
+void RendererTests::testIncrementalMesh() {
+    Brush left = cuboid(QVector3D(-200, 0, 0), QVector3D(-120, 32, 128));
+    Brush middle = cuboid(QVector3D(-40, 0, 0), QVector3D(40, 32, 128));
+    Brush right = cuboid(QVector3D(120, 0, 0), QVector3D(200, 32, 128));
+    Brush raised = cuboid(QVector3D(-40, 0, 64), QVector3D(40, 32, 192));
+    QMatrix4x4 camera = SoftwareRenderer::cameraMatrix(QVector3D(0, -512, 64), QVector3D(0, 0, 64), 1);
+
+    SoftwareRenderer renderer;
+    renderer.addBrushes(QVector<int>() << 10 << 11, QList<Brush>() << left << middle);
+    renderer.addBrushes(QVector<int>() << 12, QList<Brush>() << right);
+    QCOMPARE(renderer.brushCount(), 3);
+    QCOMPARE(renderer.mesh().triangleCount(), 36);
+
+    // Same number of triangles, overwritten where they are
+    renderer.replaceBrushes(QVector<int>() << 1, QList<Brush>() << raised);
+    QCOMPARE(renderer.mesh().triangleCount(), 36);
+    QCOMPARE(renderer.mesh().brushFirst.at(1), 12);
+
+    // A brush without faces leaves the old triangles dead, the box comes back at the end
+    renderer.replaceBrushes(QVector<int>() << 1, QList<Brush>() << Brush());
+    QCOMPARE(renderer.mesh().brushCounts.at(1), 0);
+    QCOMPARE(renderer.liveTriangleCount(), 24);
+    renderer.replaceBrushes(QVector<int>() << 1, QList<Brush>() << raised);
+    QCOMPARE(renderer.mesh().triangleCount(), 48);
+    QCOMPARE(renderer.mesh().brushFirst.at(1), 36);
+
+    renderer.removeBrushes(QVector<int>() << 10 << 99);
+    QCOMPARE(renderer.brushCount(), 2);
+    QCOMPARE(renderer.liveTriangleCount(), 24);
+
+    SoftwareRenderer rebuilt;
+    rebuilt.setMesh(SoftwareRenderer::buildMesh(QList<Brush>() << raised << right));
+    QImage incremental(64, 64, QImage::Format_RGB32);
+    QImage expected(64, 64, QImage::Format_RGB32);
+    renderer.render(&incremental, camera, BACKGROUND);
+    rebuilt.render(&expected, camera, BACKGROUND);
+    QCOMPARE(incremental, expected);
+
+    // Over half the triangles dead, the mesh closes up
+    renderer.removeBrushes(QVector<int>() << 12);
+    QCOMPARE(renderer.brushCount(), 1);
+    QCOMPARE(renderer.mesh().triangleCount(), 12);
+    QCOMPARE(renderer.mesh().brushFirst.at(0), 0);
+    rebuilt.setMesh(SoftwareRenderer::buildMesh(QList<Brush>() << raised));
+    renderer.render(&incremental, camera, BACKGROUND);
+    rebuilt.render(&expected, camera, BACKGROUND);
+    QCOMPARE(incremental, expected);
+
+    renderer.removeBrushes(QVector<int>() << 11);
+    QCOMPARE(renderer.brushCount(), 0);
+    QCOMPARE(renderer.mesh().triangleCount(), 0);
+}
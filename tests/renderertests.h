@@ -0,0 +1,21 @@
+#ifndef RENDERERTESTS_H
+#define RENDERERTESTS_H
+
+#include <QObject>
+#include <QTest>
+
+#include "softwarerenderer.h"
+
+class RendererTests : public QObject
+{
+    Q_OBJECT
+private slots:
+    void testRenderBox();
+    void testDepthOrder();
+    void testBehindCamera();
+    void testGuardBandClip();
+    void testIncrementalMesh();
+
+};
+
+#endif // RENDERERTESTS_H
@@ -0,0 +1,42 @@
+#include "testbrushes.h"
+
+//!
+//! \brief cuboidPlanes
+//! \param min - The lowest corner
+//! \param max - The highest corner
+//! \return new planes of a box, laid out like the sides of a vmf solid
+//!
+QList<Plane*> cuboidPlanes(const QVector3D &min, const QVector3D &max) {
+    float x0 = min.x(), y0 = min.y(), z0 = min.z();
+    float x1 = max.x(), y1 = max.y(), z1 = max.z();
+    QList<Plane*> planes;
+    planes.prepend(new Plane(QVector3D(x0, y1, z1),QVector3D(x1, y1, z1),QVector3D(x1, y0, z1)));
+    planes.prepend(new Plane(QVector3D(x0, y0, z0),QVector3D(x1, y0, z0),QVector3D(x1, y1, z0)));
+    planes.prepend(new Plane(QVector3D(x0, y1, z1),QVector3D(x0, y0, z1),QVector3D(x0, y0, z0)));
+    planes.prepend(new Plane(QVector3D(x1, y1, z0),QVector3D(x1, y0, z0),QVector3D(x1, y0, z1)));
+    planes.prepend(new Plane(QVector3D(x1, y1, z1),QVector3D(x0, y1, z1),QVector3D(x0, y1, z0)));
+    planes.prepend(new Plane(QVector3D(x1, y0, z0),QVector3D(x0, y0, z0),QVector3D(x0, y0, z1)));
+    return planes;
+}
+//!
+//! \brief boxPlanes the 256x32x128 box of testBox.vmf
+//! Its centre is at (0, 16) in the XY view before the offset.
+//! \param offset
+//! \return new planes for one brush
+//!
+QList<Plane*> boxPlanes(const QVector3D &offset) {
+    return cuboidPlanes(QVector3D(-128, 0, 0) + offset, QVector3D(128, 32, 128) + offset);
+}
+//!
+//! \brief boxBrushes
+//! \param count
+//! \param step - Offset from one box to the next
+//! \return count boxes, each with planes of its own
+//!
+QList<Brush> boxBrushes(int count, const QVector3D &step) {
+    QList<Brush> brushes;
+    brushes.reserve(count);
+    for(int i = 0; i < count; i++)
+        brushes.append(Brush(boxPlanes(step * i)));
+    return brushes;
+}
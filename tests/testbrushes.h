@@ -0,0 +1,12 @@
+#ifndef TESTBRUSHES_H
+#define TESTBRUSHES_H
+
+#include <QList>
+#include <QVector3D>
+#include "brush.h"
+
+QList<Plane*> cuboidPlanes(const QVector3D &min, const QVector3D &max);
+QList<Plane*> boxPlanes(const QVector3D &offset = QVector3D());
+QList<Brush> boxBrushes(int count, const QVector3D &step = QVector3D());
+
+#endif // TESTBRUSHES_H
@@ -0,0 +1,40 @@
+#-------------------------------------------------
+#
+# Every test suite of the editor, run by make check
+#
+#-------------------------------------------------
+
+include(../worldeditor.pri)
+
+QT       += testlib
+
+TARGET = WorldEditorTests
+TEMPLATE = app
+
+CONFIG += testcase
+
+SOURCES += main.cpp \
+    alltests.cpp \
+    testbrushes.cpp \
+    brushtests.cpp \
+    maptests.cpp \
+    polygontests.cpp \
+    viewporttests.cpp \
+    renderertests.cpp \
+    worldtreetests.cpp \
+    jobsystemtests.cpp \
+    tracetests.cpp
+
+HEADERS += alltests.h \
+    testbrushes.h \
+    brushtests.h \
+    maptests.h \
+    polygontests.h \
+    viewporttests.h \
+    renderertests.h \
+    worldtreetests.h \
+    jobsystemtests.h \
+    tracetests.h
+
+RESOURCES += \
+    vmfs.qrc
@@ -0,0 +1,151 @@
+#include "tracetests.h"
+#include <QHash>
+#include <QSet>
+#include <QThread>
+#include "jobsystem.h"
+#include "map.h"
+
+//!
+//! \brief TraceTests::spans
+//! \param trace - From Trace::toChromeJson
+//! \param name - Only the spans with this name, all of them when empty
+//! \return the complete events of the trace
+//!
+QJsonArray TraceTests::spans(const QJsonObject &trace, const QString &name) {
+    QJsonArray result;
+    foreach(const QJsonValue &value, trace["traceEvents"].toArray()) {
+        QJsonObject event = value.toObject();
+        if(event["ph"].toString() == "X" && (name.isEmpty() || event["name"].toString() == name))
+            result.append(event);
+    }
+    return result;
+}
+//!
+//! \brief TraceTests::init every test starts with empty buffers, not recording
+//!
+void TraceTests::init() {
+    Trace::setEnabled(false);
+    Trace::clear();
+}
+//!
+//! \brief TraceTests::cleanup leaves nothing recording for the other suites
+//!
+void TraceTests::cleanup() {
+    Trace::setEnabled(false);
+    Trace::clear();
+}
+//!
+//! \brief TraceTests::testDisabled scopes record nothing while tracing is off
+//!
+void TraceTests::testDisabled() {
+    QVERIFY(!Trace::isEnabled());
+    {
+        TRACE_SCOPE(PARSE, "disabled");
+    }
+    QCOMPARE(spans(Trace::toChromeJson()).size(), 0);
+
+    // A scope made while off stays off when tracing starts inside it
+    {
+        TRACE_SCOPE(PARSE, "started inside");
+        Trace::setEnabled(true);
+    }
+    QCOMPARE(spans(Trace::toChromeJson()).size(), 0);
+}
+//!
+//! \brief TraceTests::testScope a scope records its name, category and duration
+//!
+void TraceTests::testScope() {
+    Trace::setEnabled(true);
+    const qint64 before = Trace::now();
+    {
+        TRACE_SCOPE(LOAD, "outer");
+        TRACE_SCOPE(PARSE, "inner");
+        QThread::msleep(2);
+    }
+    QJsonObject trace = Trace::toChromeJson();
+    QCOMPARE(trace["displayTimeUnit"].toString(), QString("ms"));
+
+    QJsonArray outer = spans(trace, "outer");
+    QJsonArray inner = spans(trace, "inner");
+    QCOMPARE(outer.size(), 1);
+    QCOMPARE(inner.size(), 1);
+    QCOMPARE(outer.at(0).toObject()["cat"].toString(), QString("load"));
+    QCOMPARE(inner.at(0).toObject()["cat"].toString(), QString("parse"));
+    QVERIFY(inner.at(0).toObject()["dur"].toDouble() >= 2000);
+    QVERIFY(outer.at(0).toObject()["ts"].toDouble() >= before / 1000.0);
+
+    // The inner scope ends first, so it lies within the outer one
+    const double outerEnd = outer.at(0).toObject()["ts"].toDouble() + outer.at(0).toObject()["dur"].toDouble();
+    const double innerEnd = inner.at(0).toObject()["ts"].toDouble() + inner.at(0).toObject()["dur"].toDouble();
+    QVERIFY(inner.at(0).toObject()["ts"].toDouble() >= outer.at(0).toObject()["ts"].toDouble());
+    QVERIFY(innerEnd <= outerEnd);
+}
+//!
+//! \brief TraceTests::testRingBuffer a full buffer keeps the newest events and counts the rest
+//!
+void TraceTests::testRingBuffer() {
+    Trace::setEnabled(true);
+    for(int i = 0; i < TRACE_BUFFER_EVENTS + 100; i++)
+        Trace::record(Trace::JOBS, "event", i * 1000, 1000);
+
+    QJsonObject trace = Trace::toChromeJson();
+    QJsonArray events = spans(trace, "event");
+    QCOMPARE(events.size(), TRACE_BUFFER_EVENTS);
+    QCOMPARE(events.first().toObject()["ts"].toDouble(), 100.0);
+    QCOMPARE(events.last().toObject()["ts"].toDouble(), double(TRACE_BUFFER_EVENTS + 99));
+    QCOMPARE(trace["otherData"].toObject()["droppedEvents"].toDouble(), 100.0);
+
+    Trace::clear();
+    QCOMPARE(spans(Trace::toChromeJson()).size(), 0);
+}
+//!
+//! \brief TraceTests::testThreadNames events of the job workers are under their own named threads
+//!
+void TraceTests::testThreadNames() {
+    Trace::setEnabled(true);
+    {
+        JobSystem jobs(4);
+        jobs.parallelFor(0, 64, [](int) {
+            TRACE_SCOPE(JOBS, "work");
+            QThread::msleep(1);
+        }, 1);
+    }
+    QJsonObject trace = Trace::toChromeJson();
+    QCOMPARE(spans(trace, "work").size(), 64);
+
+    QHash<int, QString> names;
+    foreach(const QJsonValue &value, trace["traceEvents"].toArray()) {
+        QJsonObject event = value.toObject();
+        if(event["ph"].toString() == "M" && event["name"].toString() == "thread_name")
+            names.insert(event["tid"].toInt(), event["args"].toObject()["name"].toString());
+    }
+    QSet<int> threads;
+    bool worker = false;
+    foreach(const QJsonValue &value, spans(trace, "work")) {
+        const int tid = value.toObject()["tid"].toInt();
+        QVERIFY(names.contains(tid));
+        threads.insert(tid);
+        worker = worker || names.value(tid).startsWith("JobWorker");
+    }
+    QVERIFY(threads.size() > 1);
+    QVERIFY(worker);
+
+    // Clearing drops what the workers recorded too
+    Trace::clear();
+    QCOMPARE(spans(Trace::toChromeJson()).size(), 0);
+}
+//!
+//! \brief TraceTests::testReadVMF loading a file traces the load and every solid
+//!
+void TraceTests::testReadVMF() {
+    Trace::setEnabled(true);
+    Map map;
+    QVERIFY(!map.readVMF(":/vmfs/testGroups.vmf"));
+
+    QJsonObject trace = Trace::toChromeJson();
+    QCOMPARE(spans(trace, "readVMF").size(), 1);
+    QCOMPARE(spans(trace, "world").size(), 1);
+    QCOMPARE(spans(trace, "solid").size(), map.m_solids.rowCount());
+    QCOMPARE(spans(trace, "poligoniseAll").size(), 1);
+    QCOMPARE(spans(trace, "readVMF").at(0).toObject()["cat"].toString(), QString("load"));
+}
@@ -0,0 +1,27 @@
+#ifndef TRACETESTS_H
+#define TRACETESTS_H
+
+#include <QObject>
+#include <QTest>
+#include <QJsonArray>
+
+#include "trace.h"
+
+class TraceTests : public QObject
+{
+    Q_OBJECT
+
+    static QJsonArray spans(const QJsonObject &trace, const QString &name = QString());
+
+private slots:
+    void init();
+    void cleanup();
+    void testDisabled();
+    void testScope();
+    void testRingBuffer();
+    void testThreadNames();
+    void testReadVMF();
+
+};
+
+#endif // TRACETESTS_H
@@ -1,4 +1,6 @@
 #include "viewporttests.h"
+#include "testbrushes.h"
+#include <QSignalSpy>
 
 void ViewPortTests::testAddBlock() {
 
@@ -7,7 +9,7 @@ void ViewPortTests::testAddBlock() {
     connect(&map.m_solids, SIGNAL(rowsInserted(QModelIndex,int,int)),
             &scene, SLOT(addBrush(QModelIndex,int,int)));
 
-    int before = scene.items().count();
+    int before = scene.brushLayer()->faceCount();
     Plane *plane;
     QList<Plane*> planes;
     planes.prepend(plane = new Plane(QVector3D(-128, 32, 128),QVector3D(128, 32, 128),QVector3D(128, 0, 128)));
@@ -18,8 +20,400 @@ void ViewPortTests::testAddBlock() {
     planes.prepend(plane = new Plane(QVector3D(128, 0, 0),QVector3D(-128, 0, 0),QVector3D(-128, 0, 128)));
     Brush brush(planes);
     map.m_solids.addSolid(brush);
-    int after = scene.items().count();
+    int after = scene.brushLayer()->faceCount();
     QVERIFY(after - before == 6);
+    QCOMPARE(scene.brushLayer()->brushCount(), 1);
 
 }
 
+void ViewPortTests::testPickBlock() {
+
+    Map map;
+    ViewPortScene scene(&map, X_AXIS, Y_AXIS);
+    connect(&map.m_solids, SIGNAL(rowsInserted(QModelIndex,int,int)),
+            &scene, SLOT(addBrush(QModelIndex,int,int)));
+
+    Brush brush(boxPlanes());
+    map.m_solids.addSolid(brush);
+
+    QTransform transform = ViewPortScene::brushTransform();
+    QCOMPARE(scene.brushLayer()->brushAt(transform.map(QPointF(0, 16))), 0);
+    QCOMPARE(scene.brushLayer()->brushAt(transform.map(QPointF(0, 64))), -1);
+}
+
+void ViewPortTests::testFrameStatistics() {
+
+    Map map;
+    ViewPortScene scene(&map, X_AXIS, Y_AXIS);
+    connect(&map.m_solids, SIGNAL(rowsInserted(QModelIndex,int,int)),
+            &scene, SLOT(addBrush(QModelIndex,int,int)));
+
+    map.m_solids.addSolid(Brush(boxPlanes()));
+
+    // 32768 scene units around the origin of the map
+    QImage image(256, 256, QImage::Format_ARGB32_Premultiplied);
+    QPainter painter(&image);
+    scene.beginFrame();
+    scene.render(&painter, QRectF(0, 0, 256, 256),
+                 QRectF(32768*32 - 16384, 32768*32 - 16384, 32768, 32768));
+    scene.endFrame(1000);
+    painter.end();
+
+    const FrameStatistics &stats = scene.statistics();
+    QCOMPARE(stats.frames(), 1);
+    QCOMPARE(stats.last(FrameStatistics::BRUSHES_PAINTED), qint64(1));
+    QCOMPARE(stats.last(FrameStatistics::BRUSHES_CULLED), qint64(0));
+    QCOMPARE(stats.last(FrameStatistics::PAINT_TIME), qint64(1000));
+    QVERIFY(stats.last(FrameStatistics::GRID_LINES) > 0);
+    QVERIFY(stats.last(FrameStatistics::BACKGROUND_TIME) > 0);
+
+    QJsonObject json = stats.toJson();
+    QCOMPARE(json["frames"].toInt(), 1);
+    QVERIFY(json["metrics"].toObject().contains("paintNs"));
+    QCOMPARE(json["metrics"].toObject()["brushesPainted"].toObject()["p50"].toDouble(), 1.0);
+}
+
+void ViewPortTests::testStatisticsPercentiles() {
+
+    FrameStatistics stats(4);
+    for(int i = 1; i <= 5; i++) {
+        stats.beginFrame();
+        stats.add(FrameStatistics::PAINT_TIME, i * 10);
+        stats.endFrame();
+    }
+    // The first frame fell out of the window
+    QCOMPARE(stats.frames(), 4);
+    QCOMPARE(stats.last(FrameStatistics::PAINT_TIME), qint64(50));
+    QCOMPARE(stats.percentile(FrameStatistics::PAINT_TIME, 50), qint64(30));
+    QCOMPARE(stats.percentile(FrameStatistics::PAINT_TIME, 100), qint64(50));
+    QCOMPARE(stats.percentile(FrameStatistics::PAINT_TIME, 0), qint64(20));
+}
+
+
+void ViewPortTests::testCoalescedUpdates() {
+
+    Map map;
+    ViewPortScene scene(&map, X_AXIS, Y_AXIS);
+    SceneUpdateQueue queue(&map.m_solids);
+    connect(&queue, SIGNAL(updated(SceneUpdate)), &scene, SLOT(applyUpdate(SceneUpdate)));
+    int batches = 0;
+    int firstInserted = -1;
+    connect(&queue, &SceneUpdateQueue::updated, [&](const SceneUpdate &update) {
+        batches++;
+        firstInserted = update.firstInserted;
+    });
+
+    map.m_solids.addSolids(boxBrushes(10000));
+    for(int i = 0; i < 10; i++)
+        map.m_solids.addSolid(Brush(boxPlanes()));
+
+    // Nothing reaches the scene until the event loop runs
+    QVERIFY(queue.isPending());
+    QCOMPARE(batches, 0);
+    QCOMPARE(scene.brushLayer()->brushCount(), 0);
+
+    QTRY_COMPARE(batches, 1);
+    QCOMPARE(firstInserted, 0);
+    QCOMPARE(scene.brushLayer()->brushCount(), 10010);
+    QVERIFY(!queue.isPending());
+}
+
+//!
+//! \brief ViewPortTests::testDragSelection the model only changes when the drag ends
+//!
+void ViewPortTests::testDragSelection() {
+
+    Map map;
+    ViewPortScene scene(&map, X_AXIS, Y_AXIS);
+    SceneUpdateQueue queue(&map.m_solids);
+    connect(&queue, SIGNAL(updated(SceneUpdate)), &scene, SLOT(applyUpdate(SceneUpdate)));
+    QSignalSpy changes(&map.m_solids, SIGNAL(dataChanged(QModelIndex,QModelIndex,QVector<int>)));
+
+    map.m_solids.addSolid(Brush(boxPlanes()));
+    queue.flush();
+
+    QTransform transform = ViewPortScene::brushTransform();
+    scene.setMouseMode(SELECT);
+
+    QGraphicsSceneMouseEvent press(QEvent::GraphicsSceneMousePress);
+    press.setScenePos(transform.map(QPointF(0, 16)));
+    press.setButton(Qt::LeftButton);
+    scene.mousePressEvent(&press);
+    QCOMPARE(scene.brushSelection(), QList<int>() << 0);
+
+    for(int x = 1; x <= 64; x++) {
+        QGraphicsSceneMouseEvent move(QEvent::GraphicsSceneMouseMove);
+        move.setScenePos(transform.map(QPointF(x, 16)));
+        move.setButtons(Qt::LeftButton);
+        scene.mouseMoveEvent(&move);
+    }
+    QCOMPARE(scene.ghostOffset(), QVector3D(64, 0, 0));
+    QCOMPARE(changes.count(), 0);
+    Brush before = map.m_solids.brushes().at(0);
+    QCOMPARE(before.getCenter(X_AXIS, Y_AXIS), QVector2D(0, 16));
+
+    QGraphicsSceneMouseEvent release(QEvent::GraphicsSceneMouseRelease);
+    release.setScenePos(transform.map(QPointF(64, 16)));
+    release.setButton(Qt::LeftButton);
+    scene.mouseReleaseEvent(&release);
+    QCOMPARE(changes.count(), 1);
+    QCOMPARE(scene.ghostOffset(), QVector3D(0, 0, 0));
+    Brush after = map.m_solids.brushes().at(0);
+    QCOMPARE(after.getCenter(X_AXIS, Y_AXIS), QVector2D(64, 16));
+}
+
+//!
+//! \brief ViewPortTests::testReplaceChangedBrush an edit replaces the brush, not the layer
+//!
+void ViewPortTests::testReplaceChangedBrush() {
+
+    Map map;
+    ViewPortScene scene(&map, X_AXIS, Y_AXIS);
+    SceneUpdateQueue queue(&map.m_solids);
+    connect(&queue, SIGNAL(updated(SceneUpdate)), &scene, SLOT(applyUpdate(SceneUpdate)));
+
+    QList<Brush> brushes;
+    brushes.append(Brush(boxPlanes()));
+    // The others are well away from the one being moved
+    for(int i = 1; i < 1000; i++)
+        brushes.append(Brush(boxPlanes(QVector3D(0, 4096, 0))));
+    QVector<BrushHandle> handles = map.m_solids.addSolids(brushes);
+    queue.flush();
+    QCOMPARE(scene.brushLayer()->brushCount(), 1000);
+    const QPointF *points = scene.brushLayer()->geometry().faces.points.constData();
+
+    map.m_solids.translateSolids(QList<BrushHandle>() << handles.at(0), X_AXIS, Y_AXIS,
+                                 QVector2D(1024, 0));
+    queue.flush();
+
+    QTransform transform = ViewPortScene::brushTransform();
+    QCOMPARE(scene.brushLayer()->brushCount(), 1000);
+    QCOMPARE(scene.brushLayer()->faceCount(), 6000);
+    QCOMPARE(scene.brushLayer()->brushAt(transform.map(QPointF(1024, 16))), handles.at(0));
+    QCOMPARE(scene.brushLayer()->brushAt(transform.map(QPointF(0, 16))), -1);
+    // The faces kept their shape, so they were overwritten where they were
+    QVERIFY(scene.brushLayer()->geometry().faces.points.constData() == points);
+}
+
+//!
+//! \brief ViewPortTests::testRemoveWithoutReset removals take brushes out of the layer, not rebuild it
+//!
+void ViewPortTests::testRemoveWithoutReset() {
+
+    Map map;
+    ViewPortScene scene(&map, X_AXIS, Y_AXIS);
+    SceneUpdateQueue queue(&map.m_solids);
+    connect(&queue, SIGNAL(updated(SceneUpdate)), &scene, SLOT(applyUpdate(SceneUpdate)));
+    bool reset = false;
+    connect(&queue, &SceneUpdateQueue::updated, [&](const SceneUpdate &update) {
+        reset = reset || update.reset;
+    });
+
+    QVector<BrushHandle> handles = map.m_solids.addSolids(boxBrushes(10, QVector3D(0, 4096, 0)));
+    queue.flush();
+    const QPointF *points = scene.brushLayer()->geometry().faces.points.constData();
+
+    // An edit, scattered rows and the last row in the same batch
+    map.m_solids.translateSolids(QList<BrushHandle>() << handles.at(8), X_AXIS, Y_AXIS,
+                                 QVector2D(1024, 0));
+    map.m_solids.removeSolids(QList<BrushHandle>() << handles.at(5) << handles.at(2));
+    map.m_solids.removeSolids(QList<BrushHandle>() << handles.at(9));
+    queue.flush();
+
+    QVERIFY(!reset);
+    QCOMPARE(scene.brushLayer()->brushCount(), 7);
+    QCOMPARE(scene.brushLayer()->faceCount(), 42);
+    for(int row = 0; row < map.m_solids.rowCount(); row++)
+        QCOMPARE(scene.brushLayer()->geometry().brushIds.at(row), map.m_solids.handle(row));
+    QTransform transform = ViewPortScene::brushTransform();
+    QCOMPARE(scene.brushLayer()->brushAt(transform.map(QPointF(0, 16 + 4096 * 2))), -1);
+    QCOMPARE(scene.brushLayer()->brushAt(transform.map(QPointF(0, 16 + 4096 * 3))), handles.at(3));
+    QCOMPARE(scene.brushLayer()->brushAt(transform.map(QPointF(1024, 16 + 4096 * 8))), handles.at(8));
+    // The faces of the removed brushes were left dead where they were
+    QVERIFY(scene.brushLayer()->geometry().faces.points.constData() == points);
+
+    // Nothing is left to keep once every row goes
+    map.m_solids.removeRows(0, map.m_solids.rowCount());
+    queue.flush();
+    QVERIFY(reset);
+    QCOMPARE(scene.brushLayer()->brushCount(), 0);
+}
+
+//!
+//! \brief ViewPortTests::testSceneMemory the layer's faces and the items of a view are accounted for
+//!
+void ViewPortTests::testSceneMemory() {
+
+    Map map;
+    ViewPortScene scene(&map, X_AXIS, Y_AXIS);
+    SceneUpdateQueue queue(&map.m_solids);
+    connect(&queue, SIGNAL(updated(SceneUpdate)), &scene, SLOT(applyUpdate(SceneUpdate)));
+
+    MemoryReport empty;
+    scene.accountMemory(&empty);
+    QCOMPARE(empty.count(MemoryReport::SCENE_GEOMETRY), qint64(0));
+    QCOMPARE(empty.count(MemoryReport::SCENE_ITEMS), qint64(scene.items().count()));
+
+    QList<Brush> brushes = boxBrushes(100);
+    map.m_solids.addSolids(brushes);
+    queue.flush();
+
+    MemoryReport report;
+    scene.accountMemory(&report);
+    QCOMPARE(report.count(MemoryReport::SCENE_GEOMETRY), qint64(scene.brushLayer()->faceCount()));
+    QVERIFY(report.bytes(MemoryReport::SCENE_GEOMETRY)
+            >= qint64(scene.brushLayer()->geometry().faces.points.size() * sizeof(QPointF)));
+    // Brushes share the one layer item, they add no items of their own
+    QCOMPARE(report.count(MemoryReport::SCENE_ITEMS), empty.count(MemoryReport::SCENE_ITEMS));
+}
+//!
+//! \brief ViewPortTests::testGridTileCache panning keeps only a few screens of grid tiles
+//!
+void ViewPortTests::testGridTileCache() {
+
+    Map map;
+    ViewPortScene scene(&map, X_AXIS, Y_AXIS);
+    QImage image(512, 512, QImage::Format_ARGB32_Premultiplied);
+    // 50 screens side by side, at one scene unit per pixel
+    for(int i = 0; i < 50; i++) {
+        QPainter painter(&image);
+        scene.render(&painter, QRectF(image.rect()), QRectF(32768*32 + i * 512, 32768*32, 512, 512));
+    }
+
+    MemoryReport report;
+    scene.accountMemory(&report);
+    const qint64 tileBytes = 256 * 256 * 4;
+    // A screen touches at most 3x3 tiles, 4x4 are budgeted for each of a few screens
+    QVERIFY(report.count(MemoryReport::GRID_TILES) >= 9);
+    QVERIFY(report.count(MemoryReport::GRID_TILES) <= 3 * 16);
+    QVERIFY(report.bytes(MemoryReport::GRID_TILES) <= 3 * 16 * tileBytes);
+}
+//!
+//! \brief ViewPortTests::testLevelOfDetail zoomed out, brushes a few pixels wide are simplified
+//! One world unit is 64 scene units, so at a scale of 128 it is half a pixel.
+//!
+void ViewPortTests::testLevelOfDetail() {
+
+    Map map;
+    QList<Brush> brushes;
+    for(int i = 0; i < 10; i++) {
+        QVector3D offset(i * 512, 0, 0);
+        // 128 pixels, 3 pixels and half a pixel across
+        brushes.append(Brush(cuboidPlanes(offset, offset + QVector3D(256, 256, 256))));
+        brushes.append(Brush(cuboidPlanes(offset + QVector3D(0, 1024, 0), offset + QVector3D(6, 1030, 6))));
+        brushes.append(Brush(cuboidPlanes(offset + QVector3D(0, 2048, 0), offset + QVector3D(1, 2049, 1))));
+    }
+    map.m_solids.addSolids(brushes);
+    ViewPortScene scene(&map, X_AXIS, Y_AXIS);
+    const BrushLayerItem *layer = scene.brushLayer();
+    QCOMPARE(layer->brushCount(), 30);
+
+    QImage image(256, 256, QImage::Format_ARGB32_Premultiplied);
+    QPainter painter(&image);
+    painter.scale(1.0 / 128, 1.0 / 128);
+    BrushPaintBuffers buffers;
+
+    scene.setScale(8);
+    QCOMPARE(layer->levelOfDetail(), BrushLayerItem::FULL_DETAIL);
+    BrushPaintStats full = BrushLayerItem::draw(&painter, layer->geometry(), layer->pen(),
+                                                layer->levelOfDetail(), layer->boundingRect(), &buffers);
+    QCOMPARE(full.painted, 30);
+    QCOMPARE(full.rects, 0);
+    QCOMPARE(full.dots, 0);
+    const int fullLines = buffers.lines.size();
+    QVERIFY(fullLines > 0);
+
+    // Past LOD_MIN_SCALE
+    scene.setScale(128);
+    QCOMPARE(layer->levelOfDetail(), BrushLayerItem::ADAPTIVE_DETAIL);
+    BrushPaintStats adaptive = BrushLayerItem::draw(&painter, layer->geometry(), layer->pen(),
+                                                    layer->levelOfDetail(), layer->boundingRect(), &buffers);
+    QCOMPARE(adaptive.painted, 30);
+    QCOMPARE(adaptive.rects, 10);
+    QCOMPARE(adaptive.dots, 10);
+    // The large brushes keep their faces, every brush has the same ones
+    QCOMPARE(buffers.lines.size() * 3, fullLines);
+}
+//!
+//! \brief ViewPortTests::testTiledMatchesDirect both render modes draw the same picture
+//! At half a pixel per scene unit the major grid lines are 4 pixels wide, and
+//! the view is placed so they are centred a pixel before the 128 pixel tile
+//! edges. A tile that misses the lines on its neighbour shows a seam.
+//! Both count every brush once in the frame statistics.
+//!
+void ViewPortTests::testTiledMatchesDirect() {
+
+    Map map;
+    map.m_solids.addSolids(QList<Brush>()
+                           << Brush(cuboidPlanes(QVector3D(-10, -10, 0), QVector3D(2, 2, 8)))
+                           << Brush(cuboidPlanes(QVector3D(-6, -6, 0), QVector3D(0, 0, 8)))
+                           << Brush(cuboidPlanes(QVector3D(1000, 1000, 0), QVector3D(1010, 1010, 8))));
+    ViewPortScene scene(&map, X_AXIS, Y_AXIS);
+    scene.setScale(128);
+    const FrameStatistics &stats = scene.statistics();
+
+    // Major lines every 512 scene units land on device pixel 127 of each 256
+    const qreal origin = 32768*32 - 254;
+    const QRectF source(origin, origin, 1024, 1024);
+    QImage direct(512, 512, QImage::Format_ARGB32_Premultiplied);
+    QImage tiled(512, 512, QImage::Format_ARGB32_Premultiplied);
+    {
+        QPainter painter(&direct);
+        scene.setRenderMode(DIRECT_RENDER);
+        scene.beginFrame();
+        scene.render(&painter, QRectF(direct.rect()), source);
+        scene.endFrame(0);
+    }
+    QCOMPARE(stats.last(FrameStatistics::BRUSHES_PAINTED), qint64(2));
+    QCOMPARE(stats.last(FrameStatistics::BRUSHES_CULLED), qint64(1));
+    {
+        QPainter painter(&tiled);
+        scene.setRenderMode(TILED_RENDER);
+        scene.beginFrame();
+        scene.render(&painter, QRectF(tiled.rect()), source);
+        scene.endFrame(0);
+    }
+    // Each brush once, however many of the 16 tiles it crosses
+    QCOMPARE(stats.last(FrameStatistics::BRUSHES_PAINTED), qint64(2));
+    QCOMPARE(stats.last(FrameStatistics::BRUSHES_CULLED), qint64(1));
+
+    // A seam is a whole row or column of a tile, a few stray pixels are not
+    int different = 0;
+    for(int y = 0; y < direct.height(); y++) {
+        for(int x = 0; x < direct.width(); x++) {
+            if(direct.pixel(x, y) != tiled.pixel(x, y))
+                different++;
+        }
+    }
+    QVERIFY2(different < 64, qPrintable(QString("%1 pixels differ").arg(different)));
+}
+//!
+//! \brief ViewPortTests::testSceneAfterBrushes a scene made once the map has brushes shows them
+//!
+void ViewPortTests::testSceneAfterBrushes() {
+
+    Map map;
+    map.readVMF(":/vmfs/testOctagon.vmf");
+    QVERIFY(map.m_solids.rowCount() > 0);
+
+    ViewPortScene scene(&map, X_AXIS, Y_AXIS);
+    QCOMPARE(scene.brushLayer()->brushCount(), map.m_solids.rowCount());
+    QCOMPARE(scene.brushLayer()->geometry().brushIds.at(0), map.m_solids.handle(0));
+}
+//!
+//! \brief ViewPortTests::testUnprojectedAxes a scene on axes the model keeps no projections for
+//! polygonises the brushes itself
+//!
+void ViewPortTests::testUnprojectedAxes() {
+
+    Map map;
+    QVector<BrushHandle> handles = map.m_solids.addSolids(boxBrushes(10, QVector3D(0, 4096, 0)));
+    ViewPortScene scene(&map, Y_AXIS, X_AXIS);
+    QCOMPARE(Polygoniser::viewIndex(Y_AXIS, X_AXIS), -1);
+    QCOMPARE(scene.brushLayer()->brushCount(), 10);
+    QCOMPARE(scene.brushLayer()->faceCount(), 60);
+
+    QTransform transform = ViewPortScene::brushTransform();
+    QCOMPARE(scene.brushLayer()->brushAt(transform.map(QPointF(3 * 4096 + 16, 0))), handles.at(3));
+    QCOMPARE(scene.brushLayer()->brushAt(transform.map(QPointF(3 * 4096 + 16, 512))), -1);
+}
@@ -12,6 +12,19 @@ class ViewPortTests : public QObject
     Q_OBJECT
 private slots:
     void testAddBlock();
+    void testPickBlock();
+    void testFrameStatistics();
+    void testStatisticsPercentiles();
+    void testCoalescedUpdates();
+    void testDragSelection();
+    void testReplaceChangedBrush();
+    void testRemoveWithoutReset();
+    void testSceneMemory();
+    void testGridTileCache();
+    void testLevelOfDetail();
+    void testTiledMatchesDirect();
+    void testSceneAfterBrushes();
+    void testUnprojectedAxes();
 
 };
 
@@ -0,0 +1,154 @@
+#include "worldtreetests.h"
+#include "testbrushes.h"
+#include <QSignalSpy>
+
+//!
+//! \brief WorldTreeTests::testTreeStructure groups, entities and visgroups of a file
+//!
+void WorldTreeTests::testTreeStructure() {
+    Map map;
+    map.readVMF(":/vmfs/testGroups.vmf");
+    WorldTreeModel tree(&map);
+
+    QCOMPARE(tree.rowCount(), 2);
+    QModelIndex world = tree.index(0, 0);
+    QCOMPARE(world.data().toString(), QString("worldspawn"));
+    QVERIFY(tree.hasChildren(world));
+    QCOMPARE(tree.rowCount(world), 0);
+    QVERIFY(tree.canFetchMore(world));
+
+    // The group, the func_detail and the solid in no group
+    tree.fetchMore(world);
+    QCOMPARE(tree.rowCount(world), 3);
+    QVERIFY(!tree.canFetchMore(world));
+    QCOMPARE(tree.index(0, 0, world).data().toString(), QString("group 10"));
+    QCOMPARE(tree.index(0, 0, world).data(WorldTreeModel::KindRole).toInt(),
+             int(WorldTreeModel::GROUP_NODE));
+    QCOMPARE(tree.index(1, 0, world).data().toString(), QString("func_detail"));
+    QCOMPARE(tree.index(2, 0, world).data().toString(), QString("solid 3"));
+    QCOMPARE(tree.index(2, 0, world).data(WorldTreeModel::HandleRole).toInt(),
+             map.m_solids.handle(1));
+
+    QModelIndex group = tree.index(0, 0, world);
+    tree.fetchMore(group);
+    QCOMPARE(tree.rowCount(group), 2);
+    QCOMPARE(tree.index(0, 0, group).data().toString(), QString("info_player_start (spawn)"));
+    QCOMPARE(tree.index(1, 0, group).data().toString(), QString("solid 2"));
+    QCOMPARE(tree.parent(tree.index(1, 0, group)), group);
+    QVERIFY(!tree.hasChildren(tree.index(0, 0, group)));
+
+    QModelIndex detail = tree.index(1, 0, world);
+    tree.fetchMore(detail);
+    QCOMPARE(tree.rowCount(detail), 1);
+    QCOMPARE(tree.index(0, 0, detail).data().toString(), QString("solid 21"));
+
+    QModelIndex visgroups = tree.index(1, 0);
+    tree.fetchMore(visgroups);
+    QCOMPARE(tree.rowCount(visgroups), 1);
+    QModelIndex buildings = tree.index(0, 0, visgroups);
+    QCOMPARE(buildings.data().toString(), QString("Buildings"));
+    QCOMPARE(buildings.data(Qt::DecorationRole).value<QColor>(), QColor(255, 0, 0));
+    tree.fetchMore(buildings);
+    QCOMPARE(tree.rowCount(buildings), 2);
+    QModelIndex roofs = tree.index(0, 0, buildings);
+    QCOMPARE(roofs.data().toString(), QString("Roofs"));
+    QCOMPARE(tree.index(1, 0, buildings).data().toString(), QString("solid 2"));
+    tree.fetchMore(roofs);
+    QCOMPARE(tree.rowCount(roofs), 2);
+    QCOMPARE(tree.index(0, 0, roofs).data().toString(), QString("func_detail"));
+    QCOMPARE(tree.index(1, 0, roofs).data().toString(), QString("solid 21"));
+}
+
+//!
+//! \brief WorldTreeTests::testLazyChildren nodes are only made for what is fetched
+//!
+void WorldTreeTests::testLazyChildren() {
+    Map map;
+    QList<Brush> brushes = boxBrushes(2000);
+    map.m_solids.addSolids(brushes);
+
+    WorldTreeModel tree(&map);
+    QCOMPARE(tree.nodeCount(), 2);
+
+    QModelIndex world = tree.index(0, 0);
+    QSignalSpy inserted(&tree, SIGNAL(rowsInserted(QModelIndex,int,int)));
+    tree.fetchMore(world);
+    QCOMPARE(tree.rowCount(world), TREE_FETCH_BATCH);
+    QCOMPARE(tree.nodeCount(), 2 + TREE_FETCH_BATCH);
+    QCOMPARE(inserted.count(), 1);
+
+    while(tree.canFetchMore(world))
+        tree.fetchMore(world);
+    QCOMPARE(tree.rowCount(world), 2000);
+    QCOMPARE(tree.index(1999, 0, world).data(WorldTreeModel::HandleRole).toInt(),
+             map.m_solids.handle(1999));
+
+    // No visgroups, so the branch turns out empty once looked at
+    QModelIndex visgroups = tree.index(1, 0);
+    QVERIFY(tree.hasChildren(visgroups));
+    tree.fetchMore(visgroups);
+    QVERIFY(!tree.hasChildren(visgroups));
+}
+
+//!
+//! \brief WorldTreeTests::testRemoveKeepsExpansion removed brushes leave, the rest of the tree stays
+//!
+void WorldTreeTests::testRemoveKeepsExpansion() {
+    Map map;
+    map.readVMF(":/vmfs/testGroups.vmf");
+    WorldTreeModel tree(&map);
+    QPersistentModelIndex world = tree.index(0, 0);
+    tree.fetchMore(world);
+    QPersistentModelIndex group = tree.index(0, 0, world);
+    tree.fetchMore(group);
+    QCOMPARE(tree.nodeCount(), 7);
+
+    QSignalSpy reset(&tree, SIGNAL(modelReset()));
+    QSignalSpy removed(&tree, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+    // solid 3, in no group
+    map.m_solids.removeSolids(QList<BrushHandle>() << map.m_solids.handle(1));
+    QCOMPARE(reset.count(), 0);
+    QCOMPARE(removed.count(), 1);
+    QCOMPARE(tree.nodeCount(), 6);
+    QVERIFY(world.isValid());
+    QVERIFY(group.isValid());
+    QCOMPARE(tree.rowCount(world), 2);
+    QCOMPARE(tree.rowCount(group), 2);
+    QCOMPARE(tree.index(1, 0, world).data().toString(), QString("func_detail"));
+    QCOMPARE(tree.parent(tree.index(1, 0, world)), QModelIndex(world));
+}
+//!
+//! \brief WorldTreeTests::testInsertKeepsExpansion new brushes join the branches already listed
+//!
+void WorldTreeTests::testInsertKeepsExpansion() {
+    Map map;
+    map.m_solids.addSolids(boxBrushes(TREE_FETCH_BATCH + 10));
+    WorldTreeModel tree(&map);
+    QPersistentModelIndex world = tree.index(0, 0);
+    tree.fetchMore(world);
+    QCOMPARE(tree.rowCount(world), TREE_FETCH_BATCH);
+
+    QSignalSpy reset(&tree, SIGNAL(modelReset()));
+    QSignalSpy inserted(&tree, SIGNAL(rowsInserted(QModelIndex,int,int)));
+    QVector<BrushHandle> handles = map.m_solids.addSolids(boxBrushes(5));
+    QCOMPARE(reset.count(), 0);
+    // Still fetching, they wait behind the others
+    QCOMPARE(inserted.count(), 0);
+    while(tree.canFetchMore(world))
+        tree.fetchMore(world);
+    QCOMPARE(tree.rowCount(world), TREE_FETCH_BATCH + 15);
+    QCOMPARE(tree.index(TREE_FETCH_BATCH + 14, 0, world).data(WorldTreeModel::HandleRole).toInt(),
+             handles.last());
+
+    // Fully fetched, they are made straight away
+    inserted.clear();
+    handles = map.m_solids.addSolids(boxBrushes(3));
+    QCOMPARE(reset.count(), 0);
+    QCOMPARE(inserted.count(), 1);
+    QCOMPARE(inserted.at(0).at(0).value<QModelIndex>(), QModelIndex(world));
+    QCOMPARE(tree.rowCount(world), TREE_FETCH_BATCH + 18);
+    QCOMPARE(tree.index(TREE_FETCH_BATCH + 17, 0, world).data(WorldTreeModel::HandleRole).toInt(),
+             handles.last());
+    // The visgroups were never listed, nothing was made there
+    QCOMPARE(tree.rowCount(tree.index(1, 0)), 0);
+}
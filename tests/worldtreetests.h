@@ -0,0 +1,20 @@
+#ifndef WORLDTREETESTS_H
+#define WORLDTREETESTS_H
+
+#include <QObject>
+#include <QTest>
+
+#include "worldtreemodel.h"
+
+class WorldTreeTests : public QObject
+{
+    Q_OBJECT
+private slots:
+    void testTreeStructure();
+    void testLazyChildren();
+    void testRemoveKeepsExpansion();
+    void testInsertKeepsExpansion();
+
+};
+
+#endif // WORLDTREETESTS_H
@@ -0,0 +1,232 @@
+/*
+This file is part of World Editor.
+
+World Editor is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+World Editor is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QList>
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+#include "trace.h"
+
+QBasicAtomicInt Trace::s_enabled = Q_BASIC_ATOMIC_INITIALIZER(0);
+
+//!
+//! \brief The TraceBuffer struct is the ring of events of one thread
+//!
+struct TraceBuffer
+{
+    QMutex mutex;
+    QVector<Trace::Event> events;
+    quint64 written;    //! Events ever recorded, the ring holds the last ones
+    int thread;         //! tid in the dump
+    QString name;
+    bool finished;      //! The thread is gone, clear can free the buffer
+};
+
+static QMutex s_buffersMutex;
+static QList<TraceBuffer *> s_buffers;
+static int s_nextThread = 1;
+
+//!
+//! \brief The TraceThread struct hands its buffer back when the thread ends
+//!
+struct TraceThread
+{
+    TraceBuffer *buffer;
+
+    TraceThread() : buffer(0) {}
+    ~TraceThread() {
+        if(!buffer)
+            return;
+        QMutexLocker locker(&buffer->mutex);
+        buffer->finished = true;
+    }
+};
+
+static thread_local TraceThread t_thread;
+
+//!
+//! \brief traceClock
+//! \return the clock every thread stamps its events with
+//!
+static const QElapsedTimer &traceClock() {
+    static const QElapsedTimer timer = []() {
+        QElapsedTimer started;
+        started.start();
+        return started;
+    }();
+    return timer;
+}
+//!
+//! \brief threadBuffer
+//! \return the buffer of the calling thread, made on its first event
+//!
+static TraceBuffer *threadBuffer() {
+    if(t_thread.buffer)
+        return t_thread.buffer;
+
+    TraceBuffer *buffer = new TraceBuffer;
+    buffer->events.resize(TRACE_BUFFER_EVENTS);
+    buffer->written = 0;
+    buffer->finished = false;
+    QThread *thread = QThread::currentThread();
+    buffer->name = thread->objectName();
+    if(buffer->name.isEmpty() && QCoreApplication::instance()
+            && thread == QCoreApplication::instance()->thread())
+        buffer->name = "Main";
+
+    QMutexLocker locker(&s_buffersMutex);
+    buffer->thread = s_nextThread++;
+    if(buffer->name.isEmpty())
+        buffer->name = QString("Thread %1").arg(buffer->thread);
+    s_buffers.append(buffer);
+    t_thread.buffer = buffer;
+    return buffer;
+}
+//!
+//! \brief Trace::setEnabled starts or stops recording
+//! What was recorded stays until clear.
+//! \param enabled
+//!
+void Trace::setEnabled(bool enabled) {
+    traceClock();
+    s_enabled.store(enabled ? 1 : 0);
+}
+//!
+//! \brief Trace::now
+//! \return ns since the trace clock started
+//!
+qint64 Trace::now() {
+    return traceClock().nsecsElapsed();
+}
+//!
+//! \brief Trace::record adds an event to the buffer of the calling thread
+//! \param category
+//! \param name - Has to outlive the trace, use a literal
+//! \param start
+//! \param duration
+//!
+void Trace::record(Category category, const char *name, qint64 start, qint64 duration) {
+    TraceBuffer *buffer = threadBuffer();
+    QMutexLocker locker(&buffer->mutex);
+    Event &event = buffer->events[int(buffer->written % TRACE_BUFFER_EVENTS)];
+    event.name = name;
+    event.category = category;
+    event.start = start;
+    event.duration = duration;
+    buffer->written++;
+}
+//!
+//! \brief Trace::clear forgets every event, and the buffers of threads that are gone
+//!
+void Trace::clear() {
+    QMutexLocker registry(&s_buffersMutex);
+    for(int i = s_buffers.size() - 1; i >= 0; i--) {
+        TraceBuffer *buffer = s_buffers.at(i);
+        buffer->mutex.lock();
+        const bool finished = buffer->finished;
+        buffer->written = 0;
+        buffer->mutex.unlock();
+        if(finished)
+            delete s_buffers.takeAt(i);
+    }
+}
+//!
+//! \brief Trace::categoryName
+//! \param category
+//! \return the name shown in the dump
+//!
+QString Trace::categoryName(Category category) {
+    switch(category) {
+    case LOAD: return "load";
+    case PARSE: return "parse";
+    case POLYGONISE: return "polygonise";
+    case SCENE: return "scene";
+    case PAINT: return "paint";
+    case JOBS: return "jobs";
+    default: return QString();
+    }
+}
+//!
+//! \brief Trace::toChromeJson dumps every buffer as complete events
+//! Each thread with events also gets its name as metadata, and the events
+//! overwritten in the rings are counted in otherData.
+//! \return {"traceEvents": [...], "displayTimeUnit": "ms", "otherData": {"droppedEvents"}}
+//!
+QJsonObject Trace::toChromeJson() {
+    const qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray events;
+    qint64 dropped = 0;
+
+    QMutexLocker registry(&s_buffersMutex);
+    foreach(TraceBuffer *buffer, s_buffers) {
+        QMutexLocker locker(&buffer->mutex);
+        if(buffer->written == 0)
+            continue;
+        const quint64 first = buffer->written > TRACE_BUFFER_EVENTS
+                ? buffer->written - TRACE_BUFFER_EVENTS : 0;
+        dropped += first;
+
+        QJsonObject args;
+        args["name"] = buffer->name;
+        QJsonObject thread;
+        thread["name"] = QString("thread_name");
+        thread["ph"] = QString("M");
+        thread["pid"] = pid;
+        thread["tid"] = buffer->thread;
+        thread["args"] = args;
+        events.append(thread);
+
+        for(quint64 i = first; i < buffer->written; i++) {
+            const Event &event = buffer->events.at(int(i % TRACE_BUFFER_EVENTS));
+            QJsonObject json;
+            json["name"] = QString(event.name);
+            json["cat"] = categoryName(event.category);
+            json["ph"] = QString("X");
+            json["ts"] = event.start / 1000.0;
+            json["dur"] = event.duration / 1000.0;
+            json["pid"] = pid;
+            json["tid"] = buffer->thread;
+            events.append(json);
+        }
+    }
+
+    QJsonObject other;
+    other["droppedEvents"] = dropped;
+    QJsonObject trace;
+    trace["traceEvents"] = events;
+    trace["displayTimeUnit"] = QString("ms");
+    trace["otherData"] = other;
+    return trace;
+}
+//!
+//! \brief Trace::writeFile
+//! \param fileName
+//! \return 1 for error
+//!
+int Trace::writeFile(const QString &fileName) {
+    QFile file(fileName);
+    if(!file.open(QFile::WriteOnly | QFile::Truncate))
+        return 1;
+    if(file.write(QJsonDocument(toChromeJson()).toJson(QJsonDocument::Compact)) < 0)
+        return 1;
+    return 0;
+}
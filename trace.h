@@ -0,0 +1,111 @@
+/*
+This file is part of World Editor.
+
+World Editor is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+World Editor is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QAtomicInt>
+#include <QJsonObject>
+#include <QString>
+
+//! Events kept per thread, older ones are overwritten
+#define TRACE_BUFFER_EVENTS 16384
+
+//!
+//! \brief The Trace class records timed spans into a ring buffer per thread
+//! Spans are marked with TRACE_SCOPE. While recording is off a scope costs one
+//! relaxed load, the names are literals so nothing is allocated either way.
+//! A thread only locks its own buffer, which nothing but a dump contends for.
+//! The buffers are dumped in the trace event format of chrome://tracing.
+//!
+class Trace
+{
+public:
+    enum Category {
+        LOAD,       //! Reading a file
+        PARSE,      //! Parsing its blocks
+        POLYGONISE, //! Brushes projected for the 2D views
+        SCENE,      //! Brushes added to the model and the 2D views
+        PAINT,      //! Painting the views
+        JOBS,       //! Jobs run by the job system
+        CATEGORY_COUNT
+    };
+
+    struct Event
+    {
+        const char *name;   //! A literal, never freed
+        Category category;
+        qint64 start;       //! ns since the trace clock started
+        qint64 duration;    //! ns
+    };
+
+private:
+    static QBasicAtomicInt s_enabled;
+
+public:
+    static bool isEnabled();
+    static void setEnabled(bool enabled);
+    static qint64 now();
+    static void record(Category category, const char *name, qint64 start, qint64 duration);
+    static void clear();
+
+    static QString categoryName(Category category);
+    static QJsonObject toChromeJson();
+    static int writeFile(const QString &fileName);
+};
+
+//!
+//! \brief Trace::isEnabled
+//! \return true while spans are recorded
+//!
+inline bool Trace::isEnabled() {
+    return s_enabled.load() != 0;
+}
+
+//!
+//! \brief The TraceScope class records the span from its construction to its destruction
+//! Whether it records is decided when it is made.
+//!
+class TraceScope
+{
+    const char *m_name;
+    Trace::Category m_category;
+    qint64 m_start;     //! -1 when not recording
+
+public:
+    TraceScope(Trace::Category category, const char *name)
+        : m_name(name), m_category(category), m_start(Trace::isEnabled() ? Trace::now() : -1) {
+    }
+    ~TraceScope() {
+        if(m_start >= 0)
+            Trace::record(m_category, m_name, m_start, Trace::now() - m_start);
+    }
+};
+
+#define TRACE_JOIN_(a, b) a##b
+#define TRACE_JOIN(a, b) TRACE_JOIN_(a, b)
+
+//! Traces the rest of the enclosing block, like TRACE_SCOPE(PARSE, "solid")
+//! Building with WORLDEDITOR_NO_TRACE defined leaves nothing behind.
+#ifdef WORLDEDITOR_NO_TRACE
+#define TRACE_SCOPE(category, name)
+#else
+#define TRACE_SCOPE(category, name) \
+    TraceScope TRACE_JOIN(traceScope, __LINE__)(Trace::category, name)
+#endif
+
+#endif // TRACE_H
@@ -16,10 +16,47 @@ along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 
+#include <QtMath>
+#include <QElapsedTimer>
+#include <QGraphicsView>
 #include "viewportscene.h"
+#include "jobsystem.h"
+#include "trace.h"
 #define GRID_INCREMENT 0
 #define GRID_DECREMENT 1
+#define GRID_MIN_PIXELS 4
+#define GRID_TILE_PIXELS 256
+//! The grid tile cache holds this many screens of tiles
+#define GRID_TILE_CACHE_SCREENS 3
+//! Past this scale brushes can get small enough on screen to be simplified
+#define LOD_MIN_SCALE 64
+#define RENDER_TILE_PIXELS 128
+//! Estimated private data of a QGraphicsItem, its size isn't public
+#define SCENE_ITEM_PRIVATE_BYTES 256
 
+//!
+//! \brief The RenderTile struct is one tile of a view rasterised off the GUI thread
+//!
+struct RenderTile
+{
+    QRect device;   //! Where the tile goes, in device independent pixels
+    QImage image;
+    int gridLines;
+};
+
+//!
+//! \brief gridTileCacheKB
+//! \param device - Where the grid tiles are drawn
+//! \return the cost in KiB of a few screens of grid tiles on the device
+//!
+static int gridTileCacheKB(const QPaintDevice *device) {
+    const int pixels = qCeil(GRID_TILE_PIXELS * device->devicePixelRatioF());
+    const int tileKB = qMax(1, pixels * pixels * 4 / 1024);
+    // A screen rarely lines up with the tiles, so it touches one more each way
+    const int columns = device->width() / GRID_TILE_PIXELS + 2;
+    const int rows = device->height() / GRID_TILE_PIXELS + 2;
+    return GRID_TILE_CACHE_SCREENS * columns * rows * tileKB;
+}
 
 //!
 //! \brief ViewPortScene::ViewPortScene
@@ -28,6 +65,7 @@ along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
 //! \param secondary
 //!
 ViewPortScene::ViewPortScene(Map *map, axis primary, axis secondary)
+    : m_gridTiles(0)
 {
 
     m_primary = primary;
@@ -36,28 +74,197 @@ ViewPortScene::ViewPortScene(Map *map, axis primary, axis secondary)
 
     m_scale = 8;
     m_grid = 1;
+    m_renderMode = DIRECT_RENDER;
+    m_mouseMode = SELECT;
+    m_dragging = false;
 
     QBrush background("black");
     setBackgroundBrush(background);
 
-    this->addItem(&brushes);
-    brushes.show();
+    this->addItem(&m_brushLayer);
+    m_brushLayer.show();
 
     this->addItem(&m_newTempBlock);
 
+    // Cosmetic pens keep their width on screen whatever the zoom,
+    // so zooming never has to touch the items
+    QPen outline(QBrush(QColor("pink")), 1, Qt::DashLine);
+    outline.setCosmetic(true);
+    m_brushLayer.setPen(outline);
+
+    // The selection outline is built once, a drag only changes its position,
+    // and the device cache turns that into a blit
+    QPen selected(QBrush(QColor("yellow")), 1, Qt::SolidLine);
+    selected.setCosmetic(true);
+    m_ghost.setPen(selected);
+    m_ghost.setZValue(1);
+    m_ghost.setCacheMode(QGraphicsItem::DeviceCoordinateCache);
+    this->addItem(&m_ghost);
+
     setScale(m_scale);
 
+    // Scenes can be made after the map has brushes
+    addRows(0, m_map->m_solids.rowCount() - 1);
 }
 //!
-//! \brief ViewPortScene::drawBackground
+//! \brief ViewPortScene::brushTransform maps world units into the scene
+//! One world unit is 64 scene units, flipped, with the origin in the middle of the scene
+//! \return
+//!
+QTransform ViewPortScene::brushTransform() {
+    return QTransform(-64, 0, 0, -64, 32768*32, 32768*32);
+}
+//!
+//! \brief ViewPortScene::drawBackground draws the grid, and the brushes when tiled
 //! \param painter
 //! \param rect
 //!
 void ViewPortScene::drawBackground(QPainter *painter, const QRectF &rect) {
+    TRACE_SCOPE(PAINT, "drawBackground");
+    QElapsedTimer timer;
+    timer.start();
 
-    // Get the coordinates of the viewport rectangle;
-    // We only want to remake the lines when the viewport is either zoomed or panned
     QGraphicsScene::drawBackground(painter, rect);
+    if(m_renderMode == TILED_RENDER)
+        drawTiled(painter, rect);
+    else
+        drawGridTiles(painter, rect);
+
+    m_stats.add(FrameStatistics::BACKGROUND_TIME, timer.nsecsElapsed());
+}
+//!
+//! \brief ViewPortScene::drawGridTiles blits the grid from pre-rendered tiles
+//! Tiles are only rendered when the zoom or the grid spacing changes, so
+//! panning the view is nothing more than drawing images.
+//! \param painter
+//! \param rect
+//!
+void ViewPortScene::drawGridTiles(QPainter *painter, const QRectF &rect) {
+    const QTransform &world = painter->worldTransform();
+    const qreal zoom = world.m11();
+    if(world.isRotating() || zoom <= 0 || zoom != world.m22()) {
+        // Tiles only line up with plain scaled views
+        m_stats.add(FrameStatistics::GRID_LINES, drawGridLayers(painter, rect, &m_gridLines));
+        return;
+    }
+
+    QRectF area = rect.intersected(QRectF(0, 0, 32768*64, 32768*64));
+    if(area.isEmpty())
+        return;
+
+    // Sized for the device painted on, setMaxCost trims the cache when it shrinks
+    m_gridTiles.setMaxCost(gridTileCacheKB(painter->device()));
+
+    const qreal tileSize = GRID_TILE_PIXELS / zoom;
+    const int left = qFloor(area.left() / tileSize);
+    const int top = qFloor(area.top() / tileSize);
+    const int right = qFloor(area.right() / tileSize);
+    const int bottom = qFloor(area.bottom() / tileSize);
+
+    for(int y = top; y <= bottom; y++) {
+        for(int x = left; x <= right; x++) {
+            GridTileKey key = { zoom, m_scale, m_grid, painter->device()->devicePixelRatioF(), x, y };
+            QRectF tileRect(x * tileSize, y * tileSize, tileSize, tileSize);
+            QImage *tile = m_gridTiles.object(key);
+            if(tile) {
+                painter->drawImage(tileRect, *tile);
+                continue;
+            }
+            QImage image = renderGridTile(key, tileRect);
+            painter->drawImage(tileRect, image);
+            m_gridTiles.insert(key, new QImage(image), qMax(1, image.bytesPerLine() * image.height() / 1024));
+        }
+    }
+}
+//!
+//! \brief ViewPortScene::renderGridTile renders one tile of the grid
+//! \param key
+//! \param rect the area of the scene the tile covers
+//! \return
+//!
+QImage ViewPortScene::renderGridTile(const GridTileKey &key, const QRectF &rect) {
+    int pixels = qCeil(GRID_TILE_PIXELS * key.dpr);
+    QImage tile(pixels, pixels, QImage::Format_ARGB32_Premultiplied);
+    tile.setDevicePixelRatio(key.dpr);
+    tile.fill(backgroundBrush().color());
+
+    QPainter painter(&tile);
+    painter.scale(key.zoom, key.zoom);
+    painter.translate(-rect.topLeft());
+    m_stats.add(FrameStatistics::GRID_LINES, drawGridLayers(&painter, rect, &m_gridLines));
+    painter.end();
+    return tile;
+}
+//!
+//! \brief ViewPortScene::drawTiled rasterises the grid and the brushes on the job system
+//! The exposed area is split into tiles which workers draw into images from a
+//! snapshot of the brush layer, then the images are composited here.
+//! The brushes are counted in the frame statistics, but their time is part of
+//! the background as the workers draw both at once.
+//! \param painter
+//! \param rect
+//!
+void ViewPortScene::drawTiled(QPainter *painter, const QRectF &rect) {
+    const QTransform world = painter->worldTransform();
+    const QTransform inverse = world.inverted();
+    const qreal dpr = painter->device()->devicePixelRatioF();
+    const QRect exposed = world.mapRect(rect).toAlignedRect();
+
+    QVector<RenderTile> tiles;
+    for(int y = exposed.top(); y <= exposed.bottom(); y += RENDER_TILE_PIXELS) {
+        for(int x = exposed.left(); x <= exposed.right(); x += RENDER_TILE_PIXELS) {
+            RenderTile tile;
+            tile.device = QRect(x, y, RENDER_TILE_PIXELS, RENDER_TILE_PIXELS).intersected(exposed);
+            tiles.append(tile);
+        }
+    }
+
+    // Snapshot everything the workers read, the layer may change while they run
+    const BrushGeometry geometry = m_brushLayer.geometry();
+    const QPen pen = m_brushLayer.pen();
+    const BrushLayerItem::LevelOfDetail detail = m_brushLayer.levelOfDetail();
+    const QColor background = backgroundBrush().color();
+
+    RenderTile *data = tiles.data();
+    JobSystem::global()->parallelFor(0, tiles.size(), [&](int i) {
+        TRACE_SCOPE(PAINT, "tile");
+        RenderTile &tile = data[i];
+        tile.image = QImage(tile.device.size() * dpr, QImage::Format_ARGB32_Premultiplied);
+        tile.image.setDevicePixelRatio(dpr);
+        tile.image.fill(background);
+
+        QPainter tilePainter(&tile.image);
+        tilePainter.translate(-tile.device.topLeft());
+        tilePainter.setTransform(world, true);
+        QRectF area = inverse.mapRect(QRectF(tile.device));
+        QVector<QLineF> lines;
+        tile.gridLines = drawGridLayers(&tilePainter, area, &lines);
+        BrushPaintBuffers buffers;
+        BrushLayerItem::draw(&tilePainter, geometry, pen, detail, area, &buffers);
+    }, 1);
+
+    painter->save();
+    painter->resetTransform();
+    foreach(const RenderTile &tile, tiles) {
+        painter->drawImage(tile.device.topLeft(), tile.image);
+        m_stats.add(FrameStatistics::GRID_LINES, tile.gridLines);
+    }
+    painter->restore();
+
+    // A brush crossing several tiles is painted by each of them, count it once
+    BrushPaintStats brushes = BrushLayerItem::cull(geometry, pen, inverse.mapRect(QRectF(exposed)));
+    m_stats.add(FrameStatistics::BRUSHES_PAINTED, brushes.painted);
+    m_stats.add(FrameStatistics::BRUSHES_CULLED, brushes.culled);
+}
+//!
+//! \brief ViewPortScene::drawGridLayers draws every level of the grid
+//! \param painter
+//! \param rect
+//! \param lines working memory
+//! \return the number of lines drawn
+//!
+int ViewPortScene::drawGridLayers(QPainter *painter, const QRectF &rect, QVector<QLineF> *lines) const {
+    int drawn = 0;
 
     QPen pen(QColor(128, 128, 128), 1*(m_scale/32), Qt::SolidLine, Qt::SquareCap, Qt::BevelJoin);
 
@@ -72,11 +279,11 @@ void ViewPortScene::drawBackground(QPainter *painter, const QRectF &rect) {
     if(m_scale < 150) {
         pen.setColor(QColor("light gray").lighter(50));
         pen.setWidth(minor);
-        drawGrid(m_grid, pen, painter, rect);
+        drawn += drawGrid(m_grid, pen, painter, rect, lines);
         pen.setColor(QColor("light gray"));
         pen.setWidth(major);
         if(m_grid <= 8)
-            drawGrid(8, pen, painter, rect);
+            drawn += drawGrid(8, pen, painter, rect, lines);
     }
     pen.setWidth(major);
     int zoom = 150;
@@ -84,10 +291,10 @@ void ViewPortScene::drawBackground(QPainter *painter, const QRectF &rect) {
     for(int i = 1; i < 8; i++) {
         if ((m_scale > zoom) && (m_scale < zoom*2)){
             if(m_grid > grid) {
-                drawGrid(m_grid,pen,painter,rect);
+                drawn += drawGrid(m_grid,pen,painter, rect, lines);
             }
             else {
-                drawGrid(grid,pen,painter,rect);
+                drawn += drawGrid(grid,pen,painter, rect, lines);
             }
         }
         zoom = zoom * 2;
@@ -95,47 +302,52 @@ void ViewPortScene::drawBackground(QPainter *painter, const QRectF &rect) {
     }
     // 1024 Step Lines
     pen.setColor(QColor("dark orange").darker(200));
-    drawGrid(1024,pen,painter,rect);
+    drawn += drawGrid(1024,pen,painter, rect, lines);
     // Center cross lines
     pen.setWidth(major*2);
     pen.setColor(QColor("dark red").darker(200));
-    drawGrid(16384,pen,painter,rect);
+    drawn += drawGrid(16384,pen,painter, rect, lines);
+    return drawn;
 }
 //!
-//! \brief ViewPortScene::drawGrid
+//! \brief ViewPortScene::drawGrid draws the grid lines crossing the exposed rect
+//! Lines that would be closer together on screen than GRID_MIN_PIXELS are
+//! skipped altogether, the rest go to the painter in a single drawLines call.
 //! \param units
 //! \param pen
 //! \param painter
 //! \param rect
+//! \param lines working memory
+//! \return the number of lines drawn
 //!
-void ViewPortScene::drawGrid(int units, QPen pen, QPainter *painter, const QRectF &rect) {
+int ViewPortScene::drawGrid(int units, QPen pen, QPainter *painter, const QRectF &rect,
+                            QVector<QLineF> *lines) const {
 
-    qreal x1, x2, y1, y2;
-    rect.getCoords(&x1,&y1,&x2,&y2);
-    painter->setPen(pen);
+    qreal spacing = units*64;
+    if(painter->worldTransform().mapRect(QRectF(0, 0, spacing, spacing)).width() < GRID_MIN_PIXELS)
+        return 0;
 
-    pen.setWidth(pen.width()*(units/8));
-    int startx = roundGrid(x1, units);
-    int starty = roundGrid(y1, units);
-    int endx = roundGrid(x2, units);
-    int endy = roundGrid(y2, units);
+    QRectF area = rect.intersected(QRectF(0, 0, 32768*64, 32768*64));
+    if(area.isEmpty())
+        return 0;
+    // Lines just outside the rect still reach into it when they are wide,
+    // without them tiles would show seams at their edges
+    qreal margin = pen.widthF() / 2;
+    area = area.adjusted(-margin, -margin, margin, margin);
 
-    if( (startx < 0) || ( starty < 0 ) || (endx < 32768) || (endy < 32768) ){
-        for(int i = 0; i<=32768*64; i=i+(units*64)) {
-            painter->drawLine(i,0,i,32768*64);
-        }
-        for(int i = 0; i<=32768*64; i=i+(units*64)) {
-            painter->drawLine(0,i,32768*64,i);
-        }
+    qreal startx = qCeil(area.left()/spacing)*spacing;
+    qreal starty = qCeil(area.top()/spacing)*spacing;
+
+    lines->resize(0);
+    for(qreal x = startx; x <= area.right(); x += spacing) {
+        lines->append(QLineF(x, area.top(), x, area.bottom()));
     }
-    else {
-        for(int i = startx; i<x2; i=i+(units*64)) {
-            painter->drawLine(i,starty,i,y2);
-        }
-        for(int i = starty; i<y2; i=i+(units*64)) {
-            painter->drawLine(startx,i,x2,i);
-        }
+    for(qreal y = starty; y <= area.bottom(); y += spacing) {
+        lines->append(QLineF(area.left(), y, area.right(), y));
     }
+    painter->setPen(pen);
+    painter->drawLines(*lines);
+    return lines->size();
 }
 //!
 //! \brief ViewPortScene::roundGrid rounds the input to the nearest units
@@ -149,15 +361,15 @@ int ViewPortScene::roundGrid(int input, int units) {
 }
 //!
 //! \brief ViewPortScene::setScale
+//! The brush pens are cosmetic, so this costs the same whatever the size of the map
 //! \param scale
 //!
 void ViewPortScene::setScale(qreal scale) {
     m_scale = scale;
-    foreach(QGraphicsItem *itm, brushes.childItems()) {
-        QGraphicsPolygonItem *pol = qgraphicsitem_cast<QGraphicsPolygonItem*>(itm);
-        QBrush outline(QColor("pink"));
-        pol->setPen(QPen(outline, m_scale/8, Qt::DashLine));
-    }
+    if(m_scale > LOD_MIN_SCALE)
+        m_brushLayer.setLevelOfDetail(BrushLayerItem::ADAPTIVE_DETAIL);
+    else
+        m_brushLayer.setLevelOfDetail(BrushLayerItem::FULL_DETAIL);
 }
 //!
 //! \brief ViewPortScene::setGrid changes the grid depth
@@ -174,31 +386,238 @@ void ViewPortScene::setGrid(bool step) {
             m_grid = m_grid/2;
         break;
     }
-    // Causes the scene to redraw its contents
-    this->invalidate(this->sceneRect());
+    // The grid tiles are stale, redraw the background only
+    m_gridTiles.clear();
+    this->invalidate(this->sceneRect(), QGraphicsScene::BackgroundLayer);
 }
 //!
-//! \brief ViewPortScene::addBrush
-//! \param brush
+//! \brief ViewPortScene::brushLayer
+//! \return the item drawing every brush in this view
 //!
-void ViewPortScene::addBrush(QModelIndex index, int first, int last) {
-    QVariant tmp = m_map->m_solids.index(first,0,index).data(Solids::BrushRole);
-    Brush brush = tmp.value<Brush>();
-    QList<QPolygonF> polygons = brush.polygonise(m_primary, m_secondary);
-
-    QVector<QPointF> list;
-    foreach(QPolygonF poly, polygons) {
-        for(int j=0; j<poly.size(); j++) {
-            poly[j].setX(poly[j].x() * -64);
-            poly[j].setY(poly[j].y() * -64);
-        }
-        poly.translate(32768*32,32768*32);
-        brushes.addToGroup(new QGraphicsPolygonItem(poly));
+const BrushLayerItem *ViewPortScene::brushLayer() const {
+    return &m_brushLayer;
+}
+//!
+//! \brief ViewPortScene::statistics
+//! \return what the last frames painted in the view cost
+//!
+const FrameStatistics &ViewPortScene::statistics() const {
+    return m_stats;
+}
+//!
+//! \brief ViewPortScene::accountMemory adds the brush layer, the items and the grid tiles to a report
+//! \param report
+//!
+void ViewPortScene::accountMemory(MemoryReport *report) const {
+    m_brushLayer.accountMemory(report);
+    report->add(MemoryReport::SCENE_GEOMETRY, MemoryReport::containerBytes(m_gridLines)
+                + m_ghost.path().elementCount() * sizeof(QPainterPath::Element));
+
+    const int items = this->items().count();
+    report->add(MemoryReport::SCENE_ITEMS, qint64(items) * SCENE_ITEM_PRIVATE_BYTES
+                + sizeof(m_brushLayer) + sizeof(m_newTempBlock) + sizeof(m_ghost), items);
 
-        // A group
-        // add group pointer into list with modelIndex in
+    report->add(MemoryReport::GRID_TILES, qint64(m_gridTiles.totalCost()) * 1024,
+                m_gridTiles.count());
+}
+//!
+//! \brief ViewPortScene::beginFrame starts counting the cost of a paint
+//!
+void ViewPortScene::beginFrame() {
+    m_stats.beginFrame();
+    m_brushLayer.takePaintStats();
+}
+//!
+//! \brief ViewPortScene::endFrame stores the cost of the paint in the statistics
+//! \param paintNsecs - Time the whole paint took
+//!
+void ViewPortScene::endFrame(qint64 paintNsecs) {
+    BrushPaintStats brushes = m_brushLayer.takePaintStats();
+    m_stats.add(FrameStatistics::BRUSH_TIME, brushes.nsecs);
+    m_stats.add(FrameStatistics::BRUSHES_PAINTED, brushes.painted);
+    m_stats.add(FrameStatistics::BRUSHES_CULLED, brushes.culled);
+    m_stats.add(FrameStatistics::PAINT_TIME, paintNsecs);
+    m_stats.endFrame();
+}
+//!
+//! \brief ViewPortScene::addBrush adds the inserted rows to the brush layer
+//! The polygons are already projected by the model, see Solids::addSolids
+//! \param index
+//! \param first
+//! \param last
+//!
+void ViewPortScene::addBrush(QModelIndex index, int first, int last) {
+    Q_UNUSED(index);
+    addRows(first, last);
+}
+//!
+//! \brief ViewPortScene::applyUpdate brings the brush layer up to date in one batch
+//! Only a reset rebuilds the layer. Without one the layer holds the brushes in
+//! row order, removed brushes are taken out by handle and the rest close up
+//! like the rows do, so changed rows are replaced where they are.
+//! \param update - From the SceneUpdateQueue of the model
+//!
+void ViewPortScene::applyUpdate(const SceneUpdate &update) {
+    const int rows = m_map->m_solids.rowCount();
+    if(update.reset) {
+        m_brushLayer.clear();
+        addRows(0, rows - 1);
+        updateSelectionOutline();
+        return;
+    }
+    if(!update.removed.isEmpty())
+        m_brushLayer.removeBrushes(update.removed);
+    if(!update.changed.isEmpty())
+        replaceRows(update.changed);
+    if(update.firstInserted >= 0)
+        addRows(update.firstInserted, rows - 1);
+}
+//!
+//! \brief ViewPortScene::addRows adds rows of the model to the brush layer
+//! The faces are written once, already placed in the scene, into the arena
+//! the layer keeps. The brushes are known by their handle so picking and
+//! selection survive removals.
+//! \param first
+//! \param last
+//!
+void ViewPortScene::addRows(int first, int last) {
+    const Solids &solids = m_map->m_solids;
+    last = qMin(last, solids.rowCount() - 1);
+    if(last < first)
+        return;
+    TRACE_SCOPE(SCENE, "addRows");
+    const int view = Polygoniser::viewIndex(m_primary, m_secondary);
+    const QTransform transform = brushTransform();
+    QVector<int> ids;
+    ids.reserve(last - first + 1);
+    PolygonArena faces;
+    if(view < 0) {
+        // The model keeps no projections for these axes
+        for(int row = first; row <= last; row++)
+            ids.append(solids.handle(row));
+        Polygoniser::poligoniseBatch(solids.brushes(), first, last, m_primary, m_secondary,
+                                     &faces, &transform);
+    }
+    else {
+        solids.visitBrushes(first, last, [&](int row, const Brush &, const ProjectedPolygons &projected) {
+            ids.append(solids.handle(row));
+            faces.append(projected.views[view], &transform);
+        });
+    }
+    m_brushLayer.addBrushes(ids, faces);
+}
 
+//!
+//! \brief ViewPortScene::replaceRows gives changed rows their new faces
+//! \param rows - Sorted, all of them already in the brush layer
+//!
+void ViewPortScene::replaceRows(const QVector<int> &rows) {
+    TRACE_SCOPE(SCENE, "replaceRows");
+    const Solids &solids = m_map->m_solids;
+    const QTransform transform = brushTransform();
+    PolygonArena faces;
+    const QSet<BrushHandle> selection = m_selection.toSet();
+    bool selected = false;
+    foreach(int row, rows) {
+        faces.append(solids.polygons(row, m_primary, m_secondary), &transform);
+        selected = selected || selection.contains(solids.handle(row));
+    }
+    m_brushLayer.replaceBrushes(rows, faces);
+    if(selected)
+        updateSelectionOutline();
+}
+//!
+//! \brief ViewPortScene::keyPressEvent deletes the selected brushes
+//! \param keyEvent
+//!
+void ViewPortScene::keyPressEvent(QKeyEvent *keyEvent) {
+    if(keyEvent->key() != Qt::Key_Delete || m_selection.isEmpty()) {
+        QGraphicsScene::keyPressEvent(keyEvent);
+        return;
+    }
+    m_map->m_solids.removeSolids(m_selection);
+    setBrushSelection(QList<BrushHandle>());
+    emit(brushSelectionChanged(m_selection));
+}
+//!
+//! \brief ViewPortScene::brushSelection
+//! \return the handles of the selected brushes
+//!
+QList<int> ViewPortScene::brushSelection() const {
+    return m_selection;
+}
+//!
+//! \brief ViewPortScene::setBrushSelection selects brushes and outlines them
+//! \param handles
+//!
+void ViewPortScene::setBrushSelection(const QList<int> &handles) {
+    m_selection = handles;
+    updateSelectionOutline();
+}
+//!
+//! \brief ViewPortScene::updateSelectionOutline builds the outline of the selection
+//! from the brush layer, it is only moved afterwards
+//!
+void ViewPortScene::updateSelectionOutline() {
+    QPainterPath path;
+    if(!m_selection.isEmpty()) {
+        QSet<int> selected = m_selection.toSet();
+        const BrushGeometry &geometry = m_brushLayer.geometry();
+        const PolygonArena &faces = geometry.faces;
+        for(int b = 0; b < geometry.brushIds.size(); b++) {
+            if(!selected.contains(geometry.brushIds.at(b)))
+                continue;
+            int last = faces.brushOffsets.at(b) + faces.brushCounts.at(b);
+            for(int face = faces.brushOffsets.at(b); face < last; face++) {
+                const QPointF *points = faces.points.constData() + faces.offsets.at(face);
+                int count = faces.counts.at(face);
+                if(count < 2)
+                    continue;
+                path.moveTo(points[0]);
+                for(int i = 1; i < count; i++)
+                    path.lineTo(points[i]);
+                path.closeSubpath();
+            }
+        }
     }
+    m_ghost.setPath(path);
+}
+//!
+//! \brief ViewPortScene::ghostOffset
+//! \return how far the selection outline is dragged, in map units
+//!
+QVector3D ViewPortScene::ghostOffset() const {
+    QVector3D offset;
+    offset[m_primary] = m_ghost.pos().x() / -64;
+    offset[m_secondary] = m_ghost.pos().y() / -64;
+    return offset;
+}
+//!
+//! \brief ViewPortScene::setGhostOffset moves the selection outline, not the brushes
+//! Views looking down another axis follow a drag through this, the axis
+//! they do not show is ignored.
+//! \param offset - In map units
+//!
+void ViewPortScene::setGhostOffset(const QVector3D &offset) {
+    m_ghost.setPos(offset[m_primary] * -64, offset[m_secondary] * -64);
+}
+//!
+//! \brief ViewPortScene::pixelSize
+//! \return the size of a screen pixel in the scene, for picking tolerances
+//!
+qreal ViewPortScene::pixelSize() const {
+    if(views().isEmpty() || views().first()->transform().m11() == 0)
+        return 1;
+    return 1 / qAbs(views().first()->transform().m11());
+}
+//!
+//! \brief ViewPortScene::setRenderMode
+//! \param mode
+//!
+void ViewPortScene::setRenderMode(RENDER_MODE mode) {
+    m_renderMode = mode;
+    m_brushLayer.setRenderedByScene(mode == TILED_RENDER);
+    this->invalidate(this->sceneRect(), QGraphicsScene::BackgroundLayer);
 }
 
 void ViewPortScene::setMouseMode(MOUSE_INTERACT_MODE mode) {
@@ -209,8 +628,24 @@ void ViewPortScene::setMouseMode(MOUSE_INTERACT_MODE mode) {
 //! \param mouseEvent
 //!
 void ViewPortScene::mousePressEvent(QGraphicsSceneMouseEvent *mouseEvent) {
+    BrushHandle handle;
     switch (m_mouseMode) {
     case SELECT:
+        handle = m_brushLayer.brushAt(mouseEvent->scenePos(), 3 * pixelSize());
+        if(handle < 0) {
+            setBrushSelection(QList<BrushHandle>());
+        }
+        else if(!m_selection.contains(handle)) {
+            QList<BrushHandle> handles;
+            if(mouseEvent->modifiers() & Qt::ControlModifier)
+                handles = m_selection;
+            handles.append(handle);
+            setBrushSelection(handles);
+        }
+        emit(brushSelectionChanged(m_selection));
+        m_dragging = !m_selection.isEmpty();
+        m_dragStart = mouseEvent->scenePos();
+        break;
     case NEW:
         m_pressPoint = QPoint(roundGrid(mouseEvent->scenePos().x(),m_grid),
                               roundGrid(mouseEvent->scenePos().y(),m_grid));
@@ -224,9 +659,20 @@ void ViewPortScene::mousePressEvent(QGraphicsSceneMouseEvent *mouseEvent) {
 //! \param mouseEvent
 //!
 void ViewPortScene::mouseReleaseEvent(QGraphicsSceneMouseEvent *mouseEvent) {
+    QVector3D offset;
     switch (m_mouseMode) {
     case SELECT:
-
+        if(!m_dragging)
+            break;
+        // The model is only touched now, in one edit for the whole drag
+        m_dragging = false;
+        offset = ghostOffset();
+        emit(ghostMoved(QVector3D()));
+        setGhostOffset(QVector3D());
+        if(!offset.isNull()) {
+            m_map->m_solids.translateSolids(m_selection, m_primary, m_secondary,
+                                            QVector2D(offset[m_primary], offset[m_secondary]));
+        }
         break;
     case NEW:
         // Set the press point back to default so it doesnt automatically make a new box
@@ -246,14 +692,27 @@ void ViewPortScene::mouseMoveEvent(QGraphicsSceneMouseEvent *mouseEvent) {
     QBrush changing(QColor(0x00, 0x00, 255, 0x40));
     QBrush yellowOutline(QColor("yellow"));
     if(Qt::NoButton == mouseEvent->button()) {
+        QPointF delta;
+        QVector3D offset;
         switch (m_mouseMode) {
         case SELECT:
-
+            if(!m_dragging)
+                break;
+            // Snap to the grid in map units, the scene is 64 units to one and flipped
+            delta = (mouseEvent->scenePos() - m_dragStart) / -64;
+            offset[m_primary] = qRound(delta.x() / m_grid) * m_grid;
+            offset[m_secondary] = qRound(delta.y() / m_grid) * m_grid;
+            if(offset != ghostOffset()) {
+                setGhostOffset(offset);
+                emit(ghostMoved(offset));
+            }
             break;
         case NEW:
             if(m_pressPoint != QPoint()) {
                 m_newTempBlock.setBrush(changing);
-                m_newTempBlock.setPen(QPen(yellowOutline, m_scale/8, Qt::DashLine));
+                QPen pen(yellowOutline, 1, Qt::DashLine);
+                pen.setCosmetic(true);
+                m_newTempBlock.setPen(pen);
                 rect.setHeight(mouse_y-m_pressPoint.y());
                 rect.setWidth(mouse_x-m_pressPoint.x());
                 if(mouse_x - m_pressPoint.x() < 0) {
@@ -23,9 +23,16 @@ along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
 #include <QGraphicsRectItem>
 #include <QGraphicsLineItem>
 #include <QGraphicsItemGroup>
+#include <QGraphicsPathItem>
 #include <QGraphicsSceneMouseEvent>
+#include <QKeyEvent>
+#include <QCache>
+#include <QImage>
 #include "brush.h"
 #include "map.h"
+#include "brushlayeritem.h"
+#include "framestatistics.h"
+#include "sceneupdatequeue.h"
 
 
 enum MOUSE_INTERACT_MODE {
@@ -34,6 +41,35 @@ enum MOUSE_INTERACT_MODE {
     TRANSFORM,
 };
 
+enum RENDER_MODE {
+    DIRECT_RENDER,  //! Painted by QPainter on the GUI thread
+    TILED_RENDER,   //! Rasterised in tiles on the job system, then composited
+};
+
+//!
+//! \brief The GridTileKey struct identifies a pre-rendered tile of the grid
+//! Tiles are a fixed size on screen, so their size in the scene depends on the zoom.
+//!
+struct GridTileKey
+{
+    qreal zoom;     //! View scale the tile was rendered at
+    qreal scale;    //! ViewPortScene::m_scale, sets the pen widths
+    int grid;       //! ViewPortScene::m_grid
+    qreal dpr;      //! Device pixel ratio
+    int x;          //! Tile column in the scene
+    int y;          //! Tile row in the scene
+};
+
+inline bool operator==(const GridTileKey &a, const GridTileKey &b) {
+    return a.zoom == b.zoom && a.scale == b.scale && a.grid == b.grid
+            && a.dpr == b.dpr && a.x == b.x && a.y == b.y;
+}
+
+inline uint qHash(const GridTileKey &key, uint seed = 0) {
+    return qHash(key.zoom, seed) ^ qHash(key.scale) ^ uint(key.grid)
+            ^ uint(key.x * 73856093) ^ uint(key.y * 19349663);
+}
+
 //!
 //! \brief The ViewPortScene class
 //! The view port for editing the 3d brushes in 2 dimensions
@@ -43,8 +79,17 @@ class ViewPortScene : public QGraphicsScene
     Q_OBJECT
 private:
     int roundGrid(int input, int units);
-    void drawGrid(int units, QPen pen, QPainter *painter, const QRectF &rect);
+    int drawGrid(int units, QPen pen, QPainter *painter, const QRectF &rect,
+                 QVector<QLineF> *lines) const;
+    int drawGridLayers(QPainter *painter, const QRectF &rect, QVector<QLineF> *lines) const;
+    void drawGridTiles(QPainter *painter, const QRectF &rect);
+    void drawTiled(QPainter *painter, const QRectF &rect);
+    QImage renderGridTile(const GridTileKey &key, const QRectF &rect);
     void drawBackground(QPainter *painter, const QRectF &rect);
+    void addRows(int first, int last);
+    void replaceRows(const QVector<int> &rows);
+    void updateSelectionOutline();
+    qreal pixelSize() const;
     int m_default_size;
     qreal m_scale;
     int m_grid;
@@ -53,20 +98,45 @@ private:
     QPoint m_pressPoint;
     QGraphicsRectItem m_newTempBlock;
     Map *m_map;
-    QGraphicsItemGroup brushes;
+    BrushLayerItem m_brushLayer; //! Every brush in this view
     MOUSE_INTERACT_MODE m_mouseMode;
+    RENDER_MODE m_renderMode;
+    QVector<QLineF> m_gridLines; //! Reused by drawGrid so repaints don't allocate
+    QCache<GridTileKey, QImage> m_gridTiles; //! Pre-rendered grid, cost in KiB
+    FrameStatistics m_stats;
+    QList<BrushHandle> m_selection; //! Handles of the selected brushes
+    QGraphicsPathItem m_ghost;      //! Cached outline of the selection, moved while dragging
+    bool m_dragging;
+    QPointF m_dragStart;
 
 public:
     ViewPortScene(Map *map, axis primary, axis secondary);
+    static QTransform brushTransform();
+    const BrushLayerItem *brushLayer() const;
+    const FrameStatistics &statistics() const;
+    void accountMemory(MemoryReport *report) const;
+    void beginFrame();
+    void endFrame(qint64 paintNsecs);
     void mousePressEvent(QGraphicsSceneMouseEvent *mouseEvent);
     void mouseReleaseEvent(QGraphicsSceneMouseEvent *mouseEvent);
     void mouseMoveEvent(QGraphicsSceneMouseEvent *mouseEvent);
+    void keyPressEvent(QKeyEvent *keyEvent);
+    QList<BrushHandle> brushSelection() const;
+    QVector3D ghostOffset() const;
+
+signals:
+    void brushSelectionChanged(const QList<int> &handles);
+    void ghostMoved(const QVector3D &offset);
 
 public slots:
     void setScale(qreal scale);
     void setGrid(bool step);
     void setMouseMode(MOUSE_INTERACT_MODE mode);
+    void setRenderMode(RENDER_MODE mode);
     void addBrush(QModelIndex index, int first, int last);
+    void applyUpdate(const SceneUpdate &update);
+    void setBrushSelection(const QList<int> &handles);
+    void setGhostOffset(const QVector3D &offset);
 };
 
 #endif // VIEWPORT_H
@@ -14,7 +14,16 @@ GNU General Public License for more details.
 You should have received a copy of the GNU General Public License
 along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
 */
+#include <QElapsedTimer>
+#include <QPainter>
 #include "viewportview.h"
+#include "viewportscene.h"
+#include "startuptrace.h"
+#include "trace.h"
+
+//! Size of the frame statistics overlay
+#define STATISTICS_WIDTH 330
+#define STATISTICS_HEIGHT 112
 //!
 //! \brief ViewPortView::ViewPortView
 //! \param parent
@@ -22,6 +31,7 @@ along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
 ViewPortView::ViewPortView ( QWidget * parent )
     : QGraphicsView(parent) {
     m_scale = 8;
+    m_showStatistics = false;
 }
 //!
 //! \brief ViewPortView::wheelEvent
@@ -58,4 +68,64 @@ void ViewPortView::wheelEvent(QWheelEvent * event)
 void ViewPortView::releaseScale() {
     emit(scaleChanged(m_scale));
 }
+//!
+//! \brief ViewPortView::paintEvent times the paint and draws the statistics overlay
+//! \param event
+//!
+void ViewPortView::paintEvent(QPaintEvent *event) {
+    TRACE_SCOPE(PAINT, "paintEvent");
+    ViewPortScene *viewScene = qobject_cast<ViewPortScene *>(scene());
+    if(!viewScene) {
+        QGraphicsView::paintEvent(event);
+        return;
+    }
 
+    QElapsedTimer timer;
+    timer.start();
+    viewScene->beginFrame();
+    QGraphicsView::paintEvent(event);
+    viewScene->endFrame(timer.nsecsElapsed());
+    StartupTrace::firstFrame();
+
+    if(!m_showStatistics)
+        return;
+    QRect box = statisticsRect();
+    if(!event->region().intersects(box))
+        return;
+    if(!event->region().contains(box)) {
+        // Only part of the overlay was exposed, redraw all of it next
+        viewport()->update(box);
+        return;
+    }
+    QPainter painter(viewport());
+    painter.fillRect(box, QColor(0, 0, 0, 200));
+    painter.setPen(QColor("light gray"));
+    painter.setFont(QFont("monospace", 8));
+    painter.drawText(box.adjusted(6, 4, -6, -4), Qt::AlignLeft | Qt::AlignTop,
+                     viewScene->statistics().summary().join("\n"));
+}
+//!
+//! \brief ViewPortView::statisticsRect
+//! \return where the overlay goes in the viewport
+//!
+QRect ViewPortView::statisticsRect() const {
+    return QRect(4, 4, STATISTICS_WIDTH, STATISTICS_HEIGHT);
+}
+//!
+//! \brief ViewPortView::setStatisticsVisible shows the frame statistics over the view
+//! \param visible
+//!
+void ViewPortView::setStatisticsVisible(bool visible) {
+    m_showStatistics = visible;
+    viewport()->update();
+}
+//!
+//! \brief ViewPortView::statistics
+//! \return the frame statistics of the scene as JSON, empty without a ViewPortScene
+//!
+QJsonObject ViewPortView::statistics() const {
+    ViewPortScene *viewScene = qobject_cast<ViewPortScene *>(scene());
+    if(!viewScene)
+        return QJsonObject();
+    return viewScene->statistics().toJson();
+}
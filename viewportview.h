@@ -20,6 +20,8 @@ along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
 #include <QGraphicsView>
 #include <QObject>
 #include <QWheelEvent>
+#include <QPaintEvent>
+#include <QJsonObject>
 
 //!
 //! \brief The ViewPortView class
@@ -31,14 +33,20 @@ class ViewPortView : public QGraphicsView
 {
 Q_OBJECT
 private:
+    bool m_showStatistics;
+    QRect statisticsRect() const;
 public:
     ViewPortView ( QWidget * parent = 0 );
     void releaseScale();
+    QJsonObject statistics() const;
     qreal m_scale;
 signals:
     void scaleChanged(qreal scale);
+public slots:
+    void setStatisticsVisible(bool visible);
 protected:
     virtual void wheelEvent ( QWheelEvent * event );
+    virtual void paintEvent ( QPaintEvent * event );
 };
 
 #endif // VIEWPORTVIEW_H
@@ -0,0 +1,54 @@
+#-------------------------------------------------
+#
+# The editor without its window, shared by the
+# application and the tests
+#
+#-------------------------------------------------
+
+QT       += core gui concurrent
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+CONFIG += c++11
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/brush.cpp \
+    $$PWD/viewportscene.cpp \
+    $$PWD/viewportview.cpp \
+    $$PWD/map.cpp \
+    $$PWD/polygoniser.cpp \
+    $$PWD/solids.cpp \
+    $$PWD/solidssnapshot.cpp \
+    $$PWD/worldtreemodel.cpp \
+    $$PWD/polygoncache.cpp \
+    $$PWD/brushlayeritem.cpp \
+    $$PWD/softwarerenderer.cpp \
+    $$PWD/cameraview.cpp \
+    $$PWD/framestatistics.cpp \
+    $$PWD/memoryreport.cpp \
+    $$PWD/sceneupdatequeue.cpp \
+    $$PWD/jobsystem.cpp \
+    $$PWD/startuptrace.cpp \
+    $$PWD/trace.cpp
+
+HEADERS += \
+    $$PWD/brush.h \
+    $$PWD/viewportscene.h \
+    $$PWD/viewportview.h \
+    $$PWD/map.h \
+    $$PWD/polygoniser.h \
+    $$PWD/solids.h \
+    $$PWD/solidssnapshot.h \
+    $$PWD/worldtreemodel.h \
+    $$PWD/polygoncache.h \
+    $$PWD/brushlayeritem.h \
+    $$PWD/softwarerenderer.h \
+    $$PWD/cameraview.h \
+    $$PWD/framestatistics.h \
+    $$PWD/memoryreport.h \
+    $$PWD/sceneupdatequeue.h \
+    $$PWD/jobsystem.h \
+    $$PWD/startuptrace.h \
+    $$PWD/trace.h
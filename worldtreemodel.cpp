@@ -0,0 +1,430 @@
+/*
+This file is part of World Editor.
+
+World Editor is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+World Editor is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include "worldtreemodel.h"
+
+//!
+//! \brief WorldTreeModel::Node::Node
+//! \param kind
+//! \param ref - What the node stands for, see NodeKind
+//! \param parent
+//! \param row
+//!
+WorldTreeModel::Node::Node(NodeKind kind, int ref, Node *parent, int row)
+    : kind(kind), ref(ref), parent(parent), row(row), listed(false)
+{
+}
+//!
+//! \brief WorldTreeModel::Node::~Node
+//!
+WorldTreeModel::Node::~Node() {
+    qDeleteAll(children);
+}
+
+//!
+//! \brief WorldTreeModel::WorldTreeModel
+//! \param map
+//! \param parent
+//!
+WorldTreeModel::WorldTreeModel(Map *map, QObject *parent)
+    : QAbstractItemModel(parent), m_map(map), m_root(0)
+{
+    rebuild();
+    // Brushes added or removed are put in or taken out of the branches
+    // already made, so the view keeps what it has expanded. Solid nodes
+    // know their brush by handle, a new row order doesn't touch them.
+    connect(&map->m_solids, SIGNAL(rowsInserted(QModelIndex,int,int)),
+            this, SLOT(addSolidRows(QModelIndex,int,int)));
+    connect(&map->m_solids, SIGNAL(rowsRemoved(QModelIndex,int,int)), this, SLOT(removeSolidNodes()));
+    // A file was read, its groups, entities and visgroups are all new
+    connect(&map->m_solids, SIGNAL(modelReset()), this, SLOT(rebuild()));
+    connect(map, SIGNAL(solidInfoChanged()), this, SLOT(rebuild()));
+}
+//!
+//! \brief WorldTreeModel::~WorldTreeModel
+//!
+WorldTreeModel::~WorldTreeModel() {
+    delete m_root;
+}
+//!
+//! \brief WorldTreeModel::rebuild drops every node below the world and the visgroups
+//!
+void WorldTreeModel::rebuild() {
+    beginResetModel();
+    delete m_root;
+    m_root = new Node(ROOT_NODE, 0, 0, 0);
+    m_root->listed = true;
+    m_root->children.append(new Node(WORLD_NODE, 0, m_root, 0));
+    m_root->children.append(new Node(VISGROUP_LIST_NODE, 0, m_root, 1));
+    endResetModel();
+}
+//!
+//! \brief WorldTreeModel::addSolidRows puts new brushes in the branches already listed
+//! Branches not listed yet find them when they are.
+//! \param parent
+//! \param first
+//! \param last
+//!
+void WorldTreeModel::addSolidRows(const QModelIndex &parent, int first, int last) {
+    Q_UNUSED(parent);
+    QVector<BrushHandle> handles;
+    for(int row = first; row <= last; row++)
+        handles.append(m_map->m_solids.handle(row));
+
+    foreach(Node *n, madeNodes()) {
+        if(!n->listed)
+            continue;
+        QVector<NodeRef> refs;
+        foreach(BrushHandle handle, handles) {
+            if(holdsSolid(n, handle))
+                refs.append(NodeRef(SOLID_NODE, handle));
+        }
+        if(refs.isEmpty())
+            continue;
+        if(!n->pending.isEmpty()) {
+            // The pending children are taken from the back, these go last
+            std::reverse(refs.begin(), refs.end());
+            n->pending = refs + n->pending;
+            continue;
+        }
+        const int row = n->children.size();
+        beginInsertRows(indexOf(n), row, row + refs.size() - 1);
+        for(int i = 0; i < refs.size(); i++)
+            n->children.append(new Node(SOLID_NODE, refs.at(i).second, n, row + i));
+        endInsertRows();
+    }
+}
+//!
+//! \brief WorldTreeModel::removeSolidNodes takes the brushes no longer in the map out of the tree
+//! Only the nodes already made are visited.
+//!
+void WorldTreeModel::removeSolidNodes() {
+    const Solids &solids = m_map->m_solids;
+    foreach(Node *n, madeNodes()) {
+        for(int i = n->pending.size() - 1; i >= 0; i--) {
+            if(n->pending.at(i).first == SOLID_NODE && solids.row(n->pending.at(i).second) < 0)
+                n->pending.remove(i);
+        }
+        // Runs of removed children from the back, so the rows in front stay put
+        int last = n->children.size() - 1;
+        while(last >= 0) {
+            const Node *child = n->children.at(last);
+            if(child->kind != SOLID_NODE || solids.row(child->ref) >= 0) {
+                last--;
+                continue;
+            }
+            int first = last;
+            while(first > 0 && n->children.at(first - 1)->kind == SOLID_NODE &&
+                  solids.row(n->children.at(first - 1)->ref) < 0)
+                first--;
+            beginRemoveRows(indexOf(n), first, last);
+            qDeleteAll(n->children.begin() + first, n->children.begin() + last + 1);
+            n->children.remove(first, last - first + 1);
+            for(int row = first; row < n->children.size(); row++)
+                n->children.at(row)->row = row;
+            endRemoveRows();
+            last = first - 1;
+        }
+    }
+}
+//!
+//! \brief WorldTreeModel::node
+//! \param index
+//! \return the node of an index, the root for an invalid one
+//!
+WorldTreeModel::Node *WorldTreeModel::node(const QModelIndex &index) const {
+    if(!index.isValid())
+        return m_root;
+    return static_cast<Node *>(index.internalPointer());
+}
+//!
+//! \brief WorldTreeModel::indexOf
+//! \param node
+//! \return the index of a node, an invalid one for the root
+//!
+QModelIndex WorldTreeModel::indexOf(Node *node) const {
+    if(node == m_root)
+        return QModelIndex();
+    return createIndex(node->row, 0, node);
+}
+//!
+//! \brief WorldTreeModel::madeNodes
+//! \return the root and every node made under it, parents before their children
+//!
+QList<WorldTreeModel::Node *> WorldTreeModel::madeNodes() const {
+    QList<Node *> nodes;
+    nodes.append(m_root);
+    for(int i = 0; i < nodes.size(); i++) {
+        foreach(Node *child, nodes.at(i)->children)
+            nodes.append(child);
+    }
+    return nodes;
+}
+//!
+//! \brief WorldTreeModel::solidInfo
+//! \param handle
+//! \return what the file said about a brush, a brush of the world in no group if nothing
+//!
+Map::s_solid WorldTreeModel::solidInfo(BrushHandle handle) const {
+    return m_map->m_solidInfo.value(handle);
+}
+//!
+//! \brief WorldTreeModel::mayHaveChildren answers hasChildren without listing the node
+//! \param node
+//! \return
+//!
+bool WorldTreeModel::mayHaveChildren(const Node *node) const {
+    switch(node->kind) {
+    case SOLID_NODE:
+        return false;
+    case ENTITY_NODE:
+        return !m_map->m_entities.at(node->ref).solids.isEmpty();
+    default:
+        return true;
+    }
+}
+//!
+//! \brief WorldTreeModel::holdsSolid
+//! \param node
+//! \param handle
+//! \return true if list puts the brush under the node
+//!
+bool WorldTreeModel::holdsSolid(const Node *node, BrushHandle handle) const {
+    const Map::s_solid info = solidInfo(handle);
+    switch(node->kind) {
+    case WORLD_NODE:
+        return info.entity < 0 && info.groupid == 0;
+    case GROUP_NODE:
+        return info.entity < 0 && info.groupid == m_map->m_groups.at(node->ref).id;
+    case ENTITY_NODE:
+        return m_map->m_entities.at(node->ref).solids.contains(handle);
+    case VISGROUP_NODE:
+        return info.visgroupids.contains(m_map->m_visgroups.at(node->ref).id);
+    default:
+        return false;
+    }
+}
+//!
+//! \brief WorldTreeModel::list works out the children of a node without making them
+//! This is the only place that walks the whole map, and only for the
+//! branches a view has expanded.
+//! \param node
+//!
+void WorldTreeModel::list(Node *node) const {
+    node->listed = true;
+    const Solids &solids = m_map->m_solids;
+
+    switch(node->kind) {
+    case WORLD_NODE:
+    case GROUP_NODE: {
+        const int group = node->kind == GROUP_NODE ? m_map->m_groups.at(node->ref).id : 0;
+        for(int i = 0; i < m_map->m_groups.count(); i++) {
+            if(m_map->m_groups.at(i).groupid == group && !(node->kind == GROUP_NODE && i == node->ref))
+                node->pending.append(NodeRef(GROUP_NODE, i));
+        }
+        for(int i = 0; i < m_map->m_entities.count(); i++) {
+            if(m_map->m_entities.at(i).groupid == group)
+                node->pending.append(NodeRef(ENTITY_NODE, i));
+        }
+        for(int row = 0; row < solids.rowCount(); row++) {
+            Map::s_solid info = solidInfo(solids.handle(row));
+            if(info.entity < 0 && info.groupid == group)
+                node->pending.append(NodeRef(SOLID_NODE, solids.handle(row)));
+        }
+        break;
+    }
+    case ENTITY_NODE:
+        foreach(BrushHandle handle, m_map->m_entities.at(node->ref).solids) {
+            if(solids.row(handle) >= 0)
+                node->pending.append(NodeRef(SOLID_NODE, handle));
+        }
+        break;
+    case VISGROUP_LIST_NODE:
+    case VISGROUP_NODE: {
+        const int parent = node->kind == VISGROUP_NODE ? node->ref : -1;
+        for(int i = 0; i < m_map->m_visgroups.count(); i++) {
+            if(m_map->m_visgroups.at(i).parent == parent)
+                node->pending.append(NodeRef(VISGROUP_NODE, i));
+        }
+        if(node->kind == VISGROUP_LIST_NODE)
+            break;
+        const int visgroup = m_map->m_visgroups.at(node->ref).id;
+        for(int i = 0; i < m_map->m_groups.count(); i++) {
+            if(m_map->m_groups.at(i).visgroupids.contains(visgroup))
+                node->pending.append(NodeRef(GROUP_NODE, i));
+        }
+        for(int i = 0; i < m_map->m_entities.count(); i++) {
+            if(m_map->m_entities.at(i).visgroupids.contains(visgroup))
+                node->pending.append(NodeRef(ENTITY_NODE, i));
+        }
+        for(int row = 0; row < solids.rowCount(); row++) {
+            if(solidInfo(solids.handle(row)).visgroupids.contains(visgroup))
+                node->pending.append(NodeRef(SOLID_NODE, solids.handle(row)));
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    // Taken from the back by fetchMore
+    std::reverse(node->pending.begin(), node->pending.end());
+}
+//!
+//! \brief WorldTreeModel::index
+//! \param row
+//! \param column
+//! \param parent
+//! \return
+//!
+QModelIndex WorldTreeModel::index(int row, int column, const QModelIndex &parent) const {
+    if(!hasIndex(row, column, parent))
+        return QModelIndex();
+    return createIndex(row, column, node(parent)->children.at(row));
+}
+//!
+//! \brief WorldTreeModel::parent
+//! \param index
+//! \return
+//!
+QModelIndex WorldTreeModel::parent(const QModelIndex &index) const {
+    if(!index.isValid())
+        return QModelIndex();
+    Node *parent = node(index)->parent;
+    if(parent == m_root)
+        return QModelIndex();
+    return createIndex(parent->row, 0, parent);
+}
+//!
+//! \brief WorldTreeModel::rowCount
+//! \param parent
+//! \return the children fetched so far
+//!
+int WorldTreeModel::rowCount(const QModelIndex &parent) const {
+    if(parent.column() > 0)
+        return 0;
+    return node(parent)->children.size();
+}
+//!
+//! \brief WorldTreeModel::columnCount
+//! \param parent
+//! \return
+//!
+int WorldTreeModel::columnCount(const QModelIndex &parent) const {
+    Q_UNUSED(parent);
+    return 1;
+}
+//!
+//! \brief WorldTreeModel::hasChildren tells the view to draw an expander
+//! \param parent
+//! \return
+//!
+bool WorldTreeModel::hasChildren(const QModelIndex &parent) const {
+    const Node *n = node(parent);
+    if(!n->listed)
+        return mayHaveChildren(n);
+    return !n->children.isEmpty() || !n->pending.isEmpty();
+}
+//!
+//! \brief WorldTreeModel::canFetchMore
+//! \param parent
+//! \return
+//!
+bool WorldTreeModel::canFetchMore(const QModelIndex &parent) const {
+    const Node *n = node(parent);
+    return !n->listed || !n->pending.isEmpty();
+}
+//!
+//! \brief WorldTreeModel::fetchMore makes the next batch of children into nodes
+//! \param parent
+//!
+void WorldTreeModel::fetchMore(const QModelIndex &parent) {
+    Node *n = node(parent);
+    if(!n->listed)
+        list(n);
+    const int count = qMin(n->pending.size(), TREE_FETCH_BATCH);
+    if(count == 0)
+        return;
+
+    const int first = n->children.size();
+    beginInsertRows(parent, first, first + count - 1);
+    n->children.reserve(first + count);
+    for(int i = 0; i < count; i++) {
+        NodeRef ref = n->pending.takeLast();
+        n->children.append(new Node(ref.first, ref.second, n, first + i));
+    }
+    endInsertRows();
+}
+//!
+//! \brief WorldTreeModel::data
+//! \param index
+//! \param role
+//! \return
+//!
+QVariant WorldTreeModel::data(const QModelIndex &index, int role) const {
+    if(!index.isValid())
+        return QVariant();
+    const Node *n = node(index);
+
+    if(role == KindRole)
+        return n->kind;
+    if(role == HandleRole)
+        return n->kind == SOLID_NODE ? n->ref : -1;
+    if(role == Qt::DecorationRole && n->kind == VISGROUP_NODE)
+        return m_map->m_visgroups.at(n->ref).color;
+    if(role != Qt::DisplayRole)
+        return QVariant();
+
+    switch(n->kind) {
+    case WORLD_NODE:
+        return tr("worldspawn");
+    case VISGROUP_LIST_NODE:
+        return tr("Visgroups");
+    case VISGROUP_NODE:
+        return m_map->m_visgroups.at(n->ref).name;
+    case GROUP_NODE:
+        return tr("group %1").arg(m_map->m_groups.at(n->ref).id);
+    case ENTITY_NODE: {
+        const Map::s_entity &entity = m_map->m_entities.at(n->ref);
+        if(entity.targetname.isEmpty())
+            return entity.classname;
+        return QString("%1 (%2)").arg(entity.classname, entity.targetname);
+    }
+    case SOLID_NODE: {
+        Map::s_solid info = solidInfo(n->ref);
+        return tr("solid %1").arg(info.id ? info.id : n->ref);
+    }
+    default:
+        return QVariant();
+    }
+}
+//!
+//! \brief WorldTreeModel::nodeCount
+//! \return how many nodes have been made, not counting the root
+//!
+int WorldTreeModel::nodeCount() const {
+    int count = 0;
+    QList<const Node *> stack;
+    stack.append(m_root);
+    while(!stack.isEmpty()) {
+        const Node *n = stack.takeLast();
+        count += n->children.size();
+        foreach(const Node *child, n->children)
+            stack.append(child);
+    }
+    return count;
+}
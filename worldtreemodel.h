@@ -0,0 +1,99 @@
+/*
+This file is part of World Editor.
+
+World Editor is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+World Editor is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with World Editor.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef WORLDTREEMODEL_H
+#define WORLDTREEMODEL_H
+
+#include <QAbstractItemModel>
+#include <QVector>
+#include <QPair>
+#include "map.h"
+
+//! Children made into nodes by each fetchMore
+#define TREE_FETCH_BATCH 512
+
+//!
+//! \brief The WorldTreeModel class shows the map as a tree
+//! The world holds its groups, entities and brushes, groups hold what was
+//! grouped into them, brush entities hold their brushes, and the visgroups
+//! branch holds every visgroup with what is in it. Nothing under a branch
+//! is looked at until a view asks for it through canFetchMore/fetchMore,
+//! and then only TREE_FETCH_BATCH children at a time.
+//!
+class WorldTreeModel : public QAbstractItemModel
+{
+    Q_OBJECT
+public:
+    enum NodeKind {
+        ROOT_NODE,
+        WORLD_NODE,
+        VISGROUP_LIST_NODE,
+        VISGROUP_NODE,      //! ref is an index in Map::m_visgroups
+        GROUP_NODE,         //! ref is an index in Map::m_groups
+        ENTITY_NODE,        //! ref is an index in Map::m_entities
+        SOLID_NODE,         //! ref is a BrushHandle
+    };
+    enum WorldTreeRoles {
+        KindRole = Qt::UserRole + 1,
+        HandleRole,
+    };
+
+private:
+    typedef QPair<NodeKind, int> NodeRef;
+    struct Node {
+        Node(NodeKind kind, int ref, Node *parent, int row);
+        ~Node();
+        NodeKind kind;
+        int ref;
+        Node *parent;
+        int row;                    //! Row under the parent
+        bool listed;                //! pending has been worked out
+        QVector<NodeRef> pending;   //! Children not made into nodes yet
+        QVector<Node *> children;
+    };
+
+    Map *m_map;
+    Node *m_root;
+
+    Node *node(const QModelIndex &index) const;
+    QModelIndex indexOf(Node *node) const;
+    QList<Node *> madeNodes() const;
+    void list(Node *node) const;
+    bool mayHaveChildren(const Node *node) const;
+    bool holdsSolid(const Node *node, BrushHandle handle) const;
+    Map::s_solid solidInfo(BrushHandle handle) const;
+
+public:
+    WorldTreeModel(Map *map, QObject *parent = 0);
+    ~WorldTreeModel();
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const;
+    QModelIndex parent(const QModelIndex &index) const;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const;
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const;
+    bool canFetchMore(const QModelIndex &parent) const;
+    void fetchMore(const QModelIndex &parent);
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    int nodeCount() const;
+
+public slots:
+    void rebuild();
+    void addSolidRows(const QModelIndex &parent, int first, int last);
+    void removeSolidNodes();
+};
+
+#endif // WORLDTREEMODEL_H